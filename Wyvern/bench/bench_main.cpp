@@ -0,0 +1,65 @@
+#include <iostream>
+#include <stdexcept>
+#include <cstdlib>
+
+#include "Wyvern/Application.h"
+#include "Wyvern/Benchmark/benchmark.h"
+
+/*
+* WyvernBench: runs a benchmark scene through the engine, or compares two benchmark reports.
+*
+*     WyvernBench --benchmark bench/scenes/orbit.bench [--headless] [--frames <n>] [--report <file.json>]
+*     WyvernBench --compare <baseline.json> <current.json> [--threshold <percent>]
+*
+* --compare exits with 1 if any metric regressed, so it can gate CI runs.
+*/
+
+static int compareReports(int argc, char** argv)
+{
+    if (argc < 4) {
+        std::cerr << "Usage: WyvernBench --compare <baseline.json> <current.json> [--threshold <percent>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    float threshold = Wyvern::Benchmark::DEFAULT_REGRESSION_THRESHOLD;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::strtof(argv[++i], nullptr);
+        }
+        else {
+            std::cerr << "Ignoring unknown argument: " << arg << std::endl;
+        }
+    }
+
+    try {
+        return Wyvern::Benchmark::compare(argv[2], argv[3], threshold, std::cout) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--compare") {
+        return compareReports(argc, argv);
+    }
+
+    Wyvern::ApplicationOptions options = Wyvern::ApplicationOptions::parse(argc, argv);
+    if (options.benchmarkPath.empty()) {
+        std::cerr << "Usage: WyvernBench --benchmark <scene> [--headless] [--frames <n>] [--report <file.json>]" << std::endl;
+        std::cerr << "       WyvernBench --compare <baseline.json> <current.json> [--threshold <percent>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        Wyvern::Application::create(options)->run();
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
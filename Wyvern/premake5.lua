@@ -1,4 +1,5 @@
-project "Wyvern"
+-- Settings shared by the engine and the benchmark runner. Both build the whole engine, WyvernBench just brings its own main()
+function wyvernProject()
     kind "ConsoleApp"
     language "C++"
     cppdialect "C++17"
@@ -51,22 +52,52 @@ project "Wyvern"
             "HLSLd.lib"
         }
 
+    -- Linux & other non Windows systems (e.g. headless CI with lavapipe) link the system's Vulkan loader, GLFW & shaderc
+    filter "system:not windows"
+        links {
+            "vulkan",
+            "glfw",
+            "shaderc_combined",
+            "pthread"
+        }
+
     filter "configurations:Debug"
         defines { "DEBUG" }
-        buildoptions "/MDd"
         runtime "Debug"
         symbols "On"
 
+    filter { "configurations:Debug", "system:windows" }
+        buildoptions "/MDd"
+
         links {
             "shaderc_combinedd.lib",
         }
     
     filter "configurations:Release"
         defines { "NDEBUG" }
-        buildoptions "/MT"
         runtime "Release"
         optimize "On"
 
+    filter { "configurations:Release", "system:windows" }
+        buildoptions "/MT"
+
         links {
             "shaderc_combined.lib",
-        }
\ No newline at end of file
+        }
+
+    filter {}
+end
+
+project "Wyvern"
+    wyvernProject()
+
+-- Deterministic frame benchmarks & report comparison, see bench/bench_main.cpp
+project "WyvernBench"
+    wyvernProject()
+
+    defines { "WYVERN_NO_ENTRY_POINT" }
+
+    files {
+        "bench/**.cpp",
+        "bench/**.h",
+    }
@@ -1,17 +1,53 @@
  #include <vector>
 #include <functional>
+#include <fstream>
 
 #include "Application.h"
+// The benchmark runner (WyvernBench) brings its own main()
+#ifndef WYVERN_NO_ENTRY_POINT
 #include "entry_point.h"
+#endif
 
 #include "Renderer/API/Vulkan/Geometry/vertex_geometry.h"
 #include "Renderer/API/Vulkan/Memory/buffer.h"
 #include "Wyvern/Input/input.h"
-#include "Scene.h"
+#include "scene.h"
 
 namespace Wyvern {
 
-Application::Application()
+ApplicationOptions ApplicationOptions::parse(int argc, char** argv)
+{
+	// The logger doesn't exist yet, so problems go straight to stderr
+	ApplicationOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless") {
+			options.headless = true;
+		}
+		else if (arg == "--frames" && i + 1 < argc) {
+			options.frameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--capture" && i + 1 < argc) {
+			options.capturePath = argv[++i];
+		}
+		else if (arg == "--benchmark" && i + 1 < argc) {
+			options.benchmarkPath = argv[++i];
+		}
+		else if (arg == "--report" && i + 1 < argc) {
+			options.reportPath = argv[++i];
+		}
+		else if (arg == "--record" && i + 1 < argc) {
+			options.recordPath = argv[++i];
+		}
+		else {
+			std::cerr << "Ignoring unknown argument: " << arg << std::endl;
+		}
+	}
+	return options;
+}
+
+Application::Application(const ApplicationOptions& options)
+	: m_options(options)
 {
 	// Initializes the Wyvern console logger for manual logging and the
 	// Renderer logger for Vulkan validation layer logging
@@ -19,16 +55,28 @@ Application::Application()
 	m_logger->init();
 
 	// Window
-	m_window = std::make_unique<Window>("Wyvern App");
+	m_window = std::make_unique<Window>("Wyvern App", m_options.headless);
 	m_window->initCallbacks(BIND_INTERNAL_EVENT(Application::onEvent));
 
-	// Renderer using Vulkan
-	m_renderer = std::make_unique<WYVKRenderer>(*m_window);
+	// Renderer using Vulkan. One recording slot per worker thread plus one for the main thread
+	m_threadPool = std::make_unique<ThreadPool>();
+	m_renderer = std::make_unique<WYVKRenderer>(*m_window, m_threadPool->getThreadCount() + 1, m_threadPool.get(), ImGuiHandler::SUPPORTS_DYNAMIC_RENDERING);
 	m_renderer->initRenderAPI();
+	if (m_renderer->isHeadless() && !m_options.capturePath.empty()) {
+		m_renderer->getReadbackRing()->setCallback([this](const WYVKReadbackRing::Frame& frame) {
+			const uint8_t* pixels = static_cast<const uint8_t*>(frame.data);
+			m_capture.assign(pixels, pixels + frame.size);
+			m_captureExtent = frame.extent;
+		});
+	}
 
 	// GUI & Debug stuff from ImGui
 	m_imGuiHandler = std::make_unique<ImGuiHandler>(*m_window, *m_renderer);
 
+	if (!m_options.benchmarkPath.empty()) {
+		initBenchmark();
+	}
+
 
 	// Input Handling. My philosophy on the function pointers bound to keys is that they should always have no params.
 	// This is because a single key press is none other than a key press. There is no other data associated it like with
@@ -85,37 +133,132 @@ void Application::drawFrame(std::vector<Model>& models, bool drawIndexed, void*
 
 	m_renderer->beginFrameRecording(m_currentFrame, currentImage);
 
-	m_renderer->setupGraphicsPipeline(m_currentFrame);         
-	m_renderer->bindPipeline(m_currentFrame);
-
-	m_renderer->updateUniformBuffers(currentImage, uniformData, uniformSize);
-
-	for (Model& model : models) {
-		
+	m_renderer->updateUniformBuffers(m_currentFrame, uniformData, uniformSize);
+
+	std::vector<VkCommandBuffer> secondaries;
+	if (m_useIndirectDraws && drawIndexed) {
+		// Every model becomes one indirect command. They all live in the geometry arena, so the whole list is a single indirect draw
+		WYVKIndirectBatch& batch = m_renderer->getIndirectBatch(m_currentFrame);
+		WYVKGeometryArena& arena = m_renderer->getGeometryArena();
+		batch.reset();
+		for (Model& model : models) {
+			WYVKIndirectBatch::DrawData drawData{ model.getTransform() };
+			batch.addDraw(arena.getVertexBuffer().getBuffer(), arena.getIndexBuffer().getBuffer(), WYVKGeometryArena::INDEX_TYPE,
+				static_cast<uint32_t>(model.getIndexCount()), model.getFirstIndex(), model.getVertexOffset(), drawData);
+		}
 
-		m_renderer->bindVertexBuffers(m_currentFrame, static_cast<uint32_t>(model.getVertexBuffersCount()), model.getVertexBuffer());
-		m_renderer->bindIndexBuffer(m_currentFrame, *model.getIndexBuffer(), VK_INDEX_TYPE_UINT16);
-		m_renderer->bindDescriptorSets(m_currentFrame);
+		WYVKCommandBuffer& modelCmdBuffer = m_renderer->beginSecondaryRecording(m_currentFrame, m_renderer->getMainThreadSlot());
+		m_renderer->drawIndirect(*modelCmdBuffer.getCommandBuffer(), m_currentFrame);
+		m_renderer->endSecondaryRecording(modelCmdBuffer);
+		m_indirectDrawCount = batch.getDrawCount();
+		m_indirectCallCount = batch.getRecordedCallCount();
+		secondaries.push_back(*modelCmdBuffer.getCommandBuffer());
+	}
+	else {
+		// The model list is split into chunks that are recorded into secondary command buffers by the worker threads.
+		// The geometry arena is already bound in every chunk
+		secondaries = m_renderer->recordParallel(m_currentFrame, *m_threadPool, static_cast<uint32_t>(models.size()),
+			[&](VkCommandBuffer cmd, uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; i++) {
+					Model& model = models[i];
+					m_renderer->bindObject(cmd, m_currentFrame, model.getTransform());
+					if (drawIndexed) {
+						m_renderer->drawIndexed(cmd, static_cast<uint32_t>(model.getIndexCount()), 1, model.getFirstIndex(), model.getVertexOffset(), 0);
+					}
+					else {
+						m_renderer->draw(cmd, static_cast<uint32_t>(model.getVertexCount()), 1, static_cast<uint32_t>(model.getVertexOffset()), 0);
+					}
+				}
+			});
+	}
 
-		if (drawIndexed) {
-			m_renderer->drawIndexed(m_currentFrame, static_cast<uint32_t>(model.getIndexCount()), 1, 0, 0, 0);
-		}
-		else {
-			m_renderer->draw(m_currentFrame, static_cast<uint32_t>(model.getVertexSize()), 1, 0, 0);
-		}
+	if (!m_instances.empty() && !models.empty()) {
+		WYVKCommandBuffer& instancedCmdBuffer = m_renderer->beginSecondaryRecording(m_currentFrame, m_renderer->getMainThreadSlot());
+		m_renderer->drawInstanced(*instancedCmdBuffer.getCommandBuffer(), m_currentFrame, models[0], m_instances);
+		m_renderer->endSecondaryRecording(instancedCmdBuffer);
+		secondaries.push_back(*instancedCmdBuffer.getCommandBuffer());
 	}
 
-	m_imGuiHandler->renderFrame(*m_renderer->getFrameContext(m_currentFrame).commandBuffer);
+	// ImGui gets its own secondary on the main thread's slot in the overlay pass, so it draws on top
+	WYVKCommandBuffer& imguiCmdBuffer = m_renderer->beginSecondaryRecording(m_currentFrame, m_renderer->getMainThreadSlot(), WYVKRenderer::FramePass::OVERLAY);
+	m_imGuiHandler->renderFrame(imguiCmdBuffer);
+	m_renderer->endSecondaryRecording(imguiCmdBuffer);
+
+	m_renderer->executeSecondaryCommandBuffers(m_currentFrame, secondaries);
+	m_renderer->executeSecondaryCommandBuffers(m_currentFrame, { *imguiCmdBuffer.getCommandBuffer() }, WYVKRenderer::FramePass::OVERLAY);
 	m_renderer->endFrameRecording(m_currentFrame);
 
 
 	m_renderer->submitCommandBuffer(m_currentFrame);
 	m_renderer->present(m_currentFrame, currentImage);
-	m_currentFrame = (m_currentFrame + 1) % WYVKRenderer::MAX_FRAMES_IN_FLIGHT;
+	m_currentFrame = (m_currentFrame + 1) % m_renderer->getFramesInFlight();
 
 }
 
 
+void Application::buildInstanceGrid(uint32_t count)
+{
+	// Lays the instances out on a square grid in the XZ plane, colored by their position in it
+	uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+	m_instances.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t x = i % side;
+		uint32_t z = i / side;
+		m_instances[i].transform = glm::translate(glm::mat4(1.0f), glm::vec3(x * 2.0f, -3.0f, z * 2.0f));
+		m_instances[i].color = glm::vec4(static_cast<float>(x) / side, 1.0f, static_cast<float>(z) / side, 1.0f);
+	}
+}
+
+void Application::initBenchmark()
+{
+	Benchmark::Description description = Benchmark::Description::load(m_options.benchmarkPath);
+	if (m_options.frameCount != 0) {
+		description.frameCount = m_options.frameCount;
+	}
+
+	// The scene's settings replace what the panels would otherwise start with
+	m_useIndirectDraws = description.indirectDraws;
+	m_instanceCount = static_cast<int>(description.instanceCount);
+	buildInstanceGrid(description.instanceCount);
+	if (description.framesInFlight != 0) {
+		m_renderer->setFramesInFlight(description.framesInFlight);
+		m_framesInFlight = static_cast<int>(m_renderer->getFramesInFlight());
+	}
+
+	WYVERN_LOG_INFO("Benchmark {}: {} frames after {} warmup frames, {:.4f} s timestep", description.name, description.frameCount,
+		description.warmupFrames, description.timestep);
+	m_benchmark = std::make_unique<Benchmark>(description);
+	m_renderer->getFramePacer().setFrameCallback([this](const WYVKFramePacer::FrameTiming& timing) {
+		m_benchmark->frameTimed(timing);
+	});
+}
+
+void Application::recordCamera()
+{
+	float time = m_recordTime;
+	m_recordTime += m_window->deltaTime();
+	if (!m_cameraRecording.empty() && time - m_cameraRecording.getDuration() < CAMERA_RECORD_INTERVAL) {
+		return;
+	}
+
+	Transform& transform = m_scene->getPlayer().getTransform();
+	m_cameraRecording.addKeyframe({ time, transform.getPosition(), *transform.getPitchAngle(), *transform.getYawAngle() });
+}
+
+void Application::updatePipelineVariant()
+{
+	WYVKGraphicsPipeline::PipelineState state;
+	if (m_wireframe) {
+		state.polygonMode = VK_POLYGON_MODE_LINE;
+		state.cullMode = VK_CULL_MODE_NONE;
+	}
+	// Both color modes share the same SPIR-V, only the specialization constant differs
+	std::vector<WYVKGraphicsPipeline::SpecializationConstant> constants;
+	if (m_depthView) {
+		constants.push_back({ 0, 1 }); // COLOR_MODE in fragment.frag
+	}
+	m_renderer->setPipelineVariant(state, constants);
+}
 
 void Application::mainLoop()
 {
@@ -161,16 +304,31 @@ void Application::mainLoop()
 			12, 13, 14, 14, 15, 12
 		};
 
-		// One time allocation of staging buffer. The staging buffer is used to transfer vertex data from memory to the gpu memory.
-		m_renderer->allocateStagingBuffer(sizeof(vertices[0]) * vertices.size());
-
 		std::vector<Model> models;
 		models.emplace_back(*m_renderer, vertices, indices);
 
 		while (!m_window->shouldClose()) {
+			// Frame limiter & low latency pacing. Input is sampled right after, so the frame's latency is measured from here
+			m_renderer->paceFrame();
 			m_window->pollEvents();
 			m_window->updateDeltaTime();
-			m_scene->update(m_window->deltaTime());
+			if (m_benchmark) {
+				// The camera follows the benchmark's path with a fixed timestep instead of input, so every run renders the same frames
+				m_benchmark->update(m_scene->getPlayer().getTransform());
+				m_scene->getMainCamera().updateTransformFromTarget();
+			}
+			else {
+				m_scene->update(m_window->deltaTime());
+			}
+			if (!m_options.recordPath.empty()) {
+				recordCamera();
+			}
+
+			// Nothing can be presented while minimized. The scene keeps updating, but the loop sleeps until an event arrives or the next update is due
+			if (m_window->isMinimized()) {
+				m_window->waitEvents(MINIMIZED_UPDATE_INTERVAL);
+				continue;
+			}
 			// == ImGui ==
 			m_imGuiHandler->newFrame();
 			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -179,38 +337,204 @@ void Application::mainLoop()
 			glm::vec3& front = m_scene->getPlayer().getTransform().getFront();
 			ImGui::Text("Front: [%.1f,%.1f,%.1f]", front.x, front.y, front.z);
 
-			//ImGui::Text("Draw Time: %.3f ms/frame (%.2f FPS)", m_frameTime / 1000000.0f, 1000000000.0f / m_frameTime);
+			ImGui::Checkbox("Indirect draws", &m_useIndirectDraws);
+			if (m_useIndirectDraws) {
+				ImGui::Text("Indirect: %u draws in %u calls", m_indirectDrawCount, m_indirectCallCount);
+			}
+			else {
+				bool variantChanged = ImGui::Checkbox("Wireframe", &m_wireframe);
+				variantChanged |= ImGui::Checkbox("Depth view", &m_depthView);
+				if (variantChanged) {
+					updatePipelineVariant();
+				}
+				if (m_renderer->isBindlessSupported()) {
+					if (ImGui::Checkbox("Bindless", &m_bindless)) {
+						m_renderer->setBindless(m_bindless);
+					}
+				}
+				else {
+					ImGui::TextDisabled("Bindless: no descriptor indexing support");
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Pipeline Variants")) {
+				for (const WYVKPipelineRegistry::UsageInfo& usage : m_renderer->getPipelineRegistry().getUsage()) {
+					ImGui::Text("%s | %s | used %llu times, last in frame %llu", usage.key->vertexShaderPath.filename().string().c_str(),
+						usage.ready ? "ready" : "building", (unsigned long long) usage.useCount, (unsigned long long) usage.lastUsedFrame);
+				}
+			}
+
+			// Shader hot reload errors stay on screen until the shader compiles again
+			if (!m_renderer->getShaderErrors().empty()) {
+				ImGui::Begin("Shader Errors");
+				for (const auto& error : m_renderer->getShaderErrors()) {
+					ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.35f, 1.0f), "%s", error.first.c_str());
+					ImGui::TextWrapped("%s", error.second.c_str());
+				}
+				ImGui::End();
+			}
+
+			// Capped by WYVKRenderer::INSTANCE_ARENA_CAPACITY
+			if (ImGui::SliderInt("Instances", &m_instanceCount, 0, 100000)) {
+				buildInstanceGrid(static_cast<uint32_t>(m_instanceCount));
+			}
+
+			if (ImGui::CollapsingHeader("Device Memory")) {
+				for (const WYVKAllocator::HeapStatistics& heap : m_renderer->getDevice().getAllocator().getHeapStatistics()) {
+					ImGui::Text("Heap %u: %u blocks | %u allocs | %.2f / %.2f MB | %.1f%% fragmented",
+						heap.heapIndex, heap.blockCount, heap.allocationCount,
+						heap.usedBytes / (1024.0 * 1024.0), heap.blockBytes / (1024.0 * 1024.0), heap.fragmentation * 100.0f);
+				}
+
+				WYVKGeometryArena& arena = m_renderer->getGeometryArena();
+				ImGui::Text("Geometry arena: %u meshes | %u / %u vertices | %u / %u indices | %.1f%% fragmented",
+					arena.getMeshCount(), arena.getUsedVertices(), arena.getVertexCapacity(), arena.getUsedIndices(), arena.getIndexCapacity(),
+					arena.getFragmentation() * 100.0f);
+				if (ImGui::Button("Defragment geometry")) {
+					m_renderer->defragmentGeometry();
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Descriptors")) {
+				WYVKDescriptorAllocator::Statistics descriptors = m_renderer->getDescriptorAllocator().getStatistics(m_currentFrame);
+				ImGui::Text("Frame %u: %u sets allocated | %u cache hits | %u / %u pools | %u pool growths",
+					m_currentFrame, descriptors.allocations, descriptors.cacheHits, descriptors.poolsUsed, descriptors.poolCount, descriptors.poolGrowths);
+				if (ImGui::Button("Benchmark descriptor updates")) {
+					m_descriptorBenchmark = m_renderer->benchmarkDescriptorUpdates();
+				}
+				for (const WYVKDescriptorBenchmark::Result& result : m_descriptorBenchmark) {
+					ImGui::Text("%s: %.3f ms | %.3f us/set | %u calls", result.method.c_str(), result.totalMs, result.usPerSet, result.driverCalls);
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Render Graph")) {
+				const WYVKRenderGraph::Statistics& graph = m_renderer->getRenderGraph().getStatistics();
+				ImGui::Text("%u passes (%u culled) | %u barriers | compiled %llu times", graph.passCount, graph.culledPassCount, graph.barrierCount,
+					(unsigned long long) graph.compileCount);
+				ImGui::Text("%u transient images in %u allocations | %.2f MB (%.2f MB without aliasing)", graph.transientImageCount, graph.memoryAllocationCount,
+					graph.allocatedBytes / (1024.0f * 1024.0f), graph.transientBytes / (1024.0f * 1024.0f));
+				if (ImGui::Button("Export render graph")) {
+					m_renderer->getRenderGraph().writeDot("render_graph.dot");
+				}
+			}
+
+			if (ImGui::CollapsingHeader("Frame Pacing")) {
+				WYVKSwapchain& swapchain = m_renderer->getSwapchain();
+				if (ImGui::BeginCombo("Present mode", WYVKSwapchain::getPresentModeName(swapchain.getPresentMode()))) {
+					for (VkPresentModeKHR presentMode : PRESENT_MODES) {
+						ImGuiSelectableFlags flags = swapchain.isPresentModeSupported(presentMode) ? 0 : ImGuiSelectableFlags_Disabled;
+						if (ImGui::Selectable(WYVKSwapchain::getPresentModeName(presentMode), presentMode == swapchain.getPresentMode(), flags)) {
+							m_renderer->setPresentMode(presentMode);
+						}
+					}
+					ImGui::EndCombo();
+				}
+				if (ImGui::SliderInt("Frames in flight", &m_framesInFlight, 1, WYVKRenderer::MAX_FRAMES_IN_FLIGHT)) {
+					m_renderer->setFramesInFlight(static_cast<uint32_t>(m_framesInFlight));
+				}
+
+				WYVKFramePacer& pacer = m_renderer->getFramePacer();
+				if (ImGui::Checkbox("Low latency", &m_lowLatency)) {
+					pacer.setMode(m_lowLatency ? WYVKFramePacer::Mode::LOW_LATENCY : WYVKFramePacer::Mode::THROUGHPUT);
+				}
+				if (ImGui::SliderFloat("Frame limit", &m_frameLimit, 0.0f, 480.0f, m_frameLimit > 0.0f ? "%.0f FPS" : "Off")) {
+					pacer.setFrameLimit(m_frameLimit);
+				}
+
+				const WYVKFramePacer::Statistics& pacing = pacer.getStatistics();
+				ImGui::Text("CPU %.2f ms | GPU %.2f ms%s | held back %.2f ms", pacing.cpuFrameMs, pacing.gpuFrameMs,
+					pacer.hasGpuTimings() ? "" : " (no timestamps)", pacing.sleepMs);
+				ImGui::Text("Input to GPU done: %.2f ms (average %.2f ms)", pacing.latencyMs, pacing.averageLatencyMs);
+			}
+
+			//ImGui::Text("Draw Time:%.3f ms/frame (%.2f FPS)", m_frameTime / 1000000.0f, 1000000000.0f / m_frameTime);
 
 			//m_imGuiHandler->createFrameDataPlot(1000.0f / ImGui::GetIO().Framerate);
 			// =========== 
 			// Update Camera
-			WYVKRenderer::CameraMVPBuffer ubo{};
+			WYVKRenderer::CameraBuffer ubo{};
 			static auto startTime = std::chrono::high_resolution_clock::now();
 			auto currentTime = std::chrono::high_resolution_clock::now();
 			float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-			ubo.model = glm::mat4(1);
-			//ubo.model = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+			// Model matrices are per object now (see Model::getTransform())
+			//models[0].getTransform() = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 			//ubo.view = glm::lookAt(glm::vec3(-2.0f, -2.0f, -2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
 			//ubo.proj = glm::perspective(glm::radians(45.0f), m_renderer->getSwapchain().getExtent().width / (float)m_renderer->getSwapchain().getExtent().height, 0.1f, 10.0f);
 			ubo.view = m_scene->getMainCamera().getViewMatrix();
 			ubo.proj = m_scene->getMainCamera().getProjectionMatrix();
+			ubo.viewProj = ubo.proj * ubo.view;
 			// Render Frame (Includes ImGui rendering)
 			
 			drawFrame(models, true, (void*)&ubo, sizeof(ubo)); // Uses the render API to draw a single frame
 			//stop = std::chrono::high_resolution_clock::now();
 			//m_frameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
 
+			if (m_benchmark) {
+				m_benchmark->frameFinished(m_renderer->getFrameSerial());
+				if (m_benchmark->isDone()) {
+					m_window->requestClose();
+				}
+			}
+			else if (m_options.frameCount != 0 && ++m_framesDrawn >= m_options.frameCount) {
+				m_window->requestClose();
+			}
 		}
 		// Wait for the physical device (GPU) to be idle (Not working on anything) before we quit
-		VK_CALL(vkDeviceWaitIdle(m_renderer->getDevice().getLogicalDevice()), "DeviceWaitIdle Failed!");
+		{
+			std::lock_guard<std::mutex> lock(m_renderer->getDevice().getQueueMutex());
+			VK_CALL(vkDeviceWaitIdle(m_renderer->getDevice().getLogicalDevice()), "DeviceWaitIdle Failed!");
+		}
+		if (m_renderer->isHeadless()) {
+			m_renderer->getReadbackRing()->collect(UINT64_MAX);
+			WYVERN_LOG_INFO("Read back {} frames ({} stalls)", m_renderer->getReadbackRing()->getStatistics().framesRead,
+				m_renderer->getReadbackRing()->getStatistics().stalls);
+			writeCapture();
+		}
+		if (m_benchmark) {
+			// The device is idle, so every frame still in flight can be measured
+			m_renderer->getFramePacer().frameCompleted(UINT64_MAX);
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(m_renderer->getDevice().getPhysicalDevice(), &properties);
+			m_benchmark->writeReport(m_options.reportPath, properties.deviceName, m_renderer->isHeadless());
+		}
+		if (!m_options.recordPath.empty()) {
+			m_cameraRecording.save(m_options.recordPath);
+			WYVERN_LOG_INFO("Recorded {} camera keyframes to {}", m_cameraRecording.getKeyframes().size(), m_options.recordPath);
+		}
+	}
+}
+
+void Application::writeCapture()
+{
+	if (m_options.capturePath.empty() || m_capture.empty()) {
+		return;
+	}
+
+	// Binary PPM. The offscreen images are BGRA (WYVKSwapchain::OFFSCREEN_FORMAT)
+	std::ofstream file(m_options.capturePath, std::ios::binary);
+	if (!file) {
+		WYVERN_LOG_ERROR("Unable to write capture to {}", m_options.capturePath);
+		return;
+	}
+	file << "P6\n" << m_captureExtent.width << " " << m_captureExtent.height << "\n255\n";
+	std::vector<uint8_t> row(m_captureExtent.width * 3);
+	for (uint32_t y = 0; y < m_captureExtent.height; y++) {
+		const uint8_t* src = m_capture.data() + static_cast<size_t>(y) * m_captureExtent.width * WYVKReadbackRing::BYTES_PER_PIXEL;
+		for (uint32_t x = 0; x < m_captureExtent.width; x++) {
+			row[x * 3 + 0] = src[x * 4 + 2];
+			row[x * 3 + 1] = src[x * 4 + 1];
+			row[x * 3 + 2] = src[x * 4 + 0];
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), row.size());
 	}
+	WYVERN_LOG_INFO("Wrote {}x{} capture to {}", m_captureExtent.width, m_captureExtent.height, m_options.capturePath);
 }
 
 
-Application* createApplication()
+Application* createApplication(int argc, char** argv)
 {
-	return Application::get();
+	return Application::create(ApplicationOptions::parse(argc, argv));
 }
 
 }
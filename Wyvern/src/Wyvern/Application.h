@@ -10,6 +10,8 @@
 #include "Renderer/API/Vulkan/Geometry/Model.h"
 #include "Wyvern/GUI/imguihandler.h"
 #include "Wyvern/Events/event.h"
+#include "Wyvern/Threading/thread_pool.h"
+#include "Wyvern/Benchmark/benchmark.h"
 
 #include "Entity/player.h"
 #include "scene.h"
@@ -26,10 +28,22 @@ namespace Wyvern {
 static const uint32_t WINDOW_WIDTH = 1920;
 static const uint32_t WINDOW_HEIGHT = 1080;
 
+// Parsed from the command line by createApplication()
+struct ApplicationOptions {
+    bool headless = false;          // --headless: render offscreen without a window or display server, e.g. on servers & CI
+    uint32_t frameCount = 0;        // --frames <n>: quit after n frames. 0 runs until the window is closed
+    std::string capturePath;        // --capture <file.ppm>: headless only, writes the last frame read back on exit
+    std::string benchmarkPath;      // --benchmark <scene>: runs a Benchmark scene instead of taking input. --frames overrides its frame count
+    std::string reportPath = "benchmark.json"; // --report <file.json>: where the benchmark report is written
+    std::string recordPath;         // --record <file>: records the camera as a CameraPath, e.g. to replay it as a benchmark
+
+    static ApplicationOptions parse(int argc, char** argv);
+};
+
 class Application
 {
 public:
-    Application();
+    Application(const ApplicationOptions& options = {});
     ~Application();
         
     void run();
@@ -38,6 +52,12 @@ public:
     void drawFrame(std::vector<Model>& models, bool drawIndexed, void* uniformData, size_t uniformSize);
     Window& getWindow() { return *m_window; }
 
+    // Creates the application with non default options. Must be called before the first get()
+    static Application* create(const ApplicationOptions& options) {
+        s_Instance = new Application(options);
+        return s_Instance;
+    }
+
     static Application* get() { 
         if (!s_Instance) {
             s_Instance = new Application();
@@ -46,14 +66,63 @@ public:
     };
 
 private:
+    // How often the scene is updated while the window is minimized and nothing is rendered (seconds)
+    static constexpr double MINIMIZED_UPDATE_INTERVAL = 1.0 / 60.0;
+
     uint32_t m_currentFrame = 0;
 
     std::unique_ptr<Logger> m_logger;
     std::unique_ptr<Window> m_window;
+    std::unique_ptr<ThreadPool> m_threadPool; // Workers used to record command buffers in parallel
     std::unique_ptr<WYVKRenderer> m_renderer;
     std::unique_ptr<ImGuiHandler> m_imGuiHandler;
     std::unique_ptr<Scene> m_scene;
 
+    // Draw models through the frame's indirect batch instead of one drawIndexed per model
+    bool m_useIndirectDraws = true;
+    // Stats of the last recorded indirect batch. The UI is built before the frame is recorded, so it shows these
+    uint32_t m_indirectDrawCount = 0;
+    uint32_t m_indirectCallCount = 0;
+
+    // Pipeline variant used for per model draws (see WYVKRenderer::setPipelineVariant())
+    bool m_wireframe = false;
+    bool m_depthView = false;
+    // Per model draws index their transform through the bindless set instead of rebinding descriptor sets per model
+    bool m_bindless = false;
+    void updatePipelineVariant();
+
+    // Draws `m_instanceCount` copies of the first model in a grid with a single instanced draw
+    int m_instanceCount = 0;
+    std::vector<InstanceData> m_instances;
+    void buildInstanceGrid(uint32_t count);
+
+    // Frame Pacing panel
+    static constexpr VkPresentModeKHR PRESENT_MODES[] = {
+        VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR
+    };
+    int m_framesInFlight = WYVKRenderer::DEFAULT_FRAMES_IN_FLIGHT;
+    bool m_lowLatency = false;
+    float m_frameLimit = 0.0f;
+
+    // Last result of WYVKRenderer::benchmarkDescriptorUpdates(), shown in the Descriptors panel
+    std::vector<WYVKDescriptorBenchmark::Result> m_descriptorBenchmark;
+
+    ApplicationOptions m_options;
+    uint32_t m_framesDrawn = 0;
+    // Latest frame read back while headless, kept for --capture
+    std::vector<uint8_t> m_capture;
+    VkExtent2D m_captureExtent = { 0, 0 };
+    void writeCapture();
+
+    // Set with --benchmark. Drives the camera & decides when to quit instead of input
+    std::unique_ptr<Benchmark> m_benchmark;
+    void initBenchmark();
+    // Camera recorded with --record, one keyframe every CAMERA_RECORD_INTERVAL seconds
+    static constexpr float CAMERA_RECORD_INTERVAL = 1.0f / 30.0f;
+    CameraPath m_cameraRecording;
+    float m_recordTime = 0.0f;
+    void recordCamera();
+
     // Is the application running? Will be set to false on windowCloseEvent
     bool m_running = true;
     inline static Application* s_Instance;
@@ -62,7 +131,7 @@ private:
     void mainLoop();
 };
 
-    Application* createApplication();
+    Application* createApplication(int argc, char** argv);
 
 }
 
@@ -1,9 +1,18 @@
 #version 450
 
+// Specialization constant (see WYVKGraphicsPipeline::SpecializationConstant). 0 = vertex color, 1 = depth
+layout(constant_id = 0) const int COLOR_MODE = 0;
+
 layout(location = 0) in vec4 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = fragColor;
-}
\ No newline at end of file
+    if (COLOR_MODE == 1) {
+        // Depth is crammed close to 1 by the perspective projection, spread it out so the view is readable
+        outColor = vec4(vec3(pow(gl_FragCoord.z, 64.0)), 1.0);
+    }
+    else {
+        outColor = fragColor;
+    }
+}
@@ -1,11 +1,16 @@
 #version 450
 
-// Model view projection matrix
-layout(binding = 0) uniform CameraMVPBuffer {
-    mat4 model;
+// Camera matrices, updated once per frame
+layout(binding = 0) uniform CameraBuffer {
     mat4 view;
     mat4 proj;
-} ubo;
+    mat4 viewProj;
+} camera;
+
+// Per object data. The dynamic offset bound with the descriptor set selects the object
+layout(binding = 2) uniform ObjectBuffer {
+    mat4 model;
+} object;
 
 // Vertex attributes & location in vertex buffer
 layout(location = 0) in vec3 inPosition;
@@ -15,6 +20,6 @@ layout(location = 1) in vec3 inColor;
 layout(location = 0) out vec4 fragColor;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = camera.viewProj * object.model * vec4(inPosition, 1.0);
     fragColor = vec4(inColor, 1.0);
-}
\ No newline at end of file
+}
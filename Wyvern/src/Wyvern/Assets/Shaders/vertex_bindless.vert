@@ -0,0 +1,32 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Camera matrices, updated once per frame
+layout(binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+} camera;
+
+// Bindless storage buffer array (WYVKBindlessSet). Each frame context registers its object buffer in one slot
+layout(set = 1, binding = 0) readonly buffer ObjectBuffers {
+    mat4 models[];
+} objectBuffers[];
+
+// Per draw indices into the bindless arrays, pushed by WYVKRenderer::bindObject()
+layout(push_constant) uniform DrawIndices {
+    uint objectBuffer;
+    uint objectIndex;
+} draw;
+
+// Vertex attributes & location in vertex buffer
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// Output pixel color
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    gl_Position = camera.viewProj * objectBuffers[draw.objectBuffer].models[draw.objectIndex] * vec4(inPosition, 1.0);
+    fragColor = vec4(inColor, 1.0);
+}
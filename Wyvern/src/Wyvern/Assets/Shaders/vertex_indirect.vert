@@ -0,0 +1,30 @@
+#version 450
+
+// Camera matrices, updated once per frame
+layout(binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+} camera;
+
+// Per draw data written by WYVKIndirectBatch. Indexed with the firstInstance of the draw's indirect command
+struct DrawData {
+    mat4 model;
+};
+
+layout(std430, binding = 1) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+
+// Vertex attributes & location in vertex buffer
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// Output pixel color
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    // gl_InstanceIndex starts at firstInstance, which is the draw index for single instance draws
+    gl_Position = camera.viewProj * draws[gl_InstanceIndex].model * vec4(inPosition, 1.0);
+    fragColor = vec4(inColor, 1.0);
+}
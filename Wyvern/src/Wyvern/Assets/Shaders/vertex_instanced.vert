@@ -0,0 +1,24 @@
+#version 450
+
+// Camera matrices, updated once per frame
+layout(binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+} camera;
+
+// Vertex attributes & location in vertex buffer
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// Per instance attributes (vertex binding 1, advances once per instance). The mat4 takes locations 2 to 5
+layout(location = 2) in mat4 inInstanceTransform;
+layout(location = 6) in vec4 inInstanceColor;
+
+// Output pixel color
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    gl_Position = camera.viewProj * inInstanceTransform * vec4(inPosition, 1.0);
+    fragColor = vec4(inColor, 1.0) * inInstanceColor;
+}
@@ -0,0 +1,262 @@
+#include "benchmark.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <regex>
+#include <sstream>
+
+namespace Wyvern {
+
+static std::string escapeJson(const std::string& value)
+{
+	std::string escaped;
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+Benchmark::Description Benchmark::Description::load(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		WYVERN_THROW("Unable to open benchmark scene " + path.string());
+	}
+
+	Description description;
+	description.name = path.stem().string();
+	description.path = path;
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream stream(line);
+		std::string setting;
+		if (!(stream >> setting)) {
+			continue;
+		}
+
+		bool valid = true;
+		if (setting == "key") {
+			CameraPath::Keyframe keyframe;
+			valid = CameraPath::parseKeyframe(line, keyframe);
+			if (valid) {
+				description.cameraPath.addKeyframe(keyframe);
+			}
+		}
+		else if (setting == "name") {
+			valid = static_cast<bool>(stream >> description.name);
+		}
+		else if (setting == "frames") {
+			valid = static_cast<bool>(stream >> description.frameCount);
+		}
+		else if (setting == "warmup") {
+			valid = static_cast<bool>(stream >> description.warmupFrames);
+		}
+		else if (setting == "timestep") {
+			valid = static_cast<bool>(stream >> description.timestep) && description.timestep > 0.0f;
+		}
+		else if (setting == "instances") {
+			valid = static_cast<bool>(stream >> description.instanceCount);
+		}
+		else if (setting == "indirect") {
+			valid = static_cast<bool>(stream >> description.indirectDraws);
+		}
+		else if (setting == "frames_in_flight") {
+			valid = static_cast<bool>(stream >> description.framesInFlight);
+		}
+		else if (setting == "path") {
+			std::string cameraPath;
+			valid = static_cast<bool>(stream >> cameraPath);
+			if (valid) {
+				description.cameraPath.load(path.parent_path() / cameraPath);
+			}
+		}
+		else {
+			WYVERN_LOG_WARN("{}:{}: ignoring unknown setting '{}'", path.string(), lineNumber, setting);
+		}
+
+		if (!valid) {
+			WYVERN_LOG_ERROR("{}:{}: invalid '{}' setting", path.string(), lineNumber, setting);
+			WYVERN_THROW("Invalid benchmark scene " + path.string());
+		}
+	}
+
+	if (description.cameraPath.empty()) {
+		WYVERN_LOG_WARN("Benchmark scene {} has no camera keyframes, the camera stays where the scene puts it", path.string());
+	}
+	return description;
+}
+
+Benchmark::Benchmark(const Description& description)
+	: m_description(description)
+{
+	m_frameMs.reserve(description.frameCount);
+	m_cpuMs.reserve(description.frameCount);
+	m_gpuMs.reserve(description.frameCount);
+	m_latencyMs.reserve(description.frameCount);
+}
+
+void Benchmark::update(Transform& transform)
+{
+	if (!m_description.cameraPath.empty()) {
+		m_description.cameraPath.apply(transform, getTime());
+	}
+}
+
+void Benchmark::frameFinished(uint64_t serial)
+{
+	Clock::time_point now = Clock::now();
+	if (m_frame == m_description.warmupFrames) {
+		m_measureStart = now;
+	}
+	// The first measured frame time spans the last warmup frame, so a benchmark without warmup skips it
+	if (m_frame >= m_description.warmupFrames && m_frame > 0) {
+		if (m_firstMeasuredSerial == 0) {
+			m_firstMeasuredSerial = serial;
+		}
+		m_frameMs.push_back(std::chrono::duration<float, std::milli>(now - m_lastFrameEnd).count());
+	}
+	m_lastFrameEnd = now;
+	m_frame++;
+}
+
+void Benchmark::frameTimed(const WYVKFramePacer::FrameTiming& timing)
+{
+	if (m_firstMeasuredSerial == 0 || timing.serial < m_firstMeasuredSerial) {
+		return;
+	}
+	m_cpuMs.push_back(timing.cpuFrameMs);
+	if (timing.gpuFrameMs > 0.0f) {
+		m_gpuMs.push_back(timing.gpuFrameMs);
+	}
+	m_latencyMs.push_back(timing.latencyMs);
+}
+
+Benchmark::Summary Benchmark::summarize(std::vector<float> samples)
+{
+	Summary summary;
+	if (samples.empty()) {
+		return summary;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&](float p) {
+		size_t rank = static_cast<size_t>(std::ceil(p / 100.0f * samples.size()));
+		return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+	};
+
+	summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0f) / samples.size();
+	summary.p50 = percentile(50.0f);
+	summary.p95 = percentile(95.0f);
+	summary.p99 = percentile(99.0f);
+	summary.max = samples.back();
+	return summary;
+}
+
+void Benchmark::writeReport(const std::filesystem::path& path, const std::string& deviceName, bool headless) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		WYVERN_LOG_ERROR("Unable to write benchmark report to {}", path.string());
+		return;
+	}
+
+	float seconds = std::chrono::duration<float>(m_lastFrameEnd - m_measureStart).count();
+	file << std::fixed << std::setprecision(4);
+	file << "{\n";
+	file << "\t\"name\": \"" << escapeJson(m_description.name) << "\",\n";
+	file << "\t\"scene\": \"" << escapeJson(m_description.path.generic_string()) << "\",\n";
+	file << "\t\"device\": \"" << escapeJson(deviceName) << "\",\n";
+	file << "\t\"headless\": " << (headless ? "true" : "false") << ",\n";
+	file << "\t\"frames\": " << m_frameMs.size() << ",\n";
+	file << "\t\"warmup_frames\": " << m_description.warmupFrames << ",\n";
+	file << "\t\"timestep\": " << m_description.timestep << ",\n";
+	file << "\t\"instances\": " << m_description.instanceCount << ",\n";
+	file << "\t\"seconds\": " << seconds << ",\n";
+	file << "\t\"metrics\": {";
+
+	// Metrics without samples (GPU time without timestamp support) are left out
+	const std::pair<const char*, const std::vector<float>*> metrics[] = {
+		{ "frame_ms", &m_frameMs }, { "cpu_ms", &m_cpuMs }, { "gpu_ms", &m_gpuMs }, { "latency_ms", &m_latencyMs }
+	};
+	bool first = true;
+	for (const auto& metric : metrics) {
+		if (metric.second->empty()) {
+			continue;
+		}
+		Summary summary = summarize(*metric.second);
+		file << (first ? "\n" : ",\n");
+		file << "\t\t\"" << metric.first << "\": { \"mean\": " << summary.mean << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+			<< ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << " }";
+		first = false;
+	}
+	file << "\n\t}\n}\n";
+
+	WYVERN_LOG_INFO("Benchmark {}: {} frames in {:.2f} s, report written to {}", m_description.name, m_frameMs.size(), seconds, path.string());
+}
+
+std::map<std::string, float> Benchmark::readMetrics(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		WYVERN_THROW("Unable to open benchmark report " + path.string());
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	std::string json = contents.str();
+
+	// Only reads back what writeReport() writes: flat objects of numbers nested in "metrics"
+	static const std::regex metricPattern(R"#("(\w+)"\s*:\s*\{([^{}]*)\})#");
+	static const std::regex valuePattern(R"#("(\w+)"\s*:\s*(-?[0-9.]+(?:[eE][-+]?[0-9]+)?))#");
+
+	std::map<std::string, float> metrics;
+	for (auto metric = std::sregex_iterator(json.begin(), json.end(), metricPattern); metric != std::sregex_iterator(); ++metric) {
+		std::string name = (*metric)[1].str();
+		std::string values = (*metric)[2].str();
+		for (auto value = std::sregex_iterator(values.begin(), values.end(), valuePattern); value != std::sregex_iterator(); ++value) {
+			metrics[name + "." + (*value)[1].str()] = std::stof((*value)[2].str());
+		}
+	}
+	return metrics;
+}
+
+uint32_t Benchmark::compare(const std::filesystem::path& baseline, const std::filesystem::path& current, float thresholdPercent, std::ostream& out)
+{
+	std::map<std::string, float> before = readMetrics(baseline);
+	std::map<std::string, float> after = readMetrics(current);
+
+	uint32_t regressions = 0;
+	uint32_t missing = 0;
+	out << std::fixed << std::setprecision(3);
+	out << "Comparing " << current.string() << " against " << baseline.string() << " (threshold " << thresholdPercent << "%)\n";
+	for (const auto& metric : before) {
+		auto match = after.find(metric.first);
+		if (match == after.end()) {
+			// A metric that stopped being measured (e.g. broken timestamps) must not pass as "no slower"
+			out << std::left << std::setw(20) << metric.first << "missing  REGRESSION\n";
+			missing++;
+			continue;
+		}
+
+		float delta = match->second - metric.second;
+		float percent = metric.second > 0.0f ? delta / metric.second * 100.0f : 0.0f;
+		bool isMax = metric.first.size() > 4 && metric.first.compare(metric.first.size() - 4, 4, ".max") == 0;
+		bool regressed = !isMax && percent > thresholdPercent && delta > NOISE_FLOOR_MS;
+		regressions += regressed ? 1 : 0;
+
+		out << std::left << std::setw(20) << metric.first << std::right << std::setw(10) << metric.second << " -> " << std::setw(10) << match->second
+			<< std::setw(9) << std::showpos << percent << "%" << std::noshowpos << (regressed ? "  REGRESSION" : "") << "\n";
+	}
+	out << regressions << " regression(s), " << missing << " missing\n";
+	return regressions + missing;
+}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "Wyvern/Renderer/API/Vulkan/Sync/wyvk_frame_pacer.h"
+#include "camera_path.h"
+
+namespace Wyvern {
+
+/*
+* Deterministic frame benchmark. The scene is stepped with a fixed timestep and the camera follows a scripted or recorded
+* CameraPath instead of input, so every run renders the same frames and runs can be compared against each other.
+*
+* A benchmark scene is a text file with one setting per line, '#' starts a comment:
+*
+*     name orbit
+*     frames 600              Measured frames
+*     warmup 60               Frames rendered before measuring starts (pipeline builds, allocations, ...)
+*     timestep 0.0166667      Scene time per frame (seconds)
+*     instances 10000         Size of the instanced grid (see Application::buildInstanceGrid())
+*     indirect 1              Per model draws through the indirect batch
+*     frames_in_flight 2      0 keeps the renderer default
+*     path recorded.path      Loads keyframes from a camera path file, relative to the scene file
+*     key 0 0 1 -5 0 0        Camera keyframe (see CameraPath)
+*
+* Frame time (between frame ends) is measured when a frame is submitted. CPU time (input to submit), GPU time (timestamp queries) and
+* latency (input to GPU done) are measured by WYVKFramePacer and reported per frame serial once the frame is done on the GPU, so
+* every measured frame contributes exactly one sample of each. They are written as a JSON report with mean, p50, p95, p99 & max
+* per metric. compare() diffs two reports.
+*/
+class Benchmark
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Description {
+		std::string name;
+		std::filesystem::path path;
+		uint32_t frameCount = 600;
+		uint32_t warmupFrames = 60;
+		float timestep = 1.0f / 60.0f;
+		uint32_t instanceCount = 0;
+		bool indirectDraws = true;
+		uint32_t framesInFlight = 0;
+		CameraPath cameraPath;
+
+		/*
+		* Throws if the file can't be read or a setting can't be parsed
+		*/
+		static Description load(const std::filesystem::path& path);
+	};
+
+	struct Summary {
+		float mean = 0.0f;
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+	};
+
+	// A metric that gets slower by more than this (percent) is a regression
+	static constexpr float DEFAULT_REGRESSION_THRESHOLD = 5.0f;
+	// Differences below this (ms) are timer noise and never count as a regression
+	static constexpr float NOISE_FLOOR_MS = 0.05f;
+
+	Benchmark(const Description& description);
+
+	/*
+	* Moves `transform` to where the camera path is at the current frame
+	*/
+	void update(Transform& transform);
+
+	/*
+	* Records the frame time of the frame that was just submitted with `serial` & advances to the next one. Warmup frames are not recorded
+	*/
+	void frameFinished(uint64_t serial);
+
+	/*
+	* Records the pacer's measurements of a frame once it is done on the GPU (see WYVKFramePacer::setFrameCallback()). Frames
+	* submitted before measuring started are ignored. Frames still in flight have to be drained with
+	* WYVKFramePacer::frameCompleted() before writeReport()
+	*/
+	void frameTimed(const WYVKFramePacer::FrameTiming& timing);
+
+	inline bool isDone() const { return m_frame >= m_description.warmupFrames + m_description.frameCount; }
+	inline float getTime() const { return m_frame * m_description.timestep; }
+	inline float getTimestep() const { return m_description.timestep; }
+	inline const Description& getDescription() const { return m_description; }
+
+	/*
+	* Nearest rank percentiles of `samples`
+	*/
+	static Summary summarize(std::vector<float> samples);
+
+	void writeReport(const std::filesystem::path& path, const std::string& deviceName, bool headless) const;
+
+	/*
+	* Compares every metric statistic present in both reports and prints them to `out`. Returns how many got slower than
+	* `thresholdPercent` (max is printed but never counted, a single hitch is too noisy to fail on), plus how many statistics of
+	* `baseline` are missing from `current`
+	*/
+	static uint32_t compare(const std::filesystem::path& baseline, const std::filesystem::path& current, float thresholdPercent, std::ostream& out);
+
+private:
+	// "<metric>.<statistic>" -> value, e.g. "frame_ms.p95". Throws if the file can't be read
+	static std::map<std::string, float> readMetrics(const std::filesystem::path& path);
+
+	Description m_description;
+	uint32_t m_frame = 0;
+	Clock::time_point m_lastFrameEnd;
+	Clock::time_point m_measureStart;
+	uint64_t m_firstMeasuredSerial = 0;	// 0 until measuring starts
+
+	std::vector<float> m_frameMs;
+	std::vector<float> m_cpuMs;
+	std::vector<float> m_gpuMs;			// Empty without timestamp support
+	std::vector<float> m_latencyMs;
+};
+
+}
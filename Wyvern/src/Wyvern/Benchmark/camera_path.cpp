@@ -0,0 +1,101 @@
+#include "camera_path.h"
+#include <fstream>
+#include <sstream>
+
+namespace Wyvern {
+
+void CameraPath::addKeyframe(const Keyframe& keyframe)
+{
+	m_keyframes.push_back(keyframe);
+}
+
+CameraPath::Keyframe CameraPath::sample(float time) const
+{
+	if (m_keyframes.empty()) {
+		return Keyframe{};
+	}
+	if (time <= m_keyframes.front().time) {
+		return m_keyframes.front();
+	}
+	if (time >= m_keyframes.back().time) {
+		return m_keyframes.back();
+	}
+
+	auto next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+		[](float t, const Keyframe& keyframe) { return t < keyframe.time; });
+	const Keyframe& a = *(next - 1);
+	const Keyframe& b = *next;
+	float span = b.time - a.time;
+	float t = span > 0.0f ? (time - a.time) / span : 1.0f;
+
+	// Yaw wraps at 360 (see Transform::updateOrientation()), so it turns the short way around
+	float yawDelta = b.yaw - a.yaw;
+	if (yawDelta > 180.0f) {
+		yawDelta -= 360.0f;
+	}
+	else if (yawDelta < -180.0f) {
+		yawDelta += 360.0f;
+	}
+
+	Keyframe result;
+	result.time = time;
+	result.position = glm::mix(a.position, b.position, t);
+	result.pitch = a.pitch + (b.pitch - a.pitch) * t;
+	result.yaw = a.yaw + yawDelta * t;
+	return result;
+}
+
+void CameraPath::apply(Transform& transform, float time) const
+{
+	Keyframe keyframe = sample(time);
+	transform.setPosition(keyframe.position);
+	transform.setOrientation(keyframe.pitch, keyframe.yaw);
+}
+
+bool CameraPath::parseKeyframe(const std::string& line, Keyframe& outKeyframe)
+{
+	std::istringstream stream(line);
+	std::string keyword;
+	Keyframe keyframe;
+	if (!(stream >> keyword) || keyword != "key") {
+		return false;
+	}
+	if (!(stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.pitch >> keyframe.yaw)) {
+		return false;
+	}
+	outKeyframe = keyframe;
+	return true;
+}
+
+void CameraPath::load(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		WYVERN_THROW("Unable to open camera path " + path.string());
+	}
+
+	std::string line;
+	Keyframe keyframe;
+	while (std::getline(file, line)) {
+		if (parseKeyframe(line, keyframe)) {
+			addKeyframe(keyframe);
+		}
+	}
+}
+
+void CameraPath::save(const std::filesystem::path& path) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		WYVERN_LOG_ERROR("Unable to write camera path to {}", path.string());
+		return;
+	}
+
+	file << "# Wyvern camera path: key <time> <x> <y> <z> <pitch> <yaw>\n";
+	for (const Keyframe& keyframe : m_keyframes) {
+		file << "key " << keyframe.time << " " << keyframe.position.x << " " << keyframe.position.y << " " << keyframe.position.z
+			<< " " << keyframe.pitch << " " << keyframe.yaw << "\n";
+	}
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "Wyvern/Components/transform.h"
+
+namespace Wyvern {
+
+/*
+* Camera motion over time as a list of keyframes, sampled with linear interpolation. Scripted by hand in a benchmark scene or
+* recorded from a play session (see Application's --record), both use the same line format:
+*
+*     key <time> <x> <y> <z> <pitch> <yaw>
+*
+* Time is in seconds, angles in degrees as in Transform. Keyframes must be in increasing time order.
+*/
+class CameraPath
+{
+public:
+	struct Keyframe {
+		float time = 0.0f;
+		glm::vec3 position = { 0.0f, 0.0f, 0.0f };
+		float pitch = 0.0f;
+		float yaw = 0.0f;
+	};
+
+	void addKeyframe(const Keyframe& keyframe);
+	inline void clear() { m_keyframes.clear(); }
+
+	/*
+	* Interpolated keyframe at `time`. Times outside the path are clamped to its first & last keyframe
+	*/
+	Keyframe sample(float time) const;
+
+	/*
+	* Moves & orients `transform` to the path's pose at `time`
+	*/
+	void apply(Transform& transform, float time) const;
+
+	/*
+	* Parses a "key ..." line. Returns false if it isn't one
+	*/
+	static bool parseKeyframe(const std::string& line, Keyframe& outKeyframe);
+
+	/*
+	* Reads every keyframe line in `path`, anything else is ignored. Throws if the file can't be read
+	*/
+	void load(const std::filesystem::path& path);
+	void save(const std::filesystem::path& path) const;
+
+	inline bool empty() const { return m_keyframes.empty(); }
+	inline float getDuration() const { return m_keyframes.empty() ? 0.0f : m_keyframes.back().time; }
+	inline const std::vector<Keyframe>& getKeyframes() const { return m_keyframes; }
+
+private:
+	std::vector<Keyframe> m_keyframes;
+};
+
+}
@@ -1,5 +1,5 @@
 #include "perspective_camera.h"
-#include "Wyvern/application.h"
+#include "Wyvern/Application.h"
 
 namespace Wyvern {
 
@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/Components/transform.h"
 #include "Wyvern/Entity/entity.h"
 
@@ -3,9 +3,9 @@
 namespace Wyvern {
 
 Transform::Transform(glm::vec3 position)
-	:m_position(position),
-	m_orientation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)),
-	m_front({0.0f, 0.0f, 1.0f})
+	:m_orientation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)),
+	m_front({0.0f, 0.0f, 1.0f}),
+	m_position(position)
 {
 }
 
@@ -46,6 +46,13 @@ void Transform::updateOrientation(float deltaPitch, float deltaYaw, float scale)
 	updateQuatOrientation();
 }
 
+void Transform::setOrientation(float pitch, float yaw)
+{
+	m_pitchAngle = 0.0f;
+	m_yawAngle = 0.0f;
+	updateOrientation(pitch, std::fmod(yaw, 360.0f), 1.0f);
+}
+
 void Transform::updateQuatOrientation()
 {
 	glm::quat quatPitch = glm::angleAxis(glm::radians(m_pitchAngle), glm::vec3(1, 0, 0));
@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
@@ -28,6 +28,11 @@ public:
 	void updatePosition(glm::vec3& relativeVelocity, float scale);
 
 	void setPosition(glm::vec3 position);
+	/*
+	* Sets absolute pitch and yaw angles (degrees), e.g. when the transform is driven by a camera path instead of input.
+	* Same clamping and wrapping as updateOrientation()
+	*/
+	void setOrientation(float pitch, float yaw);
 
 	void setLockPitch(bool value) { m_lockPitch = value; }
 
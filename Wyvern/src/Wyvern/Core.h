@@ -1,9 +1,14 @@
 #pragma once
+// The Win32 surface path is only available on Windows, everything else goes through glfwCreateWindowSurface (see WYVKSurface)
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
 #include <string>
 #include <memory>
 #include <algorithm>
@@ -47,7 +52,11 @@
 #define USING_GLFW_SURFACE
 
 // Wyvern macros
+#ifdef _MSC_VER
 #define WYV_DEBUG_BREAK __debugbreak()
+#else
+#define WYV_DEBUG_BREAK __builtin_trap()
+#endif
 #define WYVERN_ASSERT(assert_on, msg) if (!assert_on) { WYVERN_LOG_ERROR("Assertion Failed: {}", msg); WYV_DEBUG_BREAK; }
 #define WYVERN_THROW(message) throw std::runtime_error(message)
 
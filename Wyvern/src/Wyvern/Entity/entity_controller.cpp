@@ -1,6 +1,6 @@
 #include "entity_controller.h"
 #include "Wyvern/Input/input.h"
-#include "Wyvern/application.h"
+#include "Wyvern/Application.h"
 
 namespace Wyvern {
 
@@ -41,7 +41,7 @@ void EntityController::update(float deltaTime)
 		movementVector.y -= 1.0f;
 	}
 	//WYVERN_LOG_INFO(movementVector.x);
-	glfwGetCursorPos(Application::get()->getWindow().getNativeWindow(), &cursorX, &cursorY);
+	Input::getCursorPos(cursorX, cursorY);
 
 	if (m_firstMouse) {
 		m_lastCursorX = cursorX;
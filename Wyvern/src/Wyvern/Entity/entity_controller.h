@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/Entity/player.h"
 #include "Wyvern/Camera/perspective_camera.h"
 
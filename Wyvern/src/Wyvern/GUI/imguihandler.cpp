@@ -40,6 +40,11 @@ namespace Wyvern {
 		initInfo.MinImageCount = 3;
 		initInfo.ImageCount = 3;
 		initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+#ifdef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+		// Drawn in the renderer's color only overlay pass, the render pass below is VK_NULL_HANDLE
+		initInfo.UseDynamicRendering = m_renderer.isDynamicRendering();
+		initInfo.ColorAttachmentFormat = m_renderer.getRenderPass().getColorFormat();
+#endif
 
 
 		IMGUI_CHECKVERSION();
@@ -49,8 +54,10 @@ namespace Wyvern {
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
 		//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls (we don't need gamepad for now)
 
-		// Setup Platform/Renderer backends
-		ImGui_ImplGlfw_InitForVulkan(m_window.getNativeWindow(), true);
+		// Setup Platform/Renderer backends. A headless window has no platform backend, newFrame() feeds size & time itself
+		if (!m_window.isHeadless()) {
+			ImGui_ImplGlfw_InitForVulkan(m_window.getNativeWindow(), true);
+		}
 		ImGui_ImplVulkan_Init(&initInfo, m_renderer.getRenderPass().getRenderPass());
 		ImGui::StyleColorsDark();
 		setStyle();
@@ -66,7 +73,9 @@ namespace Wyvern {
 		//ImGui_ImplVulkan_DestroyFontUploadObjects();
 		vkDestroyDescriptorPool(m_renderer.getDevice().getLogicalDevice(), m_imguiPool, nullptr);
 
-		ImGui_ImplGlfw_Shutdown();
+		if (!m_window.isHeadless()) {
+			ImGui_ImplGlfw_Shutdown();
+		}
 		ImGui_ImplVulkan_Shutdown();
 		ImPlot::DestroyContext(); // Destroy plotting context
 		ImGui::DestroyContext();
@@ -74,7 +83,14 @@ namespace Wyvern {
 
 	void ImGuiHandler::newFrame()
 	{
-		ImGui_ImplGlfw_NewFrame();
+		if (m_window.isHeadless()) {
+			ImGuiIO& io = ImGui::GetIO();
+			io.DisplaySize = ImVec2(static_cast<float>(m_window.getWidth()), static_cast<float>(m_window.getHeight()));
+			io.DeltaTime = m_window.deltaTime() > 0.0f ? m_window.deltaTime() : 1.0f / 60.0f;
+		}
+		else {
+			ImGui_ImplGlfw_NewFrame();
+		}
 		ImGui_ImplVulkan_NewFrame();
 		ImGui::NewFrame();
 	}
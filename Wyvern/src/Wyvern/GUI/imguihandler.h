@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/window.h"
 #include "Wyvern/Renderer/API/Vulkan/wyvk_renderer.h"
 
@@ -9,6 +9,13 @@ namespace Wyvern {
 	class ImGuiHandler
 	{
 	public:
+		// Whether the ImGui Vulkan backend can draw without a render pass. The renderer falls back to render passes if it can't
+#ifdef IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING
+		static constexpr bool SUPPORTS_DYNAMIC_RENDERING = true;
+#else
+		static constexpr bool SUPPORTS_DYNAMIC_RENDERING = false;
+#endif
+
 		ImGuiHandler(Window& window, WYVKRenderer& renderer);
 		~ImGuiHandler();
 
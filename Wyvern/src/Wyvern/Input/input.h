@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/Input/keycodes.h"
 
 namespace Wyvern {
@@ -8,7 +8,15 @@ class Input
 {
 public:
 	static void initInput(GLFWwindow* window) { Input::s_window = window; }
-	static bool isKeyPressed(int Keycode) { return glfwGetKey(Input::s_window, Keycode); }
+	// Nothing is ever pressed without a window (headless)
+	static bool isKeyPressed(int Keycode) { return s_window != nullptr && glfwGetKey(Input::s_window, Keycode); }
+	static void getCursorPos(double& x, double& y) {
+		x = 0.0;
+		y = 0.0;
+		if (s_window != nullptr) {
+			glfwGetCursorPos(s_window, &x, &y);
+		}
+	}
 private:
 	inline static GLFWwindow* s_window = nullptr;
 };
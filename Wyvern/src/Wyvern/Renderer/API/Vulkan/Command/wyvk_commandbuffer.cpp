@@ -43,6 +43,15 @@ void WYVKCommandBuffer::startRecording(VkCommandBufferUsageFlags flags)
 	VK_CALL(vkBeginCommandBuffer(m_commandBuffer, &beginInfo), "Failed to start command buffer recording!");
 }
 
+void WYVKCommandBuffer::startRecording(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo& inheritanceInfo)
+{
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = flags;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	VK_CALL(vkBeginCommandBuffer(m_commandBuffer, &beginInfo), "Failed to start secondary command buffer recording!");
+}
+
 void WYVKCommandBuffer::stopRecording()
 {
 	VK_CALL(vkEndCommandBuffer(m_commandBuffer), "Failed to record command buffer!");
@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 #include "wyvk_commandpool.h"
 
@@ -13,6 +13,12 @@ public:
 	void destroy();
 
 	void startRecording(VkCommandBufferUsageFlags flags);
+
+	/*
+	* Starts recording a secondary command buffer. `inheritanceInfo` describes the render pass, subpass and framebuffer
+	* the buffer will be executed in when VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT is set
+	*/
+	void startRecording(VkCommandBufferUsageFlags flags, const VkCommandBufferInheritanceInfo& inheritanceInfo);
 	void stopRecording();
 	void reset();
 
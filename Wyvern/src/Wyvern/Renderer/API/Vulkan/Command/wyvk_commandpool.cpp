@@ -3,17 +3,20 @@
 namespace Wyvern {
 
 WYVKCommandPool::WYVKCommandPool(WYVKDevice& device)
-	: m_device(device)
+	: WYVKCommandPool(device, device.getQueueFamilyIndices().graphicsFamily.value(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)
 {
-	WYVKDevice::QueueFamilyIndices queueFamilyIndices = m_device.getQueueFamilyIndices();
+}
 
+WYVKCommandPool::WYVKCommandPool(WYVKDevice& device, uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags)
+	: m_device(device)
+{
 	VkCommandPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 
 	// VK_COMMAND_POOL_CREATE_TRANSIENT_BIT: Hint that command buffers are rerecorded with new commands very often(may change memory allocation behavior)
 	// VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT : Allow command buffers to be rerecorded individually, without this flag they all have to be reset together
-	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value(); // Queue to write to
+	poolInfo.flags = flags;
+	poolInfo.queueFamilyIndex = queueFamilyIndex; // Queue to write to
 	VK_CALL(vkCreateCommandPool(m_device.getLogicalDevice(), &poolInfo, nullptr, &m_commandPool), "Failed to create command pool!");
 }
 
@@ -22,6 +25,11 @@ WYVKCommandPool::~WYVKCommandPool()
 	vkDestroyCommandPool(m_device.getLogicalDevice(), m_commandPool, nullptr);
 }
 
+void WYVKCommandPool::reset()
+{
+	VK_CALL(vkResetCommandPool(m_device.getLogicalDevice(), m_commandPool, 0), "Failed to reset command pool!");
+}
+
 }
 
 
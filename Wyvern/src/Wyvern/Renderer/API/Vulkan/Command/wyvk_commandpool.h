@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 
 namespace Wyvern {
@@ -8,10 +8,21 @@ class WYVKCommandPool
 {
 public:
 	WYVKCommandPool(WYVKDevice& device);
+
+	/*
+	* Creates a pool for a specific queue family. Command buffers allocated from it can only be submitted to queues of that family
+	*/
+	WYVKCommandPool(WYVKDevice& device, uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags);
 	~WYVKCommandPool();
 
 	VkCommandPool getCommandPool() { return m_commandPool; }
 
+	/*
+	* Resets every command buffer allocated from this pool at once. Much cheaper than resetting buffers one by one
+	* and works on pools created without VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+	*/
+	void reset();
+
 private:
 	VkCommandPool m_commandPool = VK_NULL_HANDLE;
 	
@@ -0,0 +1,51 @@
+#include "wyvk_frame_commandpools.h"
+
+namespace Wyvern {
+
+WYVKFrameCommandPools::WYVKFrameCommandPools(WYVKDevice& device, uint32_t frameCount, uint32_t slotCount)
+	: m_slotCount(slotCount),
+	m_device(device)
+{
+	uint32_t graphicsFamily = m_device.getQueueFamilyIndices().graphicsFamily.value();
+
+	m_frames.resize(frameCount);
+	for (std::vector<SlotPool>& slots : m_frames) {
+		slots.resize(slotCount);
+		for (SlotPool& slot : slots) {
+			// No RESET_COMMAND_BUFFER_BIT. The whole pool is reset at once every frame
+			slot.pool = std::make_unique<WYVKCommandPool>(m_device, graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		}
+	}
+}
+
+WYVKFrameCommandPools::~WYVKFrameCommandPools()
+{
+	// Command buffers have to be freed before the pool they came from
+	for (std::vector<SlotPool>& slots : m_frames) {
+		for (SlotPool& slot : slots) {
+			slot.secondaries.clear();
+			slot.pool.reset();
+		}
+	}
+}
+
+void WYVKFrameCommandPools::resetFrame(uint32_t frame)
+{
+	for (SlotPool& slot : m_frames[frame]) {
+		if (slot.used > 0) {
+			slot.pool->reset();
+			slot.used = 0;
+		}
+	}
+}
+
+WYVKCommandBuffer& WYVKFrameCommandPools::acquireSecondary(uint32_t frame, uint32_t slot)
+{
+	SlotPool& slotPool = m_frames[frame][slot];
+	if (slotPool.used == slotPool.secondaries.size()) {
+		slotPool.secondaries.push_back(std::make_unique<WYVKCommandBuffer>(m_device, *slotPool.pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1));
+	}
+	return *slotPool.secondaries[slotPool.used++];
+}
+
+}
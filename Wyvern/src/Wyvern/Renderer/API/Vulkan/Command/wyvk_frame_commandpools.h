@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "wyvk_commandpool.h"
+#include "wyvk_commandbuffer.h"
+
+namespace Wyvern {
+
+/*
+* Command pools for multithreaded recording. There is one pool per frame in flight per recording slot, where a slot is owned by
+* exactly one thread while a frame is being recorded (command pools are externally synchronized, so threads can never share one).
+*
+* Secondary command buffers are handed out linearly from each pool and are never reset individually. Instead, once the frame timeline
+* has passed the frame's last submission, resetFrame() resets all of the frame's pools in bulk and the buffers are reused from the start.
+*/
+class WYVKFrameCommandPools
+{
+public:
+	WYVKFrameCommandPools(WYVKDevice& device, uint32_t frameCount, uint32_t slotCount);
+	~WYVKFrameCommandPools();
+
+	/*
+	* Resets every pool of `frame`. Only call once the GPU is done with the frame's previous submission
+	*/
+	void resetFrame(uint32_t frame);
+
+	/*
+	* Returns an unused secondary command buffer from the pool of (`frame`, `slot`), allocating a new one if all are in use.
+	* Must only be called from the thread that owns `slot` this frame
+	*/
+	WYVKCommandBuffer& acquireSecondary(uint32_t frame, uint32_t slot);
+
+	inline uint32_t getSlotCount() const { return m_slotCount; }
+
+private:
+	struct SlotPool {
+		std::unique_ptr<WYVKCommandPool> pool;
+		std::vector<std::unique_ptr<WYVKCommandBuffer>> secondaries;
+		size_t used = 0;
+	};
+
+	uint32_t m_slotCount;
+	std::vector<std::vector<SlotPool>> m_frames; // [frame][slot]
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
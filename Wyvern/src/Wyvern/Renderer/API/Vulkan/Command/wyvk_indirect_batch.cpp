@@ -0,0 +1,105 @@
+#include "wyvk_indirect_batch.h"
+
+namespace Wyvern {
+
+WYVKIndirectBatch::WYVKIndirectBatch(WYVKDevice& device, uint32_t maxDraws)
+	: m_maxDraws(maxDraws),
+	m_device(device)
+{
+	// Rewritten by the CPU every frame, so these get the same placement as the per frame uniforms
+	m_commandBuffer = std::make_unique<WYVKBuffer>(m_device, sizeof(VkDrawIndexedIndirectCommand) * m_maxDraws,
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, WYVKMemoryPolicy::ResourceUsage::DYNAMIC_UNIFORM);
+	m_commandBuffer->createPersistentMapping();
+	m_commands = static_cast<VkDrawIndexedIndirectCommand*>(m_commandBuffer->getPersistentMapping());
+
+	m_drawDataBuffer = std::make_unique<WYVKBuffer>(m_device, sizeof(DrawData) * m_maxDraws,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, WYVKMemoryPolicy::ResourceUsage::DYNAMIC_UNIFORM);
+	m_drawDataBuffer->createPersistentMapping();
+	m_drawData = static_cast<DrawData*>(m_drawDataBuffer->getPersistentMapping());
+
+	if (m_device.getIndirectDrawSupport().drawIndirectCount) {
+		m_countBuffer = std::make_unique<WYVKBuffer>(m_device, sizeof(uint32_t) * m_maxDraws,
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, WYVKMemoryPolicy::ResourceUsage::DYNAMIC_UNIFORM);
+		m_countBuffer->createPersistentMapping();
+		m_counts = static_cast<uint32_t*>(m_countBuffer->getPersistentMapping());
+	}
+}
+
+WYVKIndirectBatch::~WYVKIndirectBatch()
+{
+}
+
+void WYVKIndirectBatch::reset()
+{
+	m_drawCount = 0;
+	m_groups.clear();
+}
+
+bool WYVKIndirectBatch::addDraw(VkBuffer vertexBuffer, VkBuffer indexBuffer, VkIndexType indexType,
+	uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, const DrawData& drawData)
+{
+	if (m_drawCount == m_maxDraws) {
+		WYVERN_LOG_WARN("Indirect batch is full ({} draws). Draw skipped", m_maxDraws);
+		return false;
+	}
+
+	// firstInstance doubles as the index into the draw data buffer
+	VkDrawIndexedIndirectCommand& command = m_commands[m_drawCount];
+	command.indexCount = indexCount;
+	command.instanceCount = 1;
+	command.firstIndex = firstIndex;
+	command.vertexOffset = vertexOffset;
+	command.firstInstance = m_drawCount;
+	m_drawData[m_drawCount] = drawData;
+
+	if (!m_groups.empty() && m_groups.back().vertexBuffer == vertexBuffer && m_groups.back().indexBuffer == indexBuffer && m_groups.back().indexType == indexType) {
+		m_groups.back().drawCount++;
+	}
+	else {
+		m_groups.push_back({ vertexBuffer, indexBuffer, indexType, m_drawCount, 1 });
+	}
+	m_drawCount++;
+	return true;
+}
+
+void WYVKIndirectBatch::record(VkCommandBuffer cmd)
+{
+	const WYVKDevice::IndirectDrawSupport& support = m_device.getIndirectDrawSupport();
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	const VkDeviceSize zeroOffset = 0;
+	m_recordedCalls = 0;
+
+	for (const DrawGroup& group : m_groups) {
+		vkCmdBindVertexBuffers(cmd, 0, 1, &group.vertexBuffer, &zeroOffset);
+		vkCmdBindIndexBuffer(cmd, group.indexBuffer, 0, group.indexType);
+
+		// Without drawIndirectFirstInstance the commands' firstInstance must be 0, which would break the draw data lookup.
+		// Direct draws have no such restriction, so issue the same commands one by one
+		if (!support.drawIndirectFirstInstance) {
+			for (uint32_t i = group.firstDraw; i < group.firstDraw + group.drawCount; i++) {
+				const VkDrawIndexedIndirectCommand& command = m_commands[i];
+				vkCmdDrawIndexed(cmd, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+				m_recordedCalls++;
+			}
+			continue;
+		}
+
+		// Without multiDrawIndirect every call is limited to a single draw
+		for (uint32_t first = group.firstDraw; first < group.firstDraw + group.drawCount; first += support.maxDrawIndirectCount) {
+			uint32_t drawCount = std::min(support.maxDrawIndirectCount, group.firstDraw + group.drawCount - first);
+			VkDeviceSize offset = static_cast<VkDeviceSize>(first) * stride;
+
+			if (m_countBuffer) {
+				m_counts[m_recordedCalls] = drawCount;
+				vkCmdDrawIndexedIndirectCount(cmd, m_commandBuffer->getBuffer(), offset,
+					m_countBuffer->getBuffer(), sizeof(uint32_t) * m_recordedCalls, drawCount, stride);
+			}
+			else {
+				vkCmdDrawIndexedIndirect(cmd, m_commandBuffer->getBuffer(), offset, drawCount, stride);
+			}
+			m_recordedCalls++;
+		}
+	}
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "../Memory/buffer.h"
+
+namespace Wyvern {
+
+/*
+* CPU built list of indexed draws that is submitted with indirect draw calls instead of one vkCmdDrawIndexed per object.
+*
+* Every draw writes a VkDrawIndexedIndirectCommand and a DrawData entry into persistently mapped buffers. The command's firstInstance
+* is set to the draw's index, so the vertex shader can fetch its DrawData with gl_InstanceIndex (see vertex_indirect.vert).
+* Consecutive draws that use the same vertex/index buffers are merged into one group, and each group is issued with a single
+* vkCmdDrawIndexedIndirect, or vkCmdDrawIndexedIndirectCount when the device supports it so the counts can later be written by the GPU.
+*
+* One batch is used per frame in flight since the GPU reads the buffers while the next frame is being built.
+*/
+class WYVKIndirectBatch
+{
+public:
+	// Per draw data read by the vertex shader. Must match the DrawData struct in vertex_indirect.vert (std430)
+	struct DrawData {
+		glm::mat4 model;
+	};
+
+	static constexpr uint32_t DEFAULT_MAX_DRAWS = 4096;
+
+	WYVKIndirectBatch(WYVKDevice& device, uint32_t maxDraws = DEFAULT_MAX_DRAWS);
+	~WYVKIndirectBatch();
+
+	/*
+	* Clears all draws. Only call once the GPU is done with the frame that last used this batch
+	*/
+	void reset();
+
+	/*
+	* Appends a draw of `indexCount` indices. Returns false if the batch is full
+	*/
+	bool addDraw(VkBuffer vertexBuffer, VkBuffer indexBuffer, VkIndexType indexType,
+		uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset, const DrawData& drawData);
+
+	/*
+	* Binds each group's vertex/index buffers and records its indirect draws. The pipeline and descriptor sets must already be bound
+	*/
+	void record(VkCommandBuffer cmd);
+
+	inline WYVKBuffer& getDrawDataBuffer() { return *m_drawDataBuffer; }
+	inline uint32_t getDrawCount() const { return m_drawCount; }
+	inline uint32_t getMaxDraws() const { return m_maxDraws; }
+	inline uint32_t getRecordedCallCount() const { return m_recordedCalls; } // Draw calls issued by the last record()
+
+private:
+	struct DrawGroup {
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		VkIndexType indexType;
+		uint32_t firstDraw;
+		uint32_t drawCount;
+	};
+
+	uint32_t m_maxDraws;
+	uint32_t m_drawCount = 0;
+	uint32_t m_recordedCalls = 0;
+	std::vector<DrawGroup> m_groups;
+
+	std::unique_ptr<WYVKBuffer> m_commandBuffer;	// VkDrawIndexedIndirectCommand[m_maxDraws]
+	std::unique_ptr<WYVKBuffer> m_drawDataBuffer;	// DrawData[m_maxDraws]
+	std::unique_ptr<WYVKBuffer> m_countBuffer;		// uint32_t per indirect call. Only created when draw count is supported
+	VkDrawIndexedIndirectCommand* m_commands = nullptr;
+	DrawData* m_drawData = nullptr;
+	uint32_t* m_counts = nullptr;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "info.h"
 
 namespace Wyvern {
@@ -20,7 +20,7 @@ namespace Wyvern {
             createInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
             createInfo.pEngineName = "No Engine";
             createInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-            createInfo.apiVersion = VK_API_VERSION_1_0;
+            createInfo.apiVersion = VK_API_VERSION_1_3; // 1.2 for timeline semaphores, 1.3 for dynamic rendering where the device has it
         }
 
         void createDeviceInfo(VkDeviceCreateInfo& createInfo, std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos, VkPhysicalDeviceFeatures& deviceFeatures, const std::vector<const char*>& deviceExtensions, const std::vector<const char*>& validationLayers) {
@@ -47,12 +47,14 @@ namespace Wyvern {
             createInfo.pQueuePriorities = queuePriority;
         }
 
+#ifdef VK_USE_PLATFORM_WIN32_KHR
         void createWin32SurfaceInfo(VkWin32SurfaceCreateInfoKHR& createInfo, GLFWwindow* window)
         {
             createInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
             createInfo.hwnd = glfwGetWin32Window(window);
             createInfo.hinstance = GetModuleHandle(nullptr);
         }
+#endif
 
         void createImageViewInfo(VkImageViewCreateInfo& createInfo, VkImage& image, VkFormat& imageFormat)
         {
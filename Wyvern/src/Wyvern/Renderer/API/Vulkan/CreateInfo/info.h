@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 
 #include <vector>
 
@@ -9,7 +9,9 @@ namespace Wyvern {
         void createAppInfo(VkApplicationInfo& createInfo);
         void createDeviceInfo(VkDeviceCreateInfo& createInfo, std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos, VkPhysicalDeviceFeatures& deviceFeatures, const std::vector<const char*>& deviceExtensions, const std::vector<const char*>& validationLayers);
         void createDeviceQueueInfo(VkDeviceQueueCreateInfo& createInfo, int queueFamilyIndex, int queueCount, float* queuePriority);
+#ifdef VK_USE_PLATFORM_WIN32_KHR
         void createWin32SurfaceInfo(VkWin32SurfaceCreateInfoKHR& createInfo, GLFWwindow* window);
+#endif
         void createImageViewInfo(VkImageViewCreateInfo& createInfo, VkImage& image, VkFormat& imageFormat);
     }
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "wyvk_bindless_set.h"
+
+namespace Wyvern {
+
+static const std::array<VkDescriptorType, WYVKBindlessSet::RESOURCE_TYPE_COUNT> DESCRIPTOR_TYPES = {
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+WYVKSlotAllocator::WYVKSlotAllocator(uint32_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+uint32_t WYVKSlotAllocator::allocate()
+{
+    if (!m_freeSlots.empty()) {
+        uint32_t slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+    if (m_nextSlot < m_capacity) {
+        return m_nextSlot++;
+    }
+    return INVALID_SLOT;
+}
+
+void WYVKSlotAllocator::free(uint32_t slot, uint64_t frameSerial)
+{
+    WYVERN_ASSERT((slot < m_nextSlot), "Freeing a slot that was never allocated");
+    m_pendingFrees.push_back({ frameSerial, slot });
+}
+
+void WYVKSlotAllocator::retire(uint64_t completedSerial)
+{
+    while (!m_pendingFrees.empty() && m_pendingFrees.front().frameSerial <= completedSerial) {
+        m_freeSlots.push_back(m_pendingFrees.front().slot);
+        m_pendingFrees.pop_front();
+    }
+}
+
+WYVKBindlessSet::WYVKBindlessSet(WYVKDevice& device, uint32_t maxStorageBuffers, uint32_t maxSampledImages, uint32_t maxSamplers)
+    : m_device(device)
+{
+    const WYVKDevice::BindlessSupport& support = m_device.getBindlessSupport();
+    WYVERN_ASSERT(support.supported, "Bindless descriptors are not supported by this device");
+
+    m_capacities = { std::min(maxStorageBuffers, support.maxStorageBuffers), std::min(maxSampledImages, support.maxSampledImages), std::min(maxSamplers, support.maxSamplers) };
+    for (uint32_t capacity : m_capacities) {
+        m_slots.emplace_back(capacity);
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, RESOURCE_TYPE_COUNT> bindings{};
+    std::array<VkDescriptorBindingFlags, RESOURCE_TYPE_COUNT> bindingFlags{};
+    std::array<VkDescriptorPoolSize, RESOURCE_TYPE_COUNT> poolSizes{};
+    for (uint32_t i = 0; i < RESOURCE_TYPE_COUNT; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = DESCRIPTOR_TYPES[i];
+        bindings[i].descriptorCount = m_capacities[i];
+        bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+        // Slots are written while the set is bound and most of them never hold a descriptor
+        bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        poolSizes[i] = { DESCRIPTOR_TYPES[i], m_capacities[i] };
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CALL(vkCreateDescriptorSetLayout(m_device.getLogicalDevice(), &layoutInfo, nullptr, &m_layout), "Unable to create bindless descriptor set layout!");
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    VK_CALL(vkCreateDescriptorPool(m_device.getLogicalDevice(), &poolInfo, nullptr, &m_pool), "Unable to create bindless descriptor pool!");
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_layout;
+    VK_CALL(vkAllocateDescriptorSets(m_device.getLogicalDevice(), &allocInfo, &m_descriptorSet), "Unable to allocate bindless descriptor set!");
+
+    WYVERN_LOG_INFO("Bindless descriptor set with {} storage buffers | {} sampled images | {} samplers", m_capacities[0], m_capacities[1], m_capacities[2]);
+}
+
+WYVKBindlessSet::~WYVKBindlessSet()
+{
+    // Frees m_descriptorSet as well
+    vkDestroyDescriptorPool(m_device.getLogicalDevice(), m_pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_device.getLogicalDevice(), m_layout, nullptr);
+}
+
+uint32_t WYVKBindlessSet::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t slot = allocateSlot(ResourceType::STORAGE_BUFFER);
+    write(ResourceType::STORAGE_BUFFER, slot, &bufferInfo, nullptr);
+    return slot;
+}
+
+uint32_t WYVKBindlessSet::addSampledImage(VkImageView imageView, VkImageLayout imageLayout)
+{
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = imageLayout;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t slot = allocateSlot(ResourceType::SAMPLED_IMAGE);
+    write(ResourceType::SAMPLED_IMAGE, slot, nullptr, &imageInfo);
+    return slot;
+}
+
+uint32_t WYVKBindlessSet::addSampler(VkSampler sampler)
+{
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t slot = allocateSlot(ResourceType::SAMPLER);
+    write(ResourceType::SAMPLER, slot, nullptr, &imageInfo);
+    return slot;
+}
+
+void WYVKBindlessSet::release(ResourceType type, uint32_t slot, uint64_t frameSerial)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_slots[static_cast<uint32_t>(type)].free(slot, frameSerial);
+}
+
+void WYVKBindlessSet::retire(uint64_t completedSerial)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (WYVKSlotAllocator& slots : m_slots) {
+        slots.retire(completedSerial);
+    }
+}
+
+void WYVKBindlessSet::bind(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+{
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, SET, 1, &m_descriptorSet, 0, nullptr);
+}
+
+uint32_t WYVKBindlessSet::getUsedCount(ResourceType type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_slots[static_cast<uint32_t>(type)].getUsedCount();
+}
+
+uint32_t WYVKBindlessSet::allocateSlot(ResourceType type)
+{
+    uint32_t slot = m_slots[static_cast<uint32_t>(type)].allocate();
+    if (slot == WYVKSlotAllocator::INVALID_SLOT) {
+        WYVERN_LOG_ERROR("Bindless descriptor array {} is full ({} slots)", static_cast<uint32_t>(type), m_capacities[static_cast<uint32_t>(type)]);
+        WYVERN_THROW("Bindless descriptor array is full!");
+    }
+    return slot;
+}
+
+void WYVKBindlessSet::write(ResourceType type, uint32_t slot, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo)
+{
+    VkWriteDescriptorSet setWrite{};
+    setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    setWrite.dstSet = m_descriptorSet;
+    setWrite.dstBinding = static_cast<uint32_t>(type);
+    setWrite.dstArrayElement = slot;
+    setWrite.descriptorCount = 1;
+    setWrite.descriptorType = DESCRIPTOR_TYPES[static_cast<uint32_t>(type)];
+    setWrite.pBufferInfo = bufferInfo;
+    setWrite.pImageInfo = imageInfo;
+
+    vkUpdateDescriptorSets(m_device.getLogicalDevice(), 1, &setWrite, 0, nullptr);
+}
+
+}
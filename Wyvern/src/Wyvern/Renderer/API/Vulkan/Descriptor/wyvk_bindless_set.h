@@ -0,0 +1,122 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <mutex>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+
+namespace Wyvern {
+
+/*
+* Hands out indices into a fixed size descriptor array. Freed slots are only reused once the GPU is done with every frame that
+* could still read them, i.e. after retire() was called with a serial at or past the one they were freed in. Not thread safe
+*/
+class WYVKSlotAllocator
+{
+public:
+	static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+	WYVKSlotAllocator(uint32_t capacity);
+
+	// Returns INVALID_SLOT if every slot is in use
+	uint32_t allocate();
+	void free(uint32_t slot, uint64_t frameSerial);
+	void retire(uint64_t completedSerial);
+
+	inline uint32_t getCapacity() const { return m_capacity; }
+	inline uint32_t getUsedCount() const { return m_nextSlot - static_cast<uint32_t>(m_freeSlots.size()); }
+
+private:
+	struct PendingFree {
+		uint64_t frameSerial;
+		uint32_t slot;
+	};
+
+	uint32_t m_capacity;
+	uint32_t m_nextSlot = 0;				// Slots at or above this were never handed out
+	std::vector<uint32_t> m_freeSlots;
+	std::deque<PendingFree> m_pendingFrees;	// In frame serial order
+};
+
+/*
+* One large descriptor set holding every storage buffer, sampled image and sampler the shaders can reach. Shaders index the arrays
+* with slots passed per draw (push constants or per draw data), so it is bound once per command buffer instead of once per object.
+*
+* Created with UPDATE_AFTER_BIND & PARTIALLY_BOUND, so resources can be added while command buffers that use the set are recorded or
+* in flight, and unused slots never have to hold a valid descriptor. Needs WYVKDevice::BindlessSupport, devices without it keep using
+* the classic per frame descriptor sets.
+*
+* Shader side (set = SET):
+*     layout(set = 1, binding = 0) readonly buffer ... storageBuffers[];
+*     layout(set = 1, binding = 1) uniform texture2D sampledImages[];
+*     layout(set = 1, binding = 2) uniform sampler samplers[];
+*/
+class WYVKBindlessSet
+{
+public:
+	enum class ResourceType : uint32_t {
+		STORAGE_BUFFER = 0,	// Doubles as the binding index
+		SAMPLED_IMAGE = 1,
+		SAMPLER = 2,
+	};
+	static constexpr uint32_t RESOURCE_TYPE_COUNT = 3;
+
+	// Set index of the bindless set in every pipeline layout that uses it. Set 0 is the classic per frame set
+	static constexpr uint32_t SET = 1;
+
+	static constexpr uint32_t DEFAULT_MAX_STORAGE_BUFFERS = 4096;
+	static constexpr uint32_t DEFAULT_MAX_SAMPLED_IMAGES = 16384;
+	static constexpr uint32_t DEFAULT_MAX_SAMPLERS = 256;
+
+	/*
+	* Array sizes are clamped to the device's update after bind limits
+	*/
+	WYVKBindlessSet(WYVKDevice& device, uint32_t maxStorageBuffers = DEFAULT_MAX_STORAGE_BUFFERS,
+		uint32_t maxSampledImages = DEFAULT_MAX_SAMPLED_IMAGES, uint32_t maxSamplers = DEFAULT_MAX_SAMPLERS);
+	~WYVKBindlessSet();
+
+	/*
+	* Writes the resource into a free slot and returns the slot. Throws if the array is full. Thread safe
+	*/
+	uint32_t addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	uint32_t addSampledImage(VkImageView imageView, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	uint32_t addSampler(VkSampler sampler);
+
+	/*
+	* Frees `slot`. Frames up to `frameSerial` may still read it, so it is reused after retire() passed that serial. Thread safe
+	*/
+	void release(ResourceType type, uint32_t slot, uint64_t frameSerial);
+
+	/*
+	* Makes the slots released up to `completedSerial` available again. Call once the GPU finished that frame
+	*/
+	void retire(uint64_t completedSerial);
+
+	/*
+	* Binds the set at index SET. `pipelineLayout` has to include getLayout() at that index
+	*/
+	void bind(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout);
+
+	inline VkDescriptorSetLayout& getLayout() { return m_layout; }
+	inline VkDescriptorSet getDescriptorSet() const { return m_descriptorSet; }
+	uint32_t getUsedCount(ResourceType type);
+	inline uint32_t getCapacity(ResourceType type) const { return m_capacities[static_cast<uint32_t>(type)]; }
+
+private:
+	uint32_t allocateSlot(ResourceType type);
+	void write(ResourceType type, uint32_t slot, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo);
+
+	std::array<uint32_t, RESOURCE_TYPE_COUNT> m_capacities;
+	std::vector<WYVKSlotAllocator> m_slots;	// One per ResourceType
+	std::mutex m_mutex;						// Guards the allocators & descriptor writes
+
+	VkDescriptorPool m_pool = VK_NULL_HANDLE;
+	VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+	VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -0,0 +1,192 @@
+#include "wyvk_descriptor_allocator.h"
+#include "Wyvern/hash.h"
+
+namespace Wyvern {
+
+WYVKDescriptorAllocator::WYVKDescriptorAllocator(WYVKDevice& device, uint32_t frameCount, const std::vector<VkDescriptorPoolSize>& poolSizesPerSet, uint32_t setsPerPool)
+    : m_poolSizesPerSet(poolSizesPerSet),
+    m_setsPerPool(setsPerPool),
+    m_device(device)
+{
+    for (uint32_t i = 0; i < frameCount; i++) {
+        m_frames.push_back(std::make_unique<FramePools>());
+        m_frames.back()->writer = std::make_unique<WYVKDescriptorWriter>(m_device);
+    }
+}
+
+WYVKDescriptorAllocator::~WYVKDescriptorAllocator()
+{
+    for (auto& frame : m_frames) {
+        for (VkDescriptorPool pool : frame->usedPools) {
+            vkDestroyDescriptorPool(m_device.getLogicalDevice(), pool, nullptr);
+        }
+        for (VkDescriptorPool pool : frame->freePools) {
+            vkDestroyDescriptorPool(m_device.getLogicalDevice(), pool, nullptr);
+        }
+    }
+}
+
+void WYVKDescriptorAllocator::beginFrame(uint32_t frame)
+{
+    FramePools& pools = *m_frames[frame];
+    std::lock_guard<std::mutex> lock(pools.mutex);
+    for (VkDescriptorPool pool : pools.usedPools) {
+        VK_CALL(vkResetDescriptorPool(m_device.getLogicalDevice(), pool, 0), "Failed to reset descriptor pool!");
+        pools.freePools.push_back(pool);
+    }
+    pools.usedPools.clear();
+    pools.cache.clear();
+    pools.statistics = Statistics();
+}
+
+VkDescriptorSet WYVKDescriptorAllocator::allocate(uint32_t frame, VkDescriptorSetLayout layout)
+{
+    FramePools& pools = *m_frames[frame];
+    std::lock_guard<std::mutex> lock(pools.mutex);
+    return allocateLocked(pools, layout);
+}
+
+VkDescriptorSet WYVKDescriptorAllocator::getSet(uint32_t frame, VkDescriptorSetLayout layout, const std::vector<Binding>& bindings)
+{
+    FramePools& pools = *m_frames[frame];
+    std::lock_guard<std::mutex> lock(pools.mutex);
+
+    uint64_t hash = hashSet(layout, bindings);
+    auto cached = pools.cache.find(hash);
+    if (cached != pools.cache.end() && isSameSet(cached->second, layout, bindings)) {
+        pools.statistics.cacheHits++;
+        return cached->second.set;
+    }
+
+    VkDescriptorSet set = allocateLocked(pools, layout);
+    for (const Binding& binding : bindings) {
+        if (WYVKDescriptorWriter::isImageDescriptor(binding.type)) {
+            pools.writer->writeImage(set, binding.binding, binding.type, binding.imageInfo.imageView, binding.imageInfo.sampler, binding.imageInfo.imageLayout);
+        }
+        else {
+            pools.writer->writeBuffer(set, binding.binding, binding.type, binding.bufferInfo.buffer, binding.bufferInfo.offset, binding.bufferInfo.range);
+        }
+    }
+    pools.writer->flush();
+
+    // On a hash collision the newer set wins, the older one stays valid until the frame is reset
+    pools.cache[hash] = { layout, bindings, set };
+    return set;
+}
+
+WYVKDescriptorAllocator::Statistics WYVKDescriptorAllocator::getStatistics(uint32_t frame)
+{
+    FramePools& pools = *m_frames[frame];
+    std::lock_guard<std::mutex> lock(pools.mutex);
+    Statistics statistics = pools.statistics;
+    statistics.poolsUsed = static_cast<uint32_t>(pools.usedPools.size());
+    statistics.poolCount = static_cast<uint32_t>(pools.usedPools.size() + pools.freePools.size());
+    statistics.poolGrowths = m_poolGrowths.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+uint64_t WYVKDescriptorAllocator::hashSet(VkDescriptorSetLayout layout, const std::vector<Binding>& bindings)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hashValue(hash, layout);
+    for (const Binding& binding : bindings) {
+        hashValue(hash, binding.binding);
+        hashValue(hash, binding.type);
+        hashValue(hash, binding.bufferInfo.buffer);
+        hashValue(hash, binding.bufferInfo.offset);
+        hashValue(hash, binding.bufferInfo.range);
+        hashValue(hash, binding.imageInfo.sampler);
+        hashValue(hash, binding.imageInfo.imageView);
+        hashValue(hash, binding.imageInfo.imageLayout);
+    }
+    return hash;
+}
+
+bool WYVKDescriptorAllocator::isSameSet(const CachedSet& cached, VkDescriptorSetLayout layout, const std::vector<Binding>& bindings)
+{
+    if (cached.layout != layout || cached.bindings.size() != bindings.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < bindings.size(); i++) {
+        const Binding& a = cached.bindings[i];
+        const Binding& b = bindings[i];
+        if (a.binding != b.binding || a.type != b.type ||
+            a.bufferInfo.buffer != b.bufferInfo.buffer || a.bufferInfo.offset != b.bufferInfo.offset || a.bufferInfo.range != b.bufferInfo.range ||
+            a.imageInfo.sampler != b.imageInfo.sampler || a.imageInfo.imageView != b.imageInfo.imageView || a.imageInfo.imageLayout != b.imageInfo.imageLayout) {
+            return false;
+        }
+    }
+    return true;
+}
+
+VkDescriptorSet WYVKDescriptorAllocator::allocateLocked(FramePools& frame, VkDescriptorSetLayout layout)
+{
+    if (frame.usedPools.empty()) {
+        frame.usedPools.push_back(nextPool(frame));
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = frame.usedPools.back();
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkResult result = vkAllocateDescriptorSets(m_device.getLogicalDevice(), &allocInfo, &set);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        // The current pool is full. Move on to the next one
+        frame.usedPools.push_back(nextPool(frame));
+        allocInfo.descriptorPool = frame.usedPools.back();
+        result = vkAllocateDescriptorSets(m_device.getLogicalDevice(), &allocInfo, &set);
+
+        // An empty pool still fails if the layout needs more descriptors of some type than poolSizesPerSet has room for
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+            WYVERN_LOG_ERROR("Descriptor set allocation failed on an empty pool (VkResult {})", static_cast<int>(result));
+            WYVERN_THROW("Descriptor set layout needs more descriptors than poolSizesPerSet provides for one set!");
+        }
+    }
+    VK_CALL(result, "Failed to allocate descriptor set!");
+
+    frame.statistics.allocations++;
+    return set;
+}
+
+VkDescriptorPool WYVKDescriptorAllocator::nextPool(FramePools& frame)
+{
+    if (!frame.freePools.empty()) {
+        VkDescriptorPool pool = frame.freePools.back();
+        frame.freePools.pop_back();
+        return pool;
+    }
+
+    uint32_t setCount;
+    {
+        std::lock_guard<std::mutex> lock(m_growthMutex);
+        setCount = m_setsPerPool;
+        m_setsPerPool = std::min(m_setsPerPool * 2, MAX_SETS_PER_POOL);
+    }
+    m_poolGrowths.fetch_add(1, std::memory_order_relaxed);
+    return createPool(setCount);
+}
+
+VkDescriptorPool WYVKDescriptorAllocator::createPool(uint32_t setCount)
+{
+    std::vector<VkDescriptorPoolSize> sizes = m_poolSizesPerSet;
+    for (VkDescriptorPoolSize& size : sizes) {
+        size.descriptorCount *= setCount;
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = 0; // Sets are never freed one by one
+    poolInfo.maxSets = setCount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    poolInfo.pPoolSizes = sizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VK_CALL(vkCreateDescriptorPool(m_device.getLogicalDevice(), &poolInfo, nullptr, &pool), "Unable to create descriptor pool!");
+    WYVERN_LOG_INFO("Created descriptor pool for {} sets", setCount);
+    return pool;
+}
+
+}
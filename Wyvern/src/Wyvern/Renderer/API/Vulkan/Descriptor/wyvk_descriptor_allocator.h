@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "wyvk_descriptor_writer.h"
+
+namespace Wyvern {
+
+/*
+* Hands out descriptor sets that live for one frame.
+*
+* Every frame in flight has its own chain of pools. When the current pool runs out (VK_ERROR_OUT_OF_POOL_MEMORY/FRAGMENTED_POOL)
+* the next one is taken or created, each new pool holding more sets than the last. beginFrame() resets the whole chain with one
+* vkResetDescriptorPool per pool instead of freeing sets one by one, so a frame's sets are only valid until its frame index comes around again.
+*
+* getSet() also keeps a per frame cache keyed by the layout and the written bindings, so asking for the same set twice in a frame
+* returns the first one instead of allocating & writing again.
+*/
+class WYVKDescriptorAllocator
+{
+public:
+	static constexpr uint32_t DEFAULT_SETS_PER_POOL = 64;
+	static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+	/*
+	* One descriptor of a set written by getSet(). Buffer descriptors use `bufferInfo`, images & samplers use `imageInfo`
+	*/
+	struct Binding {
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		VkDescriptorBufferInfo bufferInfo{};
+		VkDescriptorImageInfo imageInfo{};
+	};
+
+	struct Statistics {
+		uint32_t allocations = 0;	// Sets allocated this frame
+		uint32_t cacheHits = 0;		// getSet() calls answered from the cache this frame
+		uint32_t poolsUsed = 0;		// Pools the frame allocated from
+		uint32_t poolCount = 0;		// Pools owned by the frame, used or not
+		uint32_t poolGrowths = 0;	// Pools created since startup, summed over all frames
+	};
+
+	/*
+	* `poolSizesPerSet` is how many descriptors of each type an average set needs (e.g. WYVKShaderReflection::Reflection::getPoolSizes(1)).
+	* Pools are sized for `setsPerPool` such sets, and every new pool doubles that up to MAX_SETS_PER_POOL
+	*/
+	WYVKDescriptorAllocator(WYVKDevice& device, uint32_t frameCount, const std::vector<VkDescriptorPoolSize>& poolSizesPerSet,
+		uint32_t setsPerPool = DEFAULT_SETS_PER_POOL);
+	~WYVKDescriptorAllocator();
+
+	/*
+	* Resets every pool of `frame` and clears its cache. Only call once the GPU is done with the frame's previous sets
+	*/
+	void beginFrame(uint32_t frame);
+
+	/*
+	* Allocates a set with `layout` for `frame`. Grows the pool chain instead of failing when a pool is full. Thread safe.
+	* Throws if the set does not fit even in an empty pool, i.e. `layout` needs more than `poolSizesPerSet` times the pool's set count
+	*/
+	VkDescriptorSet allocate(uint32_t frame, VkDescriptorSetLayout layout);
+
+	/*
+	* Returns a set with `layout` and `bindings` written to it. Identical requests within a frame share one set. Thread safe
+	*/
+	VkDescriptorSet getSet(uint32_t frame, VkDescriptorSetLayout layout, const std::vector<Binding>& bindings);
+
+	Statistics getStatistics(uint32_t frame);
+
+private:
+	struct CachedSet {
+		VkDescriptorSetLayout layout;
+		std::vector<Binding> bindings;	// Compared on lookup, so a hash collision never returns the wrong set
+		VkDescriptorSet set;
+	};
+
+	struct FramePools {
+		std::vector<VkDescriptorPool> usedPools;	// Allocated from this frame. The last one is the current pool
+		std::vector<VkDescriptorPool> freePools;	// Reset and ready to be used again
+		std::unordered_map<uint64_t, CachedSet> cache;
+		std::unique_ptr<WYVKDescriptorWriter> writer;	// Writes getSet() bindings in one call
+		Statistics statistics;
+		std::mutex mutex;
+	};
+
+	static uint64_t hashSet(VkDescriptorSetLayout layout, const std::vector<Binding>& bindings);
+	static bool isSameSet(const CachedSet& cached, VkDescriptorSetLayout layout, const std::vector<Binding>& bindings);
+
+	VkDescriptorSet allocateLocked(FramePools& frame, VkDescriptorSetLayout layout);
+	VkDescriptorPool nextPool(FramePools& frame);
+	VkDescriptorPool createPool(uint32_t setCount);
+
+	std::vector<std::unique_ptr<FramePools>> m_frames;
+	std::vector<VkDescriptorPoolSize> m_poolSizesPerSet;
+	uint32_t m_setsPerPool;
+	std::atomic<uint32_t> m_poolGrowths{ 0 };
+	std::mutex m_growthMutex; // Guards m_setsPerPool
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -0,0 +1,129 @@
+#include "wyvk_descriptor_benchmark.h"
+#include "wyvk_descriptor_template.h"
+#include "wyvk_descriptor_writer.h"
+
+namespace Wyvern {
+
+/*
+* Runs `update` over every set `rounds` times and keeps the fastest round
+*/
+template<typename Func>
+static WYVKDescriptorBenchmark::Result measure(const char* method, uint32_t rounds, uint32_t setCount, Func&& update)
+{
+    WYVKDescriptorBenchmark::Result result;
+    result.method = method;
+    result.totalMs = std::numeric_limits<double>::max();
+    for (uint32_t round = 0; round < rounds; round++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        result.driverCalls = update();
+        result.totalMs = std::min(result.totalMs, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    result.usPerSet = result.totalMs * 1000.0 / setCount;
+    return result;
+}
+
+static void addWrite(WYVKDescriptorWriter& writer, VkDescriptorSet set, const WYVKDescriptorAllocator::Binding& binding)
+{
+    if (WYVKDescriptorWriter::isImageDescriptor(binding.type)) {
+        writer.writeImage(set, binding.binding, binding.type, binding.imageInfo.imageView, binding.imageInfo.sampler, binding.imageInfo.imageLayout);
+    }
+    else {
+        writer.writeBuffer(set, binding.binding, binding.type, binding.bufferInfo.buffer, binding.bufferInfo.offset, binding.bufferInfo.range);
+    }
+}
+
+std::vector<WYVKDescriptorBenchmark::Result> WYVKDescriptorBenchmark::run(WYVKDevice& device, VkDescriptorSetLayout layout,
+    const std::vector<WYVKDescriptorAllocator::Binding>& bindings, uint32_t setCount, uint32_t rounds)
+{
+    std::map<VkDescriptorType, uint32_t> counts;
+    for (const WYVKDescriptorAllocator::Binding& binding : bindings) {
+        counts[binding.type]++;
+    }
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto& count : counts) {
+        poolSizes.push_back({ count.first, count.second });
+    }
+
+    WYVKDescriptorAllocator allocator(device, 1, poolSizes, setCount);
+    std::vector<VkDescriptorSet> sets(setCount);
+    for (VkDescriptorSet& set : sets) {
+        set = allocator.allocate(0, layout);
+    }
+
+    std::vector<Result> results;
+
+    results.push_back(measure("Per binding", rounds, setCount, [&]() {
+        uint32_t calls = 0;
+        for (VkDescriptorSet set : sets) {
+            for (const WYVKDescriptorAllocator::Binding& binding : bindings) {
+                VkWriteDescriptorSet setWrite{};
+                setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                setWrite.dstSet = set;
+                setWrite.dstBinding = binding.binding;
+                setWrite.descriptorCount = 1;
+                setWrite.descriptorType = binding.type;
+                setWrite.pBufferInfo = &binding.bufferInfo;
+                setWrite.pImageInfo = &binding.imageInfo;
+                vkUpdateDescriptorSets(device.getLogicalDevice(), 1, &setWrite, 0, nullptr);
+                calls++;
+            }
+        }
+        return calls;
+    }));
+
+    WYVKDescriptorWriter writer(device);
+    results.push_back(measure("Batched per set", rounds, setCount, [&]() {
+        uint64_t flushes = writer.getFlushCount();
+        for (VkDescriptorSet set : sets) {
+            for (const WYVKDescriptorAllocator::Binding& binding : bindings) {
+                addWrite(writer, set, binding);
+            }
+            writer.flush();
+        }
+        return static_cast<uint32_t>(writer.getFlushCount() - flushes);
+    }));
+
+    results.push_back(measure("Batched", rounds, setCount, [&]() {
+        for (VkDescriptorSet set : sets) {
+            for (const WYVKDescriptorAllocator::Binding& binding : bindings) {
+                addWrite(writer, set, binding);
+            }
+        }
+        writer.flush();
+        return 1u;
+    }));
+
+    if (device.supportsDescriptorUpdateTemplates()) {
+        std::vector<WYVKDescriptorTemplate::Entry> entries;
+        for (const WYVKDescriptorAllocator::Binding& binding : bindings) {
+            entries.push_back({ binding.binding, binding.type, 1, 0 });
+        }
+        WYVKDescriptorTemplate updateTemplate(device, layout, entries);
+
+        // Every set gets the same descriptors, so the data block is filled once
+        std::vector<char> data(updateTemplate.getDataSize());
+        for (uint32_t i = 0; i < bindings.size(); i++) {
+            if (WYVKDescriptorWriter::isImageDescriptor(bindings[i].type)) {
+                *updateTemplate.getInfos<VkDescriptorImageInfo>(data.data(), i) = bindings[i].imageInfo;
+            }
+            else {
+                *updateTemplate.getInfos<VkDescriptorBufferInfo>(data.data(), i) = bindings[i].bufferInfo;
+            }
+        }
+
+        results.push_back(measure("Templated", rounds, setCount, [&]() {
+            for (VkDescriptorSet set : sets) {
+                updateTemplate.update(set, data.data());
+            }
+            return setCount;
+        }));
+    }
+
+    for (const Result& result : results) {
+        WYVERN_LOG_INFO("Descriptor updates | {}: {:.3f} ms for {} sets ({:.3f} us/set, {} calls)",
+            result.method, result.totalMs, setCount, result.usPerSet, result.driverCalls);
+    }
+    return results;
+}
+
+}
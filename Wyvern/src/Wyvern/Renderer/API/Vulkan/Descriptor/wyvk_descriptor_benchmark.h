@@ -0,0 +1,36 @@
+#pragma once
+#include <limits>
+#include <map>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "wyvk_descriptor_allocator.h"
+
+namespace Wyvern {
+
+/*
+* Times the ways a descriptor set can be written, so the cost of per binding updates can be compared to batched & templated ones
+* on the device at hand. Every method writes the same `bindings` into `setCount` fresh sets of `layout`:
+*
+*     Per binding         One vkUpdateDescriptorSets per binding (what WYVKDescriptorSet::updateBinding does)
+*     Batched per set     One WYVKDescriptorWriter flush per set, e.g. one per material
+*     Batched             Every set in a single WYVKDescriptorWriter flush
+*     Templated           One vkUpdateDescriptorSetWithTemplate per set. Skipped without update template support
+*
+* The sets come from a private allocator and are never bound, so the benchmark can run between frames.
+*/
+class WYVKDescriptorBenchmark
+{
+public:
+	struct Result {
+		std::string method;
+		double totalMs = 0.0;		// Best of all rounds
+		double usPerSet = 0.0;
+		uint32_t driverCalls = 0;	// Update calls per round
+	};
+
+	static std::vector<Result> run(WYVKDevice& device, VkDescriptorSetLayout layout, const std::vector<WYVKDescriptorAllocator::Binding>& bindings,
+		uint32_t setCount = 1000, uint32_t rounds = 5);
+};
+
+}
@@ -0,0 +1,48 @@
+#include "wyvk_descriptor_template.h"
+#include "wyvk_descriptor_writer.h"
+
+namespace Wyvern {
+
+WYVKDescriptorTemplate::WYVKDescriptorTemplate(WYVKDevice& device, VkDescriptorSetLayout layout, const std::vector<Entry>& entries)
+    : m_device(device)
+{
+    WYVERN_ASSERT(m_device.supportsDescriptorUpdateTemplates(), "Descriptor update templates are not supported by this device");
+
+    // Both info structs are 8 byte aligned, so packing the entries back to back keeps every info aligned
+    std::vector<VkDescriptorUpdateTemplateEntry> templateEntries;
+    for (const Entry& entry : entries) {
+        size_t stride = WYVKDescriptorWriter::isImageDescriptor(entry.type) ? sizeof(VkDescriptorImageInfo) : sizeof(VkDescriptorBufferInfo);
+
+        VkDescriptorUpdateTemplateEntry templateEntry{};
+        templateEntry.dstBinding = entry.binding;
+        templateEntry.dstArrayElement = entry.arrayElement;
+        templateEntry.descriptorCount = entry.count;
+        templateEntry.descriptorType = entry.type;
+        templateEntry.offset = m_dataSize;
+        templateEntry.stride = stride;
+        templateEntries.push_back(templateEntry);
+
+        m_offsets.push_back(m_dataSize);
+        m_dataSize += stride * entry.count;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(templateEntries.size());
+    createInfo.pDescriptorUpdateEntries = templateEntries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    createInfo.descriptorSetLayout = layout;
+    VK_CALL(vkCreateDescriptorUpdateTemplate(m_device.getLogicalDevice(), &createInfo, nullptr, &m_template), "Unable to create descriptor update template!");
+}
+
+WYVKDescriptorTemplate::~WYVKDescriptorTemplate()
+{
+    vkDestroyDescriptorUpdateTemplate(m_device.getLogicalDevice(), m_template, nullptr);
+}
+
+void WYVKDescriptorTemplate::update(VkDescriptorSet set, const void* data)
+{
+    vkUpdateDescriptorSetWithTemplate(m_device.getLogicalDevice(), set, m_template, data);
+}
+
+}
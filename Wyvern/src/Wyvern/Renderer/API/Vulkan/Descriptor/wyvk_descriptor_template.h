@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+
+namespace Wyvern {
+
+/*
+* Descriptor update template for sets that are always written the same way. The whole set is updated from one block of memory with
+* vkUpdateDescriptorSetWithTemplate, the driver never has to walk VkWriteDescriptorSet structs.
+*
+* The data block holds the entries back to back: a VkDescriptorBufferInfo per descriptor of a buffer entry and a VkDescriptorImageInfo
+* per descriptor of an image entry. Fill it through getInfos() or the offsets from getOffset().
+*
+* Needs WYVKDevice::supportsDescriptorUpdateTemplates(), use WYVKDescriptorWriter otherwise
+*/
+class WYVKDescriptorTemplate
+{
+public:
+	struct Entry {
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uint32_t count = 1;
+		uint32_t arrayElement = 0;
+	};
+
+	WYVKDescriptorTemplate(WYVKDevice& device, VkDescriptorSetLayout layout, const std::vector<Entry>& entries);
+	~WYVKDescriptorTemplate();
+
+	/*
+	* Writes every entry of `set` from `data`, which has to be getDataSize() bytes laid out as described above
+	*/
+	void update(VkDescriptorSet set, const void* data);
+
+	/*
+	* First info of `entry` inside `data`. T is VkDescriptorBufferInfo for buffer entries and VkDescriptorImageInfo for image entries
+	*/
+	template<typename T>
+	inline T* getInfos(void* data, uint32_t entry) const { return reinterpret_cast<T*>(static_cast<char*>(data) + m_offsets[entry]); }
+
+	inline size_t getOffset(uint32_t entry) const { return m_offsets[entry]; }
+	inline size_t getDataSize() const { return m_dataSize; }
+	inline VkDescriptorUpdateTemplate getTemplate() const { return m_template; }
+
+private:
+	std::vector<size_t> m_offsets;
+	size_t m_dataSize = 0;
+	VkDescriptorUpdateTemplate m_template = VK_NULL_HANDLE;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
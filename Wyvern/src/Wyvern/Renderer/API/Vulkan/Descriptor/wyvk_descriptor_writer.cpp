@@ -0,0 +1,113 @@
+#include "wyvk_descriptor_writer.h"
+
+namespace Wyvern {
+
+WYVKDescriptorWriter::WYVKDescriptorWriter(WYVKDevice& device)
+    : m_device(device)
+{
+}
+
+WYVKDescriptorWriter& WYVKDescriptorWriter::writeBuffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+    VkDeviceSize offset, VkDeviceSize range, uint32_t arrayElement)
+{
+    WYVERN_ASSERT((!isImageDescriptor(type)), "writeBuffer() called with an image descriptor type");
+    m_bufferInfos.push_back({ buffer, offset, range });
+    addWrite(set, binding, type, arrayElement, static_cast<uint32_t>(m_bufferInfos.size() - 1));
+    return *this;
+}
+
+WYVKDescriptorWriter& WYVKDescriptorWriter::writeImage(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkImageView imageView,
+    VkSampler sampler, VkImageLayout imageLayout, uint32_t arrayElement)
+{
+    WYVERN_ASSERT(isImageDescriptor(type), "writeImage() called with a buffer descriptor type");
+    m_imageInfos.push_back({ sampler, imageView, imageLayout });
+    addWrite(set, binding, type, arrayElement, static_cast<uint32_t>(m_imageInfos.size() - 1));
+    return *this;
+}
+
+WYVKDescriptorWriter& WYVKDescriptorWriter::copy(VkDescriptorSet srcSet, uint32_t srcBinding, VkDescriptorSet dstSet, uint32_t dstBinding,
+    uint32_t count, uint32_t srcArrayElement, uint32_t dstArrayElement)
+{
+    VkCopyDescriptorSet setCopy{};
+    setCopy.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    setCopy.srcSet = srcSet;
+    setCopy.srcBinding = srcBinding;
+    setCopy.srcArrayElement = srcArrayElement;
+    setCopy.dstSet = dstSet;
+    setCopy.dstBinding = dstBinding;
+    setCopy.dstArrayElement = dstArrayElement;
+    setCopy.descriptorCount = count;
+    m_copies.push_back(setCopy);
+    return *this;
+}
+
+void WYVKDescriptorWriter::flush()
+{
+    if (m_writes.empty() && m_copies.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < m_writes.size(); i++) {
+        if (isImageDescriptor(m_writes[i].descriptorType)) {
+            m_writes[i].pImageInfo = &m_imageInfos[m_writeInfoIndices[i]];
+        }
+        else {
+            m_writes[i].pBufferInfo = &m_bufferInfos[m_writeInfoIndices[i]];
+        }
+    }
+
+    vkUpdateDescriptorSets(m_device.getLogicalDevice(), static_cast<uint32_t>(m_writes.size()), m_writes.data(),
+        static_cast<uint32_t>(m_copies.size()), m_copies.data());
+    m_flushCount++;
+    clear();
+}
+
+void WYVKDescriptorWriter::clear()
+{
+    // clear() keeps the capacity, so the next batch of the same size does not allocate
+    m_writes.clear();
+    m_writeInfoIndices.clear();
+    m_bufferInfos.clear();
+    m_imageInfos.clear();
+    m_copies.clear();
+}
+
+bool WYVKDescriptorWriter::isImageDescriptor(VkDescriptorType type)
+{
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void WYVKDescriptorWriter::addWrite(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, uint32_t arrayElement, uint32_t infoIndex)
+{
+    // The infos of a write have to be contiguous, which they are if the previous info of this kind belongs to the last write
+    if (!m_writes.empty()) {
+        VkWriteDescriptorSet& last = m_writes.back();
+        bool continuesLast = last.dstSet == set && last.dstBinding == binding && last.descriptorType == type &&
+            last.dstArrayElement + last.descriptorCount == arrayElement && m_writeInfoIndices.back() + last.descriptorCount == infoIndex;
+        if (continuesLast) {
+            last.descriptorCount++;
+            return;
+        }
+    }
+
+    VkWriteDescriptorSet setWrite{};
+    setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    setWrite.dstSet = set;
+    setWrite.dstBinding = binding;
+    setWrite.dstArrayElement = arrayElement;
+    setWrite.descriptorCount = 1;
+    setWrite.descriptorType = type;
+    m_writes.push_back(setWrite);
+    m_writeInfoIndices.push_back(infoIndex);
+}
+
+}
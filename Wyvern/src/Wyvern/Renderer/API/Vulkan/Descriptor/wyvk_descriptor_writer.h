@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+
+namespace Wyvern {
+
+/*
+* Collects descriptor writes & copies and issues them with a single vkUpdateDescriptorSets on flush(), instead of one driver call per
+* binding like WYVKDescriptorSet::updateBinding.
+*
+* The writes, copies and their buffer/image infos live in arrays that keep their capacity across flushes, so a writer that is reused
+* (e.g. one per frame) stops allocating once it has seen its largest batch. Info pointers are only resolved in flush(), the arrays
+* may move while a batch is collected.
+*
+* Writes to consecutive array elements of the same binding are merged into one VkWriteDescriptorSet.
+*
+*     writer.writeBuffer(set, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, camera, 0, sizeof(CameraBuffer))
+*           .writeImage(set, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, albedoView, sampler)
+*           .flush();
+*
+* Not thread safe
+*/
+class WYVKDescriptorWriter
+{
+public:
+	WYVKDescriptorWriter(WYVKDevice& device);
+
+	WYVKDescriptorWriter& writeBuffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+		VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE, uint32_t arrayElement = 0);
+
+	/*
+	* For samplers, sampled/storage images, combined image samplers & input attachments. Unused handles can be VK_NULL_HANDLE
+	*/
+	WYVKDescriptorWriter& writeImage(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkImageView imageView,
+		VkSampler sampler = VK_NULL_HANDLE, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, uint32_t arrayElement = 0);
+
+	WYVKDescriptorWriter& copy(VkDescriptorSet srcSet, uint32_t srcBinding, VkDescriptorSet dstSet, uint32_t dstBinding,
+		uint32_t count = 1, uint32_t srcArrayElement = 0, uint32_t dstArrayElement = 0);
+
+	/*
+	* Issues every collected write & copy with one vkUpdateDescriptorSets and starts a new batch. Does nothing if the batch is empty
+	*/
+	void flush();
+
+	/*
+	* Drops the collected writes & copies without issuing them
+	*/
+	void clear();
+
+	inline uint32_t getPendingWriteCount() const { return static_cast<uint32_t>(m_writes.size()); }
+	inline uint32_t getPendingCopyCount() const { return static_cast<uint32_t>(m_copies.size()); }
+	inline uint64_t getFlushCount() const { return m_flushCount; } // vkUpdateDescriptorSets calls since creation
+
+	static bool isImageDescriptor(VkDescriptorType type);
+
+private:
+	// Appends to the last write if it continues it, otherwise starts a new one
+	void addWrite(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, uint32_t arrayElement, uint32_t infoIndex);
+
+	std::vector<VkWriteDescriptorSet> m_writes;			// pBufferInfo/pImageInfo are set in flush()
+	std::vector<uint32_t> m_writeInfoIndices;			// First info of each write in m_bufferInfos or m_imageInfos
+	std::vector<VkDescriptorBufferInfo> m_bufferInfos;
+	std::vector<VkDescriptorImageInfo> m_imageInfos;
+	std::vector<VkCopyDescriptorSet> m_copies;
+	uint64_t m_flushCount = 0;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
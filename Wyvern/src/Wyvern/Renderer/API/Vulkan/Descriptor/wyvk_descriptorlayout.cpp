@@ -15,13 +15,23 @@ WYVKDescriptorLayout::~WYVKDescriptorLayout()
 
 void WYVKDescriptorLayout::addBinding(uint32_t binding, uint32_t descriptorCount, VkDescriptorType type, VkShaderStageFlags shaderFlags)
 {
-    VkDescriptorSetLayoutBinding camBufferBinding = {};
-    camBufferBinding.binding = binding;
-    camBufferBinding.descriptorCount = descriptorCount;
-    camBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; // Uniform type
-    camBufferBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // Used in the vertex shader
+    VkDescriptorSetLayoutBinding layoutBinding = {};
+    layoutBinding.binding = binding;
+    layoutBinding.descriptorCount = descriptorCount;
+    layoutBinding.descriptorType = type; // e.g. uniform or storage buffer
+    layoutBinding.stageFlags = shaderFlags; // Shader stages that can access the binding
 
-    m_bindings.push_back(camBufferBinding);
+    m_bindings.push_back(layoutBinding);
+}
+
+void WYVKDescriptorLayout::addBindings(const WYVKShaderReflection::Reflection& reflection, uint32_t set, uint32_t runtimeArraySize)
+{
+    for (const auto& binding : reflection.bindings) {
+        if (binding.set != set) {
+            continue;
+        }
+        addBinding(binding.binding, binding.count == 0 ? runtimeArraySize : binding.count, binding.type, binding.stages);
+    }
 }
 
 void WYVKDescriptorLayout::createLayout()
@@ -1,6 +1,7 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
+#include "../Pipelines/wyvk_shader_reflection.h"
 
 namespace Wyvern {
 
@@ -11,6 +12,10 @@ public:
 	~WYVKDescriptorLayout();
 
 	void addBinding(uint32_t binding, uint32_t descriptorCount, VkDescriptorType type, VkShaderStageFlags shaderFlags);
+	/*
+	* Adds every binding of descriptor set `set` found in `reflection`. Runtime sized arrays get `runtimeArraySize` descriptors
+	*/
+	void addBindings(const WYVKShaderReflection::Reflection& reflection, uint32_t set = 0, uint32_t runtimeArraySize = 1);
 	void createLayout();
 
 	inline VkDescriptorSetLayout& getLayout() { return m_layout; }
@@ -7,15 +7,27 @@ WYVKDescriptorPool::WYVKDescriptorPool(WYVKDevice& device, uint32_t descriptorCo
 {
 	std::vector<VkDescriptorPoolSize> sizes =
 	{
-		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, descriptorCount } // Holds 10 uniform buffers/descriptors! NOT descriptor sets
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, descriptorCount }, // Holds 10 uniform buffers/descriptors! NOT descriptor sets
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, descriptorCount }, // Per draw data for indirect draws
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, descriptorCount } // Per object data addressed with dynamic offsets
 	};
+	createPool(sizes, maxDescriptorSets);
+}
+
+WYVKDescriptorPool::WYVKDescriptorPool(WYVKDevice& device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxDescriptorSets)
+	: m_device(device)
+{
+	createPool(poolSizes, maxDescriptorSets);
+}
 
+void WYVKDescriptorPool::createPool(const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxDescriptorSets)
+{
 	VkDescriptorPoolCreateInfo pool_info = {};
 	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	pool_info.flags = 0;
 	pool_info.maxSets = maxDescriptorSets; // Maximum amount of descriptor SETS
-	pool_info.poolSizeCount = (uint32_t)sizes.size();
-	pool_info.pPoolSizes = sizes.data();
+	pool_info.poolSizeCount = (uint32_t)poolSizes.size();
+	pool_info.pPoolSizes = poolSizes.data();
 
 	VK_CALL(vkCreateDescriptorPool(m_device.getLogicalDevice(), &pool_info, nullptr, &m_descriptorPool), "Unable to create descriptor pool!");
 }
@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 
 namespace Wyvern {
@@ -8,11 +8,17 @@ class WYVKDescriptorPool
 {
 public:
 	WYVKDescriptorPool(WYVKDevice& device, uint32_t descriptorCount, uint32_t maxDescriptorSets);
+	/*
+	* Pool with exactly the given sizes, e.g. from WYVKShaderReflection::Reflection::getPoolSizes()
+	*/
+	WYVKDescriptorPool(WYVKDevice& device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxDescriptorSets);
 	~WYVKDescriptorPool();
 
 	inline VkDescriptorPool& getDescriptorPool() { return m_descriptorPool; }
 
 private:
+	void createPool(const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxDescriptorSets);
+
 	VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
 
 	// Handles
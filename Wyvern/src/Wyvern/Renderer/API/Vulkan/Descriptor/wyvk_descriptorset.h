@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 #include "wyvk_descriptorpool.h"
 #include "wyvk_descriptorlayout.h"
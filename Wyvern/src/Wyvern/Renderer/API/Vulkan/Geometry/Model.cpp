@@ -5,12 +5,27 @@ namespace Wyvern {
 Model::Model(WYVKRenderer& renderer, const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices)
 	: m_vertexCount(vertices.size()),
 	m_indexCount(indices.size()),
-	m_vertexSize(sizeof(vertices[0]) * m_vertexCount),
-	m_indexSize(sizeof(indices[0]) * m_indexCount),
 	m_renderer(renderer)
 {
-	m_vertexBuffer.reset(m_renderer.createVertexBuffer((void*)vertices.data(), m_vertexSize));
-	m_indexBuffer.reset(m_renderer.createIndexBuffer((void*)indices.data(), m_indexSize));
+	m_mesh = m_renderer.createMesh(vertices, indices, &m_uploadTicket);
 }  
 
+Model::Model(Model&& other) noexcept
+	: m_mesh(other.m_mesh),
+	m_vertexCount(other.m_vertexCount),
+	m_indexCount(other.m_indexCount),
+	m_transform(other.m_transform),
+	m_uploadTicket(other.m_uploadTicket),
+	m_renderer(other.m_renderer)
+{
+	other.m_mesh = WYVKGeometryArena::INVALID_MESH;
+}
+
+Model::~Model()
+{
+	if (m_mesh != WYVKGeometryArena::INVALID_MESH) {
+		m_renderer.destroyMesh(m_mesh);
+	}
+}
+
 }
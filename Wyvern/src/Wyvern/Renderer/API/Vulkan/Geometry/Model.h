@@ -1,35 +1,46 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "vertex_geometry.h"
 #include "../wyvk_renderer.h"
 
 namespace Wyvern {
 
+/*
+* Lightweight handle to a mesh living in the renderer's geometry arena. The model owns no buffers of its own, its data is drawn
+* with the arena bound and the mesh's firstIndex/vertexOffset. Offsets are looked up through the handle since defragmenting the
+* arena moves meshes around.
+*/
 class Model
 {
 public:
 	Model(WYVKRenderer& renderer, const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices);
+	Model(Model&& other) noexcept;
+	~Model();
 
-	inline VkBuffer* getVertexBuffer() { return &m_vertexBuffer.get()->getBuffer(); }
-	inline VkBuffer* getIndexBuffer() { return &m_indexBuffer.get()->getBuffer(); }
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
 
-	inline size_t getVertexBuffersCount() { return 1; } // were doing interleaved attributes for now so we will only need 1 buffer
-	inline size_t getVertexCount() { return m_vertexCount; }
-	inline size_t getIndexCount() { return m_indexCount; }
-	inline size_t getVertexSize() { return m_vertexSize; }
-	inline size_t getIndexSize() { return m_indexSize; }
-	inline VkDeviceSize* getVertexOffsets() { return { 0 }; }
+	inline WYVKGeometryArena::MeshHandle getMesh() const { return m_mesh; }
+	inline uint32_t getFirstIndex() const { return m_renderer.getGeometryArena().getMesh(m_mesh).firstIndex; }
+	inline int32_t getVertexOffset() const { return m_renderer.getGeometryArena().getMesh(m_mesh).vertexOffset; }
+
+	inline size_t getVertexCount() const { return m_vertexCount; }
+	inline size_t getIndexCount() const { return m_indexCount; }
+
+	// Model matrix. Read per draw from the indirect draw data or the frame's object arena
+	inline glm::mat4& getTransform() { return m_transform; }
+
+	// True once the vertex & index data uploaded on the transfer queue has landed on the GPU
+	inline bool isUploaded() { return m_renderer.isUploadComplete(m_uploadTicket); }
 
 private:
-	std::unique_ptr<WYVKBuffer> m_vertexBuffer;
-	std::unique_ptr<WYVKBuffer> m_indexBuffer;
+	WYVKGeometryArena::MeshHandle m_mesh = WYVKGeometryArena::INVALID_MESH;
 	size_t m_vertexCount = 0;
 	size_t m_indexCount = 0;
-	size_t m_vertexSize = 0;
-	size_t m_indexSize = 0;
+	glm::mat4 m_transform = glm::mat4(1.0f);
+	WYVKStagingRing::UploadTicket m_uploadTicket; // Ticket of the last upload (index data). Tickets complete in order
 
 	WYVKRenderer& m_renderer;
 };
 
 }
-
@@ -0,0 +1,260 @@
+#include "wyvk_geometry_arena.h"
+
+namespace Wyvern {
+
+WYVKGeometryArena::WYVKGeometryArena(WYVKDevice& device, uint32_t vertexCapacity, uint32_t indexCapacity)
+	: m_vertexCapacity(vertexCapacity),
+	m_indexCapacity(indexCapacity),
+	m_device(device)
+{
+	m_vertexBuffer = createVertexBuffer();
+	m_indexBuffer = createIndexBuffer();
+	m_vertexRanges.reset(m_vertexCapacity);
+	m_indexRanges.reset(m_indexCapacity);
+
+	WYVERN_LOG_INFO("Created geometry arena ({} vertices | {} indices)", m_vertexCapacity, m_indexCapacity);
+}
+
+WYVKGeometryArena::~WYVKGeometryArena()
+{
+	// Meshes released during the last frames are only waiting on retire()
+	if (m_liveMeshes > m_pendingReleases.size()) {
+		WYVERN_LOG_WARN("Destroying geometry arena with {} meshes still alive", m_liveMeshes - m_pendingReleases.size());
+	}
+}
+
+std::unique_ptr<WYVKBuffer> WYVKGeometryArena::createVertexBuffer()
+{
+	// TRANSFER_SRC so defragment() can copy out of it
+	return std::make_unique<WYVKBuffer>(m_device, static_cast<VkDeviceSize>(m_vertexCapacity) * sizeof(Vertex),
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		WYVKMemoryPolicy::ResourceUsage::STATIC_GEOMETRY);
+}
+
+std::unique_ptr<WYVKBuffer> WYVKGeometryArena::createIndexBuffer()
+{
+	return std::make_unique<WYVKBuffer>(m_device, static_cast<VkDeviceSize>(m_indexCapacity) * sizeof(Index),
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		WYVKMemoryPolicy::ResourceUsage::STATIC_GEOMETRY);
+}
+
+bool WYVKGeometryArena::allocate(uint32_t vertexCount, uint32_t indexCount, MeshHandle& outHandle)
+{
+	uint32_t vertexOffset = 0;
+	uint32_t firstIndex = 0;
+	if (!m_vertexRanges.allocate(vertexCount, vertexOffset)) {
+		return false;
+	}
+	if (!m_indexRanges.allocate(indexCount, firstIndex)) {
+		m_vertexRanges.free(vertexOffset, vertexCount);
+		return false;
+	}
+
+	if (m_freeHandles.empty()) {
+		outHandle = static_cast<MeshHandle>(m_meshes.size());
+		m_meshes.emplace_back();
+	}
+	else {
+		outHandle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+
+	Mesh& mesh = m_meshes[outHandle];
+	mesh.vertexOffset = static_cast<int32_t>(vertexOffset);
+	mesh.vertexCount = vertexCount;
+	mesh.firstIndex = firstIndex;
+	mesh.indexCount = indexCount;
+	mesh.alive = true;
+	m_liveMeshes++;
+	return true;
+}
+
+void WYVKGeometryArena::release(MeshHandle handle, uint64_t frameSerial)
+{
+	// Freeing the same ranges twice would put them in the free list twice and hand them to two meshes later
+	if (handle >= m_meshes.size() || !m_meshes[handle].alive || m_meshes[handle].released) {
+		WYVERN_LOG_ERROR("Releasing mesh {} which is not alive or was already released", handle);
+		WYVERN_THROW("Releasing a mesh that is not alive!");
+	}
+	m_meshes[handle].released = true;
+	m_pendingReleases.push_back({ frameSerial, handle });
+}
+
+void WYVKGeometryArena::retire(uint64_t completedSerial)
+{
+	while (!m_pendingReleases.empty() && m_pendingReleases.front().frameSerial <= completedSerial) {
+		freeMesh(m_pendingReleases.front().handle);
+		m_pendingReleases.pop_front();
+	}
+	while (!m_retiredBuffers.empty() && m_retiredBuffers.front().serial <= completedSerial) {
+		m_retiredBuffers.pop_front();
+	}
+}
+
+void WYVKGeometryArena::freeMesh(MeshHandle handle)
+{
+	Mesh& mesh = m_meshes[handle];
+	m_vertexRanges.free(static_cast<uint32_t>(mesh.vertexOffset), mesh.vertexCount);
+	m_indexRanges.free(mesh.firstIndex, mesh.indexCount);
+	mesh = Mesh{};
+	m_freeHandles.push_back(handle);
+	m_liveMeshes--;
+}
+
+bool WYVKGeometryArena::canFit(uint32_t vertexCount, uint32_t indexCount) const
+{
+	return vertexCount <= m_vertexRanges.getFreeTotal() && indexCount <= m_indexRanges.getFreeTotal();
+}
+
+void WYVKGeometryArena::defragment(VkCommandBuffer cmd, uint64_t serial)
+{
+	// The GPU is idle, so nothing released can still be in use
+	while (!m_pendingReleases.empty()) {
+		freeMesh(m_pendingReleases.front().handle);
+		m_pendingReleases.pop_front();
+	}
+
+	std::unique_ptr<WYVKBuffer> vertexBuffer = createVertexBuffer();
+	std::unique_ptr<WYVKBuffer> indexBuffer = createIndexBuffer();
+
+	std::vector<VkBufferCopy> vertexCopies;
+	std::vector<VkBufferCopy> indexCopies;
+	uint32_t vertexHead = 0;
+	uint32_t indexHead = 0;
+
+	// Meshes are packed in handle order. Regions never overlap since source and destination are different buffers
+	for (Mesh& mesh : m_meshes) {
+		if (!mesh.alive) {
+			continue;
+		}
+		if (mesh.vertexCount > 0) {
+			vertexCopies.push_back({ static_cast<VkDeviceSize>(mesh.vertexOffset) * sizeof(Vertex), static_cast<VkDeviceSize>(vertexHead) * sizeof(Vertex), static_cast<VkDeviceSize>(mesh.vertexCount) * sizeof(Vertex) });
+		}
+		if (mesh.indexCount > 0) {
+			indexCopies.push_back({ static_cast<VkDeviceSize>(mesh.firstIndex) * sizeof(Index), static_cast<VkDeviceSize>(indexHead) * sizeof(Index), static_cast<VkDeviceSize>(mesh.indexCount) * sizeof(Index) });
+		}
+		mesh.vertexOffset = static_cast<int32_t>(vertexHead);
+		mesh.firstIndex = indexHead;
+		vertexHead += mesh.vertexCount;
+		indexHead += mesh.indexCount;
+	}
+
+	// Make every earlier write into the arena (uploads, ownership acquires) visible to the copies
+	VkMemoryBarrier srcBarrier{};
+	srcBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	srcBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	srcBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &srcBarrier, 0, nullptr, 0, nullptr);
+
+	if (!vertexCopies.empty()) {
+		vkCmdCopyBuffer(cmd, m_vertexBuffer->getBuffer(), vertexBuffer->getBuffer(), static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+	}
+	if (!indexCopies.empty()) {
+		vkCmdCopyBuffer(cmd, m_indexBuffer->getBuffer(), indexBuffer->getBuffer(), static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+	}
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// All free space is now a single range at the end of each buffer
+	m_vertexRanges.reset(m_vertexCapacity);
+	m_indexRanges.reset(m_indexCapacity);
+	uint32_t offset = 0;
+	if (vertexHead > 0) {
+		m_vertexRanges.allocate(vertexHead, offset);
+	}
+	if (indexHead > 0) {
+		m_indexRanges.allocate(indexHead, offset);
+	}
+
+	m_retiredBuffers.push_back({ serial, std::move(m_vertexBuffer), std::move(m_indexBuffer) });
+	m_vertexBuffer = std::move(vertexBuffer);
+	m_indexBuffer = std::move(indexBuffer);
+
+	WYVERN_LOG_INFO("Defragmented geometry arena: {} meshes | {} vertices | {} indices", m_liveMeshes, vertexHead, indexHead);
+}
+
+void WYVKGeometryArena::bind(VkCommandBuffer cmd)
+{
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(cmd, 0, 1, &m_vertexBuffer->getBuffer(), &offset);
+	vkCmdBindIndexBuffer(cmd, m_indexBuffer->getBuffer(), 0, INDEX_TYPE);
+}
+
+float WYVKGeometryArena::getFragmentation() const
+{
+	auto fragmentation = [](const FreeList& ranges) {
+		return ranges.getFreeTotal() == 0 ? 0.0f : 1.0f - static_cast<float>(ranges.getLargestFree()) / ranges.getFreeTotal();
+	};
+	return std::max(fragmentation(m_vertexRanges), fragmentation(m_indexRanges));
+}
+
+void WYVKGeometryArena::FreeList::reset(uint32_t capacity)
+{
+	m_freeRanges.clear();
+	m_freeRanges[0] = capacity;
+	m_freeTotal = capacity;
+}
+
+bool WYVKGeometryArena::FreeList::allocate(uint32_t size, uint32_t& outOffset)
+{
+	if (size == 0) {
+		outOffset = 0;
+		return true;
+	}
+
+	for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+		if (it->second < size) {
+			continue;
+		}
+		outOffset = it->first;
+		uint32_t remaining = it->second - size;
+		m_freeRanges.erase(it);
+		if (remaining > 0) {
+			m_freeRanges[outOffset + size] = remaining;
+		}
+		m_freeTotal -= size;
+		return true;
+	}
+	return false;
+}
+
+void WYVKGeometryArena::FreeList::free(uint32_t offset, uint32_t size)
+{
+	if (size == 0) {
+		return;
+	}
+	m_freeTotal += size;
+
+	auto next = m_freeRanges.lower_bound(offset);
+
+	// Merge with the range right after
+	if (next != m_freeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		next = m_freeRanges.erase(next);
+	}
+
+	// Merge with the range right before
+	if (next != m_freeRanges.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
+		}
+	}
+	m_freeRanges[offset] = size;
+}
+
+uint32_t WYVKGeometryArena::FreeList::getLargestFree() const
+{
+	uint32_t largest = 0;
+	for (const auto& range : m_freeRanges) {
+		largest = std::max(largest, range.second);
+	}
+	return largest;
+}
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "../Memory/buffer.h"
+#include "vertex_geometry.h"
+
+namespace Wyvern {
+
+/*
+* Shared vertex and index buffers that every mesh is sub-allocated from, so models no longer own buffers of their own.
+* The arena is bound once per command buffer and meshes are drawn with their firstIndex/vertexOffset, which lets all of them
+* go out in the same indirect draw.
+*
+* Ranges are handed out by a first fit free list (in elements, not bytes) that merges neighbouring free ranges on release.
+* Meshes are referenced through handles since defragment() moves them around. Releasing a mesh is deferred until the GPU
+* is done with the frame it was released in, the same way the staging ring reclaims space.
+*/
+class WYVKGeometryArena
+{
+public:
+	using MeshHandle = uint32_t;
+	static constexpr MeshHandle INVALID_MESH = UINT32_MAX;
+
+	static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1024 * 1024;		// 24MB of Vertex
+	static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 4 * 1024 * 1024;	// 8MB of 16 bit indices
+	static constexpr VkIndexType INDEX_TYPE = VK_INDEX_TYPE_UINT16;
+	using Index = uint16_t;
+
+	// Location of a mesh inside the arena. Ready to be passed to vkCmdDrawIndexed
+	struct Mesh {
+		int32_t vertexOffset = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		bool alive = false;
+		bool released = false;	// Still alive until retire() frees it, but can't be released again
+	};
+
+	WYVKGeometryArena(WYVKDevice& device, uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY, uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+	~WYVKGeometryArena();
+
+	/*
+	* Reserves room for a mesh. Returns false if either buffer has no free range that is large enough,
+	* check canFit() to know whether defragment() would make room
+	*/
+	bool allocate(uint32_t vertexCount, uint32_t indexCount, MeshHandle& outHandle);
+
+	/*
+	* Frees the mesh once the frame with serial `frameSerial` has finished on the GPU (see retire()).
+	* Throws if the mesh is not alive or was already released
+	*/
+	void release(MeshHandle handle, uint64_t frameSerial);
+
+	/*
+	* Returns the ranges of every mesh released in a frame up to `completedSerial` to the free lists
+	*/
+	void retire(uint64_t completedSerial);
+
+	/*
+	* True if there is enough free space in total for the mesh, even if it is split up into ranges that are too small
+	*/
+	bool canFit(uint32_t vertexCount, uint32_t indexCount) const;
+
+	/*
+	* Packs every live mesh to the front of new vertex & index buffers and records the copies into `cmd`.
+	* The GPU must be idle and every upload into the arena must have completed. Pending releases are applied right away,
+	* and the old buffers are destroyed once `serial` is retired
+	*/
+	void defragment(VkCommandBuffer cmd, uint64_t serial);
+
+	/*
+	* Binds the shared vertex & index buffers
+	*/
+	void bind(VkCommandBuffer cmd);
+
+	inline const Mesh& getMesh(MeshHandle handle) const { return m_meshes[handle]; }
+	inline WYVKBuffer& getVertexBuffer() { return *m_vertexBuffer; }
+	inline WYVKBuffer& getIndexBuffer() { return *m_indexBuffer; }
+
+	inline uint32_t getVertexCapacity() const { return m_vertexCapacity; }
+	inline uint32_t getIndexCapacity() const { return m_indexCapacity; }
+	inline uint32_t getUsedVertices() const { return m_vertexCapacity - m_vertexRanges.getFreeTotal(); }
+	inline uint32_t getUsedIndices() const { return m_indexCapacity - m_indexRanges.getFreeTotal(); }
+	inline uint32_t getMeshCount() const { return m_liveMeshes; }
+
+	/*
+	* 0 when all free space is one range, close to 1 when the free space is scattered into many small ranges.
+	* Takes the worse of the vertex & index buffers
+	*/
+	float getFragmentation() const;
+
+private:
+	// First fit free list over [0, capacity). Free ranges are kept sorted by offset so neighbours can be merged
+	class FreeList
+	{
+	public:
+		void reset(uint32_t capacity);
+		bool allocate(uint32_t size, uint32_t& outOffset);
+		void free(uint32_t offset, uint32_t size);
+
+		inline uint32_t getFreeTotal() const { return m_freeTotal; }
+		uint32_t getLargestFree() const;
+
+	private:
+		std::map<uint32_t, uint32_t> m_freeRanges; // offset -> size
+		uint32_t m_freeTotal = 0;
+	};
+
+	struct PendingRelease {
+		uint64_t frameSerial;
+		MeshHandle handle;
+	};
+
+	struct RetiredBuffers {
+		uint64_t serial;
+		std::unique_ptr<WYVKBuffer> vertexBuffer;
+		std::unique_ptr<WYVKBuffer> indexBuffer;
+	};
+
+	std::unique_ptr<WYVKBuffer> createVertexBuffer();
+	std::unique_ptr<WYVKBuffer> createIndexBuffer();
+	void freeMesh(MeshHandle handle);
+
+	uint32_t m_vertexCapacity;
+	uint32_t m_indexCapacity;
+	std::unique_ptr<WYVKBuffer> m_vertexBuffer;
+	std::unique_ptr<WYVKBuffer> m_indexBuffer;
+	FreeList m_vertexRanges;
+	FreeList m_indexRanges;
+
+	std::vector<Mesh> m_meshes;
+	std::vector<MeshHandle> m_freeHandles;
+	uint32_t m_liveMeshes = 0;
+
+	std::deque<PendingRelease> m_pendingReleases;
+	std::deque<RetiredBuffers> m_retiredBuffers;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -3,12 +3,32 @@
 namespace Wyvern {
 
 WYVKBuffer::WYVKBuffer(WYVKDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
-    : m_device(device),
-    m_size(size)
+    : m_size(size),
+    m_device(device)
+{
+    VkMemoryRequirements memRequirements = createBuffer(usage);
+
+    // Sub-allocate from one of the allocator's blocks instead of owning a whole VkDeviceMemory
+    m_allocation = m_device.getAllocator().allocate(memRequirements, properties, WYVKAllocator::ResourceKind::LINEAR);
+    VK_CALL(vkBindBufferMemory(m_device.getLogicalDevice(), m_buffer, m_allocation.memory, m_allocation.offset), "Unable to bind buffer memory!");
+}
+
+WYVKBuffer::WYVKBuffer(WYVKDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, WYVKMemoryPolicy::ResourceUsage resourceUsage)
+    : m_size(size),
+    m_device(device)
+{
+    VkMemoryRequirements memRequirements = createBuffer(usage);
+
+    m_placement = m_device.getMemoryPolicy().getPlacement(resourceUsage);
+    m_allocation = m_device.getAllocator().allocate(memRequirements, m_placement, WYVKAllocator::ResourceKind::LINEAR);
+    VK_CALL(vkBindBufferMemory(m_device.getLogicalDevice(), m_buffer, m_allocation.memory, m_allocation.offset), "Unable to bind buffer memory!");
+}
+
+VkMemoryRequirements WYVKBuffer::createBuffer(VkBufferUsageFlags usage)
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = size; // size in bytes
+    bufferInfo.size = m_size; // size in bytes
     bufferInfo.usage = usage; // usage of data. e.g. for vertex data, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
@@ -18,14 +38,7 @@ WYVKBuffer::WYVKBuffer(WYVKDevice& device, VkDeviceSize size, VkBufferUsageFlags
 
     VkMemoryRequirements memRequirements; // size, alignment, usage/flags, memoryTypeBits
     vkGetBufferMemoryRequirements(m_device.getLogicalDevice(), m_buffer, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    VK_CALL(vkAllocateMemory(m_device.getLogicalDevice(), &allocInfo, nullptr, &m_bufferMemory), "Failed to allocate buffer memory!");
-    VK_CALL(vkBindBufferMemory(m_device.getLogicalDevice(), m_buffer, m_bufferMemory, 0), "Unable to bind buffer memory!");
+    return memRequirements;
 }
 
 WYVKBuffer::~WYVKBuffer()
@@ -36,65 +49,23 @@ WYVKBuffer::~WYVKBuffer()
 
 void WYVKBuffer::assignMemory(void* srcData)
 {
-    void* deviceData; // will hold address of device memory, accessible to the application
-    VK_CALL(vkMapMemory(m_device.getLogicalDevice(), m_bufferMemory, 0, m_size, 0, &deviceData), "Unable to map memory!"); // gets address of device memory and stores in deviceData
-    memcpy(deviceData, srcData, (size_t) m_size); // Copy data from srcData to the device memory
-    vkUnmapMemory(m_device.getLogicalDevice(), m_bufferMemory); // unmap the pointer so it is no longer accessible
+    // Host visible blocks are persistently mapped by the allocator, so we can copy straight into our sub-range
+    if (m_allocation.mappedData == nullptr) {
+        WYVERN_LOG_ERROR("Unable to assign memory to a buffer that is not host visible!");
+        WYVERN_THROW("Unable to assign memory to a buffer that is not host visible!");
+    }
+    memcpy(m_allocation.mappedData, srcData, (size_t) m_size); // Copy data from srcData to the device memory
 }
 
 void WYVKBuffer::freeMemory()
 {
-    vkFreeMemory(m_device.getLogicalDevice(), m_bufferMemory, nullptr);
-}
-
-void WYVKBuffer::copyTo(VkBuffer dst, VkDeviceSize size, WYVKCommandPool& commandPool, VkFence transferFence)
-{
-    WYVKCommandBuffer cmdBuffer(m_device, commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
-    cmdBuffer.startRecording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0; // Optional
-    copyRegion.dstOffset = 0; // Optional
-    copyRegion.size = size;
-    vkCmdCopyBuffer(*cmdBuffer.getCommandBuffer(), m_buffer, dst, 1, &copyRegion);
-
-    cmdBuffer.stopRecording();
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = cmdBuffer.getCommandBuffer();
-
-    vkQueueSubmit(m_device.getGraphicsQueue(), 1, &submitInfo, transferFence);
-
-    // Waits for transfer to finish with fence
-    VK_CALL(vkWaitForFences(m_device.getLogicalDevice(), 1, &transferFence, VK_TRUE, UINT64_MAX), "Failed to wait for transfer fence!");
-    VK_CALL(vkResetFences(m_device.getLogicalDevice(), 1, &transferFence), "Failed to reset transfer fence!");
-}
-
-void WYVKBuffer::copyTo(WYVKBuffer& dst, VkDeviceSize size, WYVKCommandPool& commandPool, VkFence transferFence)
-{
-    copyTo(dst.getBuffer(), size, commandPool, transferFence);
+    m_device.getAllocator().free(m_allocation);
 }
 
 void WYVKBuffer::createPersistentMapping()
 {
-    vkMapMemory(m_device.getLogicalDevice(), m_bufferMemory, 0, m_size, 0, &m_mappedMemory);
-}
-
-uint32_t WYVKBuffer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
-{
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(m_device.getPhysicalDevice(), &memProperties);
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-
-    WYVERN_LOG_ERROR("Unable to find suitable memory type for buffer generation!");
-    WYVERN_THROW("Unable to find suitable memory type for buffer generation!");
+    // The block backing this buffer is already mapped for its whole lifetime
+    m_mappedMemory = m_allocation.mappedData;
 }
 
 }
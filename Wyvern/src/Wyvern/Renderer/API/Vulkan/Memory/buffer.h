@@ -1,6 +1,7 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
+#include "wyvk_allocator.h"
 #include "../Command/wyvk_commandpool.h"
 #include "../Command/wyvk_commandbuffer.h"
 
@@ -14,26 +15,21 @@ class WYVKBuffer
 {
 public:
     WYVKBuffer(WYVKDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
-    ~WYVKBuffer();
-
-    /*
-    * Copies buffer contents from src to dst. This function is mainly used for copying info from
-    * a staging buffer to a vertex buffer or other buffer
-    */
-    void copyTo(VkBuffer dst, VkDeviceSize size, WYVKCommandPool& commandPool, VkFence transferFence);
 
     /*
-    * Wrapper for `copyTo` to accept the WYVKBuffer type
+    * Creates a buffer whose memory placement is decided by the device's memory policy.
+    * Check `needsStaging()` to know whether the data has to be uploaded through a staging buffer or can be written directly
     */
-    void copyTo(WYVKBuffer& dst, VkDeviceSize size, WYVKCommandPool& commandPool, VkFence transferFence);
+    WYVKBuffer(WYVKDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, WYVKMemoryPolicy::ResourceUsage resourceUsage);
+    ~WYVKBuffer();
 
     /*
-    * Copies data from srcData to the device memory at m_bufferMemory 
+    * Copies data from srcData to the device memory backing this buffer
     */
     void assignMemory(void* srcData);
     
     /*
-    * Frees the data in m_bufferMemory
+    * Returns the buffer's sub-allocation to the device allocator
     */
     void freeMemory();
 
@@ -61,13 +57,20 @@ public:
         WYVERN_THROW("Unable to access uninitialized buffer handle!");
     }
 
+    inline const WYVKAllocator::Allocation& getAllocation() const { return m_allocation; }
+    inline VkDeviceSize getSize() const { return m_size; }
+    inline bool needsStaging() const { return m_allocation.mappedData == nullptr; }
+    inline const WYVKMemoryPolicy::Placement& getPlacement() const { return m_placement; }
+
 private:
-    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    // Creates the VkBuffer handle and returns its memory requirements
+    VkMemoryRequirements createBuffer(VkBufferUsageFlags usage);
 
     VkDeviceSize m_size;
     VkBuffer m_buffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_bufferMemory = VK_NULL_HANDLE;
+    WYVKAllocator::Allocation m_allocation; // Offset & size inside one of the allocator's memory blocks
     void* m_mappedMemory = nullptr; // Persistent map: Pointer to memory that can be accessed every frame by the CPU.
+    WYVKMemoryPolicy::Placement m_placement; // Only meaningful for buffers created from a ResourceUsage
 
     // Handles
     WYVKDevice& m_device;
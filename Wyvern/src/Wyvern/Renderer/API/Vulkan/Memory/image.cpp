@@ -31,7 +31,7 @@ namespace Wyvern {
         case ImageType::WYVK_DEPTH_IMAGE:
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-            imageInfo.format = findSupportedFormat(DEPTH_STENCIL_FORMATS, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+            imageInfo.format = findDepthFormat(m_device);
             break;
 
         case ImageType::WYVK_STENCIL_IMAGE:
@@ -61,8 +61,8 @@ namespace Wyvern {
         // allocate and bind memory
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(m_device.getLogicalDevice(), m_image, &memRequirements);
-        allocateMemory(memRequirements);
-        vkBindImageMemory(m_device.getLogicalDevice(), m_image, m_deviceMemory, 0);
+        allocateMemory(memRequirements, imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? WYVKAllocator::ResourceKind::OPTIMAL : WYVKAllocator::ResourceKind::LINEAR);
+        VK_CALL(vkBindImageMemory(m_device.getLogicalDevice(), m_image, m_allocation.memory, m_allocation.offset), "Unable to bind image memory!");
     }
 
     WYVKImage::~WYVKImage()
@@ -71,11 +71,11 @@ namespace Wyvern {
         vkDestroyImage(m_device.getLogicalDevice(), m_image, nullptr);
     }
 
-    VkFormat WYVKImage::findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) 
+    VkFormat WYVKImage::findSupportedFormat(WYVKDevice& device, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) 
     {
         for (VkFormat format : candidates) {
             VkFormatProperties props;
-            vkGetPhysicalDeviceFormatProperties(m_device.getPhysicalDevice(), format, &props);
+            vkGetPhysicalDeviceFormatProperties(device.getPhysicalDevice(), format, &props);
 
             if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) {
                 return format;
@@ -89,6 +89,11 @@ namespace Wyvern {
         WYVERN_THROW("Unable to find a supported image format!");
     }
 
+    VkFormat WYVKImage::findDepthFormat(WYVKDevice& device)
+    {
+        return findSupportedFormat(device, DEPTH_STENCIL_FORMATS, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    }
+
     void WYVKImage::createImageView(VkImageAspectFlags aspectFlags)
     {
         if (aspectFlags != VK_IMAGE_ASPECT_NONE) {
@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 #include "memory_resource.h"
 
@@ -20,8 +20,10 @@ namespace Wyvern {
 		WYVKImage(WYVKDevice& device, ImageType imageType, uint32_t width, uint32_t height, VkMemoryPropertyFlags properties);
 		~WYVKImage();
 
-		VkFormat findSupportedFormat(const std::vector<VkFormat>& availableFormats, VkImageTiling tiling, VkFormatFeatureFlags features);
-		bool hasStencilComponent(VkFormat format);
+		static VkFormat findSupportedFormat(WYVKDevice& device, const std::vector<VkFormat>& availableFormats, VkImageTiling tiling, VkFormatFeatureFlags features);
+		// Format WYVK_DEPTH_IMAGE images are created with
+		static VkFormat findDepthFormat(WYVKDevice& device);
+		static bool hasStencilComponent(VkFormat format);
 		inline VkFormat getFormat() { return m_format; }
 		inline VkImageView getImageView() { return m_imageView; }
 		void createImageView(VkImageAspectFlags aspectFlags);
@@ -1,7 +1,8 @@
 #pragma once
 
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
+#include "wyvk_allocator.h"
 
 namespace Wyvern {
 
@@ -14,11 +15,11 @@ namespace Wyvern {
     protected:
         uint32_t findMemoryType(uint32_t typeFilter);
         void createPersistentMapping();
-        void allocateMemory(VkMemoryRequirements properties);
+        void allocateMemory(VkMemoryRequirements properties, WYVKAllocator::ResourceKind kind);
         void freeMemory();
 
         VkDeviceSize m_size = 0;
-        VkDeviceMemory m_deviceMemory = VK_NULL_HANDLE;
+        WYVKAllocator::Allocation m_allocation; // Offset & size inside one of the allocator's memory blocks
         void* m_mappedMemory = nullptr;
         VkMemoryPropertyFlags m_properties;
 
@@ -0,0 +1,512 @@
+#include "wyvk_allocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Wyvern {
+
+namespace {
+
+// Index of the most significant set bit. `value` must not be 0
+uint32_t findLastSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+// Index of the least significant set bit. `value` must not be 0
+uint32_t findFirstSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+// ==========================================
+// WYVKMemoryBlock
+// ==========================================
+
+WYVKMemoryBlock::WYVKMemoryBlock(WYVKDevice& device, uint32_t memoryTypeIndex, VkDeviceSize size, bool hostVisible)
+    : m_size(size),
+    m_memoryTypeIndex(memoryTypeIndex),
+    m_device(device)
+{
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    VK_CALL(vkAllocateMemory(m_device.getLogicalDevice(), &allocInfo, nullptr, &m_memory), "Failed to allocate device memory block!");
+
+    if (hostVisible) {
+        VK_CALL(vkMapMemory(m_device.getLogicalDevice(), m_memory, 0, VK_WHOLE_SIZE, 0, &m_mappedData), "Unable to map device memory block!");
+    }
+
+    for (auto& heads : m_freeHeads) {
+        heads.fill(INVALID_NODE);
+    }
+
+    // The whole block starts out as one free range
+    uint32_t node = createNode();
+    m_nodes[node].offset = 0;
+    m_nodes[node].size = size;
+    insertFreeNode(node);
+}
+
+WYVKMemoryBlock::~WYVKMemoryBlock()
+{
+    if (m_allocationCount > 0) {
+        WYVERN_LOG_WARN("Destroying memory block with {} live allocations!", m_allocationCount);
+    }
+    // Freeing mapped memory implicitly unmaps it
+    vkFreeMemory(m_device.getLogicalDevice(), m_memory, nullptr);
+}
+
+bool WYVKMemoryBlock::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, uint32_t& outNode)
+{
+    // Keep every offset and size a multiple of the minimum granularity. This guarantees that the small size buckets
+    // only ever hold a single size, so anything found through mappingSearch() is large enough
+    const VkDeviceSize granularity = VkDeviceSize(1) << ALIGN_SIZE_LOG2;
+    size = alignUp(size, granularity);
+    alignment = (std::max)(alignment, granularity);
+
+    // Worst case padding needed in front of a range to reach the requested alignment
+    VkDeviceSize searchSize = size + (alignment - granularity);
+    if (searchSize > m_size - m_usedBytes) {
+        return false;
+    }
+
+    uint32_t node = findFreeNode(searchSize);
+    if (node == INVALID_NODE) {
+        return false;
+    }
+    removeFreeNode(node);
+
+    VkDeviceSize padding = alignUp(m_nodes[node].offset, alignment) - m_nodes[node].offset;
+    if (padding > 0) {
+        // Give the padding back to the free lists as its own range
+        uint32_t aligned = splitNode(node, padding);
+        insertFreeNode(node);
+        node = aligned;
+    }
+
+    uint32_t remainder = splitNode(node, size);
+    if (remainder != INVALID_NODE) {
+        insertFreeNode(remainder);
+    }
+
+    m_nodes[node].free = false;
+    m_usedBytes += m_nodes[node].size;
+    m_allocationCount++;
+
+    outOffset = m_nodes[node].offset;
+    outNode = node;
+    return true;
+}
+
+void WYVKMemoryBlock::free(uint32_t node)
+{
+    m_usedBytes -= m_nodes[node].size;
+    m_allocationCount--;
+
+    // Coalesce with free physical neighbours so that free ranges never sit next to each other
+    uint32_t prev = m_nodes[node].prevPhysical;
+    if (prev != INVALID_NODE && m_nodes[prev].free) {
+        removeFreeNode(prev);
+        node = mergeNodes(prev, node);
+    }
+
+    uint32_t next = m_nodes[node].nextPhysical;
+    if (next != INVALID_NODE && m_nodes[next].free) {
+        removeFreeNode(next);
+        node = mergeNodes(node, next);
+    }
+
+    insertFreeNode(node);
+}
+
+VkDeviceSize WYVKMemoryBlock::getLargestFreeRange() const
+{
+    if (m_flBitmap == 0) {
+        return 0;
+    }
+
+    // Every range in the highest non empty bucket is at least as large as any range in a lower bucket
+    uint32_t fl = findLastSet(m_flBitmap);
+    uint32_t sl = findLastSet(m_slBitmaps[fl]);
+
+    VkDeviceSize largest = 0;
+    for (uint32_t node = m_freeHeads[fl][sl]; node != INVALID_NODE; node = m_nodes[node].nextFree) {
+        largest = (std::max)(largest, m_nodes[node].size);
+    }
+    return largest;
+}
+
+void WYVKMemoryBlock::mappingInsert(VkDeviceSize size, uint32_t& fl, uint32_t& sl) const
+{
+    if (size < SMALL_RANGE_SIZE) {
+        // Small ranges are stored linearly in the first level
+        fl = 0;
+        sl = static_cast<uint32_t>(size / (SMALL_RANGE_SIZE / SL_INDEX_COUNT));
+    }
+    else {
+        uint32_t msb = findLastSet(size);
+        sl = static_cast<uint32_t>(size >> (msb - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        fl = msb - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+void WYVKMemoryBlock::mappingSearch(VkDeviceSize size, uint32_t& fl, uint32_t& sl) const
+{
+    // Round the size up to the next bucket boundary so every range in the resulting bucket is large enough
+    if (size >= SMALL_RANGE_SIZE) {
+        VkDeviceSize round = (VkDeviceSize(1) << (findLastSet(size) - SL_INDEX_COUNT_LOG2)) - 1;
+        size += round;
+    }
+    mappingInsert(size, fl, sl);
+}
+
+uint32_t WYVKMemoryBlock::findFreeNode(VkDeviceSize size)
+{
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mappingSearch(size, fl, sl);
+
+    if (fl >= FL_INDEX_COUNT) {
+        return INVALID_NODE;
+    }
+
+    // Look for a non empty bucket in the same first level, then fall back to the next non empty first level
+    uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+    if (slMap == 0) {
+        uint64_t flMap = m_flBitmap & (~0ull << (fl + 1));
+        if (flMap == 0) {
+            return INVALID_NODE;
+        }
+        fl = findFirstSet(flMap);
+        slMap = m_slBitmaps[fl];
+    }
+    sl = findFirstSet(slMap);
+
+    return m_freeHeads[fl][sl];
+}
+
+void WYVKMemoryBlock::insertFreeNode(uint32_t node)
+{
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mappingInsert(m_nodes[node].size, fl, sl);
+
+    uint32_t head = m_freeHeads[fl][sl];
+    m_nodes[node].free = true;
+    m_nodes[node].prevFree = INVALID_NODE;
+    m_nodes[node].nextFree = head;
+    if (head != INVALID_NODE) {
+        m_nodes[head].prevFree = node;
+    }
+    m_freeHeads[fl][sl] = node;
+
+    m_flBitmap |= (1ull << fl);
+    m_slBitmaps[fl] |= (1u << sl);
+}
+
+void WYVKMemoryBlock::removeFreeNode(uint32_t node)
+{
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mappingInsert(m_nodes[node].size, fl, sl);
+
+    uint32_t prev = m_nodes[node].prevFree;
+    uint32_t next = m_nodes[node].nextFree;
+    if (prev != INVALID_NODE) {
+        m_nodes[prev].nextFree = next;
+    }
+    if (next != INVALID_NODE) {
+        m_nodes[next].prevFree = prev;
+    }
+
+    if (m_freeHeads[fl][sl] == node) {
+        m_freeHeads[fl][sl] = next;
+        if (next == INVALID_NODE) {
+            m_slBitmaps[fl] &= ~(1u << sl);
+            if (m_slBitmaps[fl] == 0) {
+                m_flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+
+    m_nodes[node].free = false;
+    m_nodes[node].prevFree = INVALID_NODE;
+    m_nodes[node].nextFree = INVALID_NODE;
+}
+
+uint32_t WYVKMemoryBlock::splitNode(uint32_t node, VkDeviceSize size)
+{
+    if (m_nodes[node].size == size) {
+        return INVALID_NODE;
+    }
+
+    // createNode() may reallocate m_nodes so only access nodes by index here
+    uint32_t remainder = createNode();
+    m_nodes[remainder].offset = m_nodes[node].offset + size;
+    m_nodes[remainder].size = m_nodes[node].size - size;
+    m_nodes[remainder].prevPhysical = node;
+    m_nodes[remainder].nextPhysical = m_nodes[node].nextPhysical;
+
+    if (m_nodes[node].nextPhysical != INVALID_NODE) {
+        m_nodes[m_nodes[node].nextPhysical].prevPhysical = remainder;
+    }
+    m_nodes[node].nextPhysical = remainder;
+    m_nodes[node].size = size;
+
+    return remainder;
+}
+
+uint32_t WYVKMemoryBlock::mergeNodes(uint32_t left, uint32_t right)
+{
+    m_nodes[left].size += m_nodes[right].size;
+    m_nodes[left].nextPhysical = m_nodes[right].nextPhysical;
+    if (m_nodes[right].nextPhysical != INVALID_NODE) {
+        m_nodes[m_nodes[right].nextPhysical].prevPhysical = left;
+    }
+    releaseNode(right);
+    return left;
+}
+
+uint32_t WYVKMemoryBlock::createNode()
+{
+    if (!m_unusedNodes.empty()) {
+        uint32_t node = m_unusedNodes.back();
+        m_unusedNodes.pop_back();
+        m_nodes[node] = Node{};
+        return node;
+    }
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void WYVKMemoryBlock::releaseNode(uint32_t node)
+{
+    m_nodes[node] = Node{};
+    m_unusedNodes.push_back(node);
+}
+
+// ==========================================
+// WYVKAllocator
+// ==========================================
+
+WYVKAllocator::WYVKAllocator(WYVKDevice& device)
+    : m_device(device)
+{
+    vkGetPhysicalDeviceMemoryProperties(m_device.getPhysicalDevice(), &m_memoryProperties);
+}
+
+WYVKAllocator::~WYVKAllocator()
+{
+    WYVERN_LOG_INFO("Destroying device memory allocator...");
+    logStatistics();
+    for (BlockPool& pool : m_pools) {
+        pool.clear();
+    }
+}
+
+uint32_t WYVKAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    WYVERN_LOG_ERROR("Unable to find suitable memory type for resource allocation!");
+    WYVERN_THROW("Unable to find suitable memory type for resource allocation!");
+}
+
+WYVKAllocator::Allocation WYVKAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return allocateFromType(requirements, findMemoryType(requirements.memoryTypeBits, properties), kind);
+}
+
+WYVKAllocator::Allocation WYVKAllocator::allocate(const VkMemoryRequirements& requirements, const WYVKMemoryPolicy::Placement& placement, ResourceKind kind)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The policy's memory type is only a preference, the resource might not support it
+    uint32_t memoryTypeIndex = (requirements.memoryTypeBits & (1 << placement.memoryTypeIndex))
+        ? placement.memoryTypeIndex
+        : findMemoryType(requirements.memoryTypeBits, placement.properties);
+    return allocateFromType(requirements, memoryTypeIndex, kind);
+}
+
+WYVKAllocator::Allocation WYVKAllocator::allocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, ResourceKind kind)
+{
+    // Large resources would waste most of a block, so they get their own memory
+    if (requirements.size > m_blockSize / 2) {
+        return allocateDedicated(requirements, memoryTypeIndex);
+    }
+
+    Allocation allocation{};
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.size = requirements.size;
+
+    BlockPool& pool = getPool(memoryTypeIndex, kind);
+    for (auto& block : pool) {
+        if (block->allocate(requirements.size, requirements.alignment, allocation.offset, allocation.node)) {
+            allocation.block = block.get();
+            break;
+        }
+    }
+
+    if (allocation.block == nullptr) {
+        bool hostVisible = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        pool.push_back(std::make_unique<WYVKMemoryBlock>(m_device, memoryTypeIndex, m_blockSize, hostVisible));
+
+        if (!pool.back()->allocate(requirements.size, requirements.alignment, allocation.offset, allocation.node)) {
+            WYVERN_THROW("Unable to sub-allocate from a fresh memory block!");
+        }
+        allocation.block = pool.back().get();
+    }
+
+    allocation.memory = allocation.block->getMemory();
+    if (allocation.block->getMappedData() != nullptr) {
+        allocation.mappedData = static_cast<char*>(allocation.block->getMappedData()) + allocation.offset;
+    }
+    return allocation;
+}
+
+WYVKAllocator::Allocation WYVKAllocator::allocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex)
+{
+    Allocation allocation{};
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.size = requirements.size;
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    VK_CALL(vkAllocateMemory(m_device.getLogicalDevice(), &allocInfo, nullptr, &allocation.memory), "Failed to allocate dedicated device memory!");
+
+    if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        VK_CALL(vkMapMemory(m_device.getLogicalDevice(), allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mappedData), "Unable to map dedicated device memory!");
+    }
+
+    m_dedicatedCounts[memoryTypeIndex]++;
+    m_dedicatedBytes[memoryTypeIndex] += requirements.size;
+    return allocation;
+}
+
+void WYVKAllocator::free(Allocation& allocation)
+{
+    if (!allocation.isValid()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (allocation.block == nullptr) {
+        vkFreeMemory(m_device.getLogicalDevice(), allocation.memory, nullptr);
+        m_dedicatedCounts[allocation.memoryTypeIndex]--;
+        m_dedicatedBytes[allocation.memoryTypeIndex] -= allocation.size;
+        allocation = Allocation{};
+        return;
+    }
+
+    WYVKMemoryBlock* block = allocation.block;
+    block->free(allocation.node);
+    allocation = Allocation{};
+
+    if (!block->isEmpty()) {
+        return;
+    }
+
+    // Keep a single empty block around per pool so that load/unload patterns don't thrash vkAllocateMemory
+    for (ResourceKind kind : { ResourceKind::LINEAR, ResourceKind::OPTIMAL }) {
+        BlockPool& pool = getPool(block->getMemoryTypeIndex(), kind);
+        auto it = std::find_if(pool.begin(), pool.end(), [block](const std::unique_ptr<WYVKMemoryBlock>& b) { return b.get() == block; });
+        if (it == pool.end()) {
+            continue;
+        }
+
+        size_t emptyBlocks = std::count_if(pool.begin(), pool.end(), [](const std::unique_ptr<WYVKMemoryBlock>& b) { return b->isEmpty(); });
+        if (emptyBlocks > 1) {
+            pool.erase(it);
+        }
+        break;
+    }
+}
+
+std::vector<WYVKAllocator::HeapStatistics> WYVKAllocator::getHeapStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<HeapStatistics> stats(m_memoryProperties.memoryHeapCount);
+    std::vector<VkDeviceSize> freeBytes(m_memoryProperties.memoryHeapCount, 0);
+
+    for (uint32_t heap = 0; heap < m_memoryProperties.memoryHeapCount; heap++) {
+        stats[heap].heapIndex = heap;
+        stats[heap].flags = m_memoryProperties.memoryHeaps[heap].flags;
+        stats[heap].heapSize = m_memoryProperties.memoryHeaps[heap].size;
+    }
+
+    for (uint32_t type = 0; type < m_memoryProperties.memoryTypeCount; type++) {
+        HeapStatistics& heapStats = stats[m_memoryProperties.memoryTypes[type].heapIndex];
+
+        heapStats.dedicatedCount += m_dedicatedCounts[type];
+        heapStats.allocationCount += m_dedicatedCounts[type];
+        heapStats.blockBytes += m_dedicatedBytes[type];
+        heapStats.usedBytes += m_dedicatedBytes[type];
+
+        for (ResourceKind kind : { ResourceKind::LINEAR, ResourceKind::OPTIMAL }) {
+            for (auto& block : getPool(type, kind)) {
+                heapStats.blockCount++;
+                heapStats.allocationCount += block->getAllocationCount();
+                heapStats.blockBytes += block->getSize();
+                heapStats.usedBytes += block->getUsedBytes();
+                heapStats.largestFreeRange = (std::max)(heapStats.largestFreeRange, block->getLargestFreeRange());
+            }
+        }
+    }
+
+    for (HeapStatistics& heapStats : stats) {
+        VkDeviceSize freeTotal = heapStats.blockBytes - heapStats.usedBytes;
+        if (freeTotal > 0) {
+            heapStats.fragmentation = 1.0f - static_cast<float>(heapStats.largestFreeRange) / static_cast<float>(freeTotal);
+        }
+    }
+
+    return stats;
+}
+
+void WYVKAllocator::logStatistics()
+{
+    for (const HeapStatistics& stats : getHeapStatistics()) {
+        WYVERN_LOG_INFO("Heap {} ({}): {} blocks, {} dedicated, {} allocations, {:.2f}/{:.2f} MB used, {:.1f}% fragmented",
+            stats.heapIndex,
+            (stats.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device local" : "host",
+            stats.blockCount,
+            stats.dedicatedCount,
+            stats.allocationCount,
+            stats.usedBytes / (1024.0 * 1024.0),
+            stats.blockBytes / (1024.0 * 1024.0),
+            stats.fragmentation * 100.0f);
+    }
+}
+
+}
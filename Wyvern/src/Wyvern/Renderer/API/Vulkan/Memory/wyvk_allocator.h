@@ -0,0 +1,183 @@
+#pragma once
+#include <mutex>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "wyvk_memory_policy.h"
+
+namespace Wyvern {
+
+/*
+* A single VkDeviceMemory block that is carved into sub-allocations using a TLSF (Two-Level Segregated Fit) scheme.
+*
+* Free ranges are bucketed by a first level index (the most significant bit of the size) and a second level index
+* (the next SL_INDEX_COUNT_LOG2 bits of the size). Two bitmaps track which buckets are non empty so that finding a
+* suitable free range, splitting it and merging it back with its physical neighbours on free are all O(1).
+* [http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf]
+*/
+class WYVKMemoryBlock
+{
+public:
+	static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+	WYVKMemoryBlock(WYVKDevice& device, uint32_t memoryTypeIndex, VkDeviceSize size, bool hostVisible);
+	~WYVKMemoryBlock();
+
+	/*
+	* Finds a free range that can hold `size` bytes at the given alignment. On success the aligned offset of the range
+	* inside the block and the node handle needed to free it later are written to the out params.
+	*/
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset, uint32_t& outNode);
+	void free(uint32_t node);
+
+	inline VkDeviceMemory getMemory() const { return m_memory; }
+	inline VkDeviceSize getSize() const { return m_size; }
+	inline VkDeviceSize getUsedBytes() const { return m_usedBytes; }
+	inline uint32_t getAllocationCount() const { return m_allocationCount; }
+	inline uint32_t getMemoryTypeIndex() const { return m_memoryTypeIndex; }
+	inline bool isEmpty() const { return m_allocationCount == 0; }
+	inline void* getMappedData() const { return m_mappedData; }
+	VkDeviceSize getLargestFreeRange() const;
+
+private:
+	// Granularity of every range inside the block. Sizes are rounded up to this before bucketing
+	static constexpr uint32_t ALIGN_SIZE_LOG2 = 4;
+	static constexpr uint32_t SL_INDEX_COUNT_LOG2 = 4;
+	static constexpr uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+	static constexpr uint32_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+	static constexpr uint32_t FL_INDEX_MAX = 40; // Supports blocks up to 1TB
+	static constexpr uint32_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+	static constexpr VkDeviceSize SMALL_RANGE_SIZE = VkDeviceSize(1) << FL_INDEX_SHIFT;
+
+	struct Node {
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		uint32_t prevPhysical = INVALID_NODE;
+		uint32_t nextPhysical = INVALID_NODE;
+		uint32_t prevFree = INVALID_NODE;
+		uint32_t nextFree = INVALID_NODE;
+		bool free = false;
+	};
+
+	void mappingInsert(VkDeviceSize size, uint32_t& fl, uint32_t& sl) const;
+	void mappingSearch(VkDeviceSize size, uint32_t& fl, uint32_t& sl) const;
+	uint32_t findFreeNode(VkDeviceSize size);
+
+	void insertFreeNode(uint32_t node);
+	void removeFreeNode(uint32_t node);
+
+	// Splits `size` bytes off the front of `node`, returning a new free node for the remainder (or INVALID_NODE)
+	uint32_t splitNode(uint32_t node, VkDeviceSize size);
+	uint32_t mergeNodes(uint32_t left, uint32_t right);
+
+	uint32_t createNode();
+	void releaseNode(uint32_t node);
+
+	VkDeviceMemory m_memory = VK_NULL_HANDLE;
+	VkDeviceSize m_size = 0;
+	VkDeviceSize m_usedBytes = 0;
+	uint32_t m_allocationCount = 0;
+	uint32_t m_memoryTypeIndex = 0;
+	void* m_mappedData = nullptr; // Host visible blocks are mapped once for their whole lifetime
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_unusedNodes;
+
+	uint64_t m_flBitmap = 0;
+	std::array<uint32_t, FL_INDEX_COUNT> m_slBitmaps{};
+	std::array<std::array<uint32_t, SL_INDEX_COUNT>, FL_INDEX_COUNT> m_freeHeads;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+/*
+* Device memory allocator. Instead of calling vkAllocateMemory for every resource, big blocks are allocated per memory type
+* and resources are bound to sub-ranges of them. This keeps us far away from maxMemoryAllocationCount (4096 on most drivers)
+* and removes a kernel round trip from every buffer/image creation.
+*
+* bufferImageGranularity is respected by never mixing linear resources (buffers, linear images) and optimal tiling images
+* inside the same block. Each memory type has two separate block pools, one for each resource kind.
+*/
+class WYVKAllocator
+{
+public:
+	enum class ResourceKind
+	{
+		LINEAR,		// Buffers and linear tiling images
+		OPTIMAL		// Optimal tiling images
+	};
+
+	struct Allocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		void* mappedData = nullptr;			// Pointer to the start of this allocation if the memory is host visible
+		WYVKMemoryBlock* block = nullptr;	// nullptr for dedicated allocations
+		uint32_t node = WYVKMemoryBlock::INVALID_NODE;
+
+		inline bool isValid() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	struct HeapStatistics {
+		uint32_t heapIndex = 0;
+		VkMemoryHeapFlags flags = 0;
+		VkDeviceSize heapSize = 0;
+		uint32_t blockCount = 0;
+		uint32_t dedicatedCount = 0;
+		uint32_t allocationCount = 0;
+		VkDeviceSize blockBytes = 0;		// Bytes reserved from the driver
+		VkDeviceSize usedBytes = 0;			// Bytes handed out to resources
+		VkDeviceSize largestFreeRange = 0;
+		float fragmentation = 0.0f;			// 0 = all free space is contiguous, 1 = free space is completely scattered
+	};
+
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+	WYVKAllocator(WYVKDevice& device);
+	~WYVKAllocator();
+
+	/*
+	* Sub-allocates memory for a resource. Requests larger than half a block get their own dedicated VkDeviceMemory.
+	* The returned allocation must be bound with its offset, e.g. vkBindBufferMemory(device, buffer, alloc.memory, alloc.offset)
+	*/
+	Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceKind kind);
+
+	/*
+	* Same as above but uses the memory type chosen by the placement policy when the resource supports it
+	*/
+	Allocation allocate(const VkMemoryRequirements& requirements, const WYVKMemoryPolicy::Placement& placement, ResourceKind kind);
+	void free(Allocation& allocation);
+
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+	inline const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return m_memoryProperties; }
+
+	std::vector<HeapStatistics> getHeapStatistics();
+	void logStatistics();
+
+private:
+	using BlockPool = std::vector<std::unique_ptr<WYVKMemoryBlock>>;
+
+	inline BlockPool& getPool(uint32_t memoryTypeIndex, ResourceKind kind) {
+		return m_pools[memoryTypeIndex * 2 + (kind == ResourceKind::OPTIMAL ? 1 : 0)];
+	}
+
+	// Expects m_mutex to be held
+	Allocation allocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, ResourceKind kind);
+	Allocation allocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex);
+
+	VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+	VkDeviceSize m_blockSize = DEFAULT_BLOCK_SIZE;
+
+	std::array<BlockPool, VK_MAX_MEMORY_TYPES * 2> m_pools;
+	std::array<uint32_t, VK_MAX_MEMORY_TYPES> m_dedicatedCounts{};
+	std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> m_dedicatedBytes{};
+	std::mutex m_mutex;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
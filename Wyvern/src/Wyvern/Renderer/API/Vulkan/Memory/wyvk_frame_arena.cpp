@@ -0,0 +1,41 @@
+#include "wyvk_frame_arena.h"
+
+namespace Wyvern {
+
+	WYVKFrameArena::WYVKFrameArena(WYVKDevice& device, VkBufferUsageFlags usage, VkDeviceSize capacity)
+		: m_capacity(capacity),
+		m_device(device)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_device.getPhysicalDevice(), &properties);
+		if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+			m_alignment = std::max(m_alignment, properties.limits.minUniformBufferOffsetAlignment);
+		}
+		if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+			m_alignment = std::max(m_alignment, properties.limits.minStorageBufferOffsetAlignment);
+		}
+
+		m_buffer = std::make_unique<WYVKBuffer>(m_device, m_capacity, usage, WYVKMemoryPolicy::ResourceUsage::DYNAMIC_UNIFORM);
+		m_buffer->createPersistentMapping();
+		m_mappedData = static_cast<char*>(m_buffer->getPersistentMapping());
+	}
+
+	WYVKFrameArena::~WYVKFrameArena()
+	{
+	}
+
+	uint32_t WYVKFrameArena::push(const void* data, VkDeviceSize size)
+	{
+		// Device offset alignments are always powers of two
+		VkDeviceSize alignedSize = (size + m_alignment - 1) & ~(m_alignment - 1);
+		VkDeviceSize offset = m_head.fetch_add(alignedSize, std::memory_order_relaxed);
+		if (offset + alignedSize > m_capacity) {
+			WYVERN_LOG_ERROR("Frame arena is full ({} bytes). Increase its capacity", m_capacity);
+			WYVERN_THROW("Frame arena is full!");
+		}
+
+		memcpy(m_mappedData + offset, data, (size_t) size);
+		return static_cast<uint32_t>(offset);
+	}
+
+}
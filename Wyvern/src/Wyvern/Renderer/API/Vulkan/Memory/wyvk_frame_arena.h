@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "buffer.h"
+
+namespace Wyvern {
+
+/*
+* Per frame linear allocator for data the CPU streams to the GPU every frame (object uniforms, instance data).
+*
+* The buffer is persistently mapped and every push() bumps a pointer by the data size rounded up to the arena's alignment.
+* For uniform arenas that is minUniformBufferOffsetAlignment and the returned offset is passed as the dynamic offset of a
+* VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor, so no descriptor ever has to be updated per object.
+* For vertex arenas the offset is passed to vkCmdBindVertexBuffers.
+* push() is lock free and can be called from every recording thread. reset() must only be called once the GPU is done with the frame.
+*/
+class WYVKFrameArena
+{
+public:
+	static constexpr VkDeviceSize DEFAULT_CAPACITY = 4ull * 1024 * 1024;
+
+	/*
+	* `usage` is the buffer usage (e.g. VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT). The alignment is picked from the device limits for that usage
+	*/
+	WYVKFrameArena(WYVKDevice& device, VkBufferUsageFlags usage, VkDeviceSize capacity = DEFAULT_CAPACITY);
+	~WYVKFrameArena();
+
+	/*
+	* Copies `size` bytes into the arena and returns their offset inside the buffer. Throws if the arena is full
+	*/
+	uint32_t push(const void* data, VkDeviceSize size);
+
+	inline void reset() { m_head.store(0, std::memory_order_relaxed); }
+
+	inline WYVKBuffer& getBuffer() { return *m_buffer; }
+	inline VkDeviceSize getAlignment() const { return m_alignment; }
+	inline VkDeviceSize getCapacity() const { return m_capacity; }
+	inline VkDeviceSize getUsedBytes() const { return std::min(m_head.load(std::memory_order_relaxed), m_capacity); }
+
+private:
+	// Alignment used for arenas that are neither uniform nor storage buffers. Enough for any vertex attribute format
+	static constexpr VkDeviceSize DEFAULT_ALIGNMENT = 16;
+
+	VkDeviceSize m_capacity;
+	VkDeviceSize m_alignment = DEFAULT_ALIGNMENT;
+	std::atomic<VkDeviceSize> m_head{ 0 };
+
+	std::unique_ptr<WYVKBuffer> m_buffer;
+	char* m_mappedData = nullptr;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
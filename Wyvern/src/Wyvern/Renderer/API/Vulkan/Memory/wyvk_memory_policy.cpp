@@ -0,0 +1,127 @@
+#include "wyvk_memory_policy.h"
+
+namespace Wyvern {
+
+WYVKMemoryPolicy::WYVKMemoryPolicy(const VkPhysicalDeviceMemoryProperties& memoryProperties, VkPhysicalDeviceType deviceType)
+    : m_memoryProperties(memoryProperties)
+{
+    const VkMemoryPropertyFlags writeDirectFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkMemoryPropertyFlags uploadFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    // UMA: integrated/CPU devices, or every heap is device local
+    bool allHeapsDeviceLocal = m_memoryProperties.memoryHeapCount > 0;
+    for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++) {
+        if (!(m_memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+            allHeapsDeviceLocal = false;
+        }
+    }
+    m_isUMA = deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU || allHeapsDeviceLocal;
+
+    uint32_t writeDirectType = 0;
+    m_hasWriteDirect = findMemoryType(writeDirectFlags, 0, writeDirectType);
+    if (m_hasWriteDirect && !m_isUMA) {
+        VkDeviceSize barSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[writeDirectType].heapIndex].size;
+        m_hasResizableBAR = barSize > SMALL_BAR_SIZE;
+    }
+
+    // Static geometry: write straight into VRAM when the CPU can see all of it, otherwise stage into device local memory
+    if (m_hasWriteDirect && (m_isUMA || m_hasResizableBAR)) {
+        m_placements[static_cast<size_t>(ResourceUsage::STATIC_GEOMETRY)] = makePlacement(ResourceClass::WRITE_DIRECT, writeDirectFlags, 0, false);
+    }
+    else {
+        m_placements[static_cast<size_t>(ResourceUsage::STATIC_GEOMETRY)] = makePlacement(ResourceClass::DEVICE_LOCAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+    }
+
+    // Per frame uniforms are small, so even the small BAR window is a good fit. Staging them every frame would cost more than it saves
+    if (m_hasWriteDirect) {
+        m_placements[static_cast<size_t>(ResourceUsage::DYNAMIC_UNIFORM)] = makePlacement(ResourceClass::WRITE_DIRECT, writeDirectFlags, 0, false);
+    }
+    else {
+        m_placements[static_cast<size_t>(ResourceUsage::DYNAMIC_UNIFORM)] = makePlacement(ResourceClass::HOST_UPLOAD, uploadFlags, 0, false);
+    }
+
+    // Staging memory should stay out of the BAR window so it doesn't take space from resources that need it
+    m_placements[static_cast<size_t>(ResourceUsage::STAGING)] = makePlacement(ResourceClass::HOST_UPLOAD, uploadFlags, m_isUMA ? 0 : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+
+    // Readback wants cached memory. Uncached reads are extremely slow, but not every device exposes a cached type
+    uint32_t cachedType = 0;
+    if (findMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 0, cachedType)) {
+        m_placements[static_cast<size_t>(ResourceUsage::READBACK)] = makePlacement(ResourceClass::HOST_CACHED, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 0, false);
+    }
+    else {
+        m_placements[static_cast<size_t>(ResourceUsage::READBACK)] = makePlacement(ResourceClass::HOST_UPLOAD, uploadFlags, 0, false);
+    }
+}
+
+bool WYVKMemoryPolicy::findMemoryType(VkMemoryPropertyFlags required, VkMemoryPropertyFlags avoid, uint32_t& outIndex) const
+{
+    // First pass honors `avoid`, second pass only looks at the required flags
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+            VkMemoryPropertyFlags flags = m_memoryProperties.memoryTypes[i].propertyFlags;
+            if ((flags & required) != required) {
+                continue;
+            }
+            if (pass == 0 && (flags & avoid) != 0) {
+                continue;
+            }
+            outIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+WYVKMemoryPolicy::Placement WYVKMemoryPolicy::makePlacement(ResourceClass resourceClass, VkMemoryPropertyFlags required, VkMemoryPropertyFlags avoid, bool needsStaging) const
+{
+    Placement placement{};
+    placement.resourceClass = resourceClass;
+    placement.properties = required;
+    placement.needsStaging = needsStaging;
+
+    if (!findMemoryType(required, avoid, placement.memoryTypeIndex)) {
+        WYVERN_LOG_ERROR("No memory type supports the {} resource class!", toString(resourceClass));
+        WYVERN_THROW("No memory type supports the requested resource class!");
+    }
+
+    VkMemoryPropertyFlags typeFlags = m_memoryProperties.memoryTypes[placement.memoryTypeIndex].propertyFlags;
+    placement.heapIndex = m_memoryProperties.memoryTypes[placement.memoryTypeIndex].heapIndex;
+    placement.hostCoherent = typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    return placement;
+}
+
+void WYVKMemoryPolicy::logDecisionTable() const
+{
+    WYVERN_LOG_INFO("Memory placement policy (UMA: {} | Resizable BAR: {} | Write direct memory: {})", m_isUMA, m_hasResizableBAR, m_hasWriteDirect);
+    WYVERN_LOG_INFO("\t{:<16} | {:<12} | {:<5} | {:<4} | {:<7} | {}", "Usage", "Class", "Type", "Heap", "Staging", "Coherent");
+    for (size_t i = 0; i < m_placements.size(); i++) {
+        const Placement& placement = m_placements[i];
+        WYVERN_LOG_INFO("\t{:<16} | {:<12} | {:<5} | {:<4} | {:<7} | {}",
+            toString(static_cast<ResourceUsage>(i)), toString(placement.resourceClass),
+            placement.memoryTypeIndex, placement.heapIndex, placement.needsStaging, placement.hostCoherent);
+    }
+}
+
+const char* WYVKMemoryPolicy::toString(ResourceUsage usage)
+{
+    switch (usage) {
+    case ResourceUsage::STATIC_GEOMETRY: return "STATIC_GEOMETRY";
+    case ResourceUsage::DYNAMIC_UNIFORM: return "DYNAMIC_UNIFORM";
+    case ResourceUsage::STAGING:         return "STAGING";
+    case ResourceUsage::READBACK:        return "READBACK";
+    default:                             return "UNKNOWN";
+    }
+}
+
+const char* WYVKMemoryPolicy::toString(ResourceClass resourceClass)
+{
+    switch (resourceClass) {
+    case ResourceClass::DEVICE_LOCAL:   return "DEVICE_LOCAL";
+    case ResourceClass::WRITE_DIRECT:   return "WRITE_DIRECT";
+    case ResourceClass::HOST_UPLOAD:    return "HOST_UPLOAD";
+    case ResourceClass::HOST_CACHED:    return "HOST_CACHED";
+    default:                            return "UNKNOWN";
+    }
+}
+
+}
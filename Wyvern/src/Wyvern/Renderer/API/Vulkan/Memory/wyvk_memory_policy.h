@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+
+#include "Wyvern/Core.h"
+
+namespace Wyvern {
+
+/*
+* Decides where each kind of buffer should live based on the memory types the physical device exposes.
+*
+* Discrete GPUs usually have a big DEVICE_LOCAL heap the CPU cannot see, plus a small (256MB) DEVICE_LOCAL | HOST_VISIBLE window unless
+* resizable BAR is enabled. Integrated GPUs and software rasterizers (UMA) expose all of their memory as both device local and host visible.
+* The policy resolves a ResourceUsage into a ResourceClass, the memory property flags to allocate with, and whether data has to go through
+* a staging buffer to get there. The full table is computed once and logged at startup.
+*/
+class WYVKMemoryPolicy
+{
+public:
+	// What the buffer is used for
+	enum class ResourceUsage
+	{
+		STATIC_GEOMETRY,	// Written once, read by the GPU every frame (vertex/index data)
+		DYNAMIC_UNIFORM,	// Rewritten by the CPU every frame (camera/object uniforms)
+		STAGING,			// CPU written source of transfer operations
+		READBACK,			// Written by the GPU, read back by the CPU
+		COUNT
+	};
+
+	// Where the buffer ends up
+	enum class ResourceClass
+	{
+		DEVICE_LOCAL,		// Fastest memory for the GPU, not visible to the CPU. Needs staging
+		WRITE_DIRECT,		// Device local and host visible (UMA or resizable BAR). CPU writes go straight to VRAM
+		HOST_UPLOAD,		// Host visible & coherent system memory, read by the GPU over the bus
+		HOST_CACHED			// Host cached system memory for fast CPU reads
+	};
+
+	struct Placement {
+		ResourceClass resourceClass = ResourceClass::HOST_UPLOAD;
+		VkMemoryPropertyFlags properties = 0;	// Flags to request from the allocator
+		uint32_t memoryTypeIndex = 0;			// Memory type the policy expects to be used
+		uint32_t heapIndex = 0;
+		bool needsStaging = false;				// Data must be copied in through a staging buffer
+		bool hostCoherent = true;				// If false, mapped reads must be preceded by vkInvalidateMappedMemoryRanges
+	};
+
+	// Anything above the classic 256MB BAR window means resizable BAR is enabled
+	static constexpr VkDeviceSize SMALL_BAR_SIZE = 256ull * 1024 * 1024;
+
+	WYVKMemoryPolicy(const VkPhysicalDeviceMemoryProperties& memoryProperties, VkPhysicalDeviceType deviceType);
+
+	inline const Placement& getPlacement(ResourceUsage usage) const { return m_placements[static_cast<size_t>(usage)]; }
+	inline bool isUMA() const { return m_isUMA; }
+	inline bool hasResizableBAR() const { return m_hasResizableBAR; }
+
+	void logDecisionTable() const;
+
+	static const char* toString(ResourceUsage usage);
+	static const char* toString(ResourceClass resourceClass);
+
+private:
+	/*
+	* Finds the first memory type that has all `required` flags, preferring types that have none of the `avoid` flags.
+	*/
+	bool findMemoryType(VkMemoryPropertyFlags required, VkMemoryPropertyFlags avoid, uint32_t& outIndex) const;
+	Placement makePlacement(ResourceClass resourceClass, VkMemoryPropertyFlags required, VkMemoryPropertyFlags avoid, bool needsStaging) const;
+
+	VkPhysicalDeviceMemoryProperties m_memoryProperties;
+	bool m_isUMA = false;
+	bool m_hasResizableBAR = false;
+	bool m_hasWriteDirect = false;
+
+	std::array<Placement, static_cast<size_t>(ResourceUsage::COUNT)> m_placements;
+};
+
+}
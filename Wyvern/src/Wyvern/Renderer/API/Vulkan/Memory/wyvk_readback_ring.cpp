@@ -0,0 +1,93 @@
+#include "wyvk_readback_ring.h"
+
+namespace Wyvern {
+
+WYVKReadbackRing::WYVKReadbackRing(WYVKDevice& device, WYVKTimeline& timeline, uint32_t slotCount, VkExtent2D extent, VkFormat format)
+	: m_extent(extent),
+	m_format(format),
+	m_device(device),
+	m_timeline(timeline)
+{
+	VkDeviceSize frameSize = static_cast<VkDeviceSize>(extent.width) * extent.height * BYTES_PER_PIXEL;
+	m_slots.resize(slotCount);
+	for (Slot& slot : m_slots) {
+		slot.buffer = std::make_unique<WYVKBuffer>(m_device, frameSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, WYVKMemoryPolicy::ResourceUsage::READBACK);
+		if (slot.buffer->needsStaging()) {
+			WYVERN_LOG_ERROR("Readback buffers have to be host visible!");
+			WYVERN_THROW("Readback buffers have to be host visible!");
+		}
+	}
+	WYVERN_LOG_INFO("Readback ring: {} slots of {:.2f} MB", slotCount, frameSize / (1024.0 * 1024.0));
+}
+
+void WYVKReadbackRing::record(VkCommandBuffer cmd, VkImage image, uint64_t frameSerial)
+{
+	Slot& slot = m_slots[m_next];
+	if (slot.pending) {
+		// The ring wrapped around faster than the GPU finished frames
+		if (!m_timeline.isComplete(slot.frameSerial)) {
+			m_statistics.stalls++;
+			m_timeline.wait(slot.frameSerial);
+		}
+		deliver(slot);
+	}
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;		// Tightly packed
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { m_extent.width, m_extent.height, 1 };
+	vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer->getBuffer(), 1, &region);
+
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = slot.buffer->getBuffer();
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	slot.frameSerial = frameSerial;
+	slot.pending = true;
+	m_next = (m_next + 1) % static_cast<uint32_t>(m_slots.size());
+}
+
+void WYVKReadbackRing::collect(uint64_t completedSerial)
+{
+	for (uint32_t i = 0; i < m_slots.size(); i++) {
+		Slot& slot = m_slots[(m_next + i) % m_slots.size()];
+		if (slot.pending && slot.frameSerial <= completedSerial) {
+			deliver(slot);
+		}
+	}
+}
+
+void WYVKReadbackRing::deliver(Slot& slot)
+{
+	slot.pending = false;
+	m_statistics.framesRead++;
+	if (!m_callback) {
+		return;
+	}
+
+	const WYVKAllocator::Allocation& allocation = slot.buffer->getAllocation();
+	if (!slot.buffer->getPlacement().hostCoherent) {
+		// Ranges have to be aligned to nonCoherentAtomSize, the whole block always is
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = 0;
+		range.size = VK_WHOLE_SIZE;
+		VK_CALL(vkInvalidateMappedMemoryRanges(m_device.getLogicalDevice(), 1, &range), "Unable to invalidate readback memory!");
+	}
+	m_callback({ allocation.mappedData, slot.buffer->getSize(), m_extent, m_format, slot.frameSerial });
+}
+
+}
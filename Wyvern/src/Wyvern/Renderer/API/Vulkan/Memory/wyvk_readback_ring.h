@@ -0,0 +1,75 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "../Sync/wyvk_timeline.h"
+#include "buffer.h"
+
+namespace Wyvern {
+
+/*
+* Reads rendered frames back to the CPU without stalling the frame loop. Every frame is copied into the next of a ring of host visible
+* READBACK buffers, and handed to the callback once the frame timeline reaches its serial. Only if the ring wraps around to a slot the GPU
+* is still writing does record() wait for it.
+*/
+class WYVKReadbackRing
+{
+public:
+	struct Frame {
+		const void* data;		// Tightly packed rows. Only valid while the callback runs
+		VkDeviceSize size;
+		VkExtent2D extent;
+		VkFormat format;
+		uint64_t frameSerial;
+	};
+	using Callback = std::function<void(const Frame& frame)>;
+
+	struct Statistics {
+		uint64_t framesRead = 0;
+		uint64_t stalls = 0;	// Times record() waited for a slot that was still being written
+	};
+
+	// Only 8 bit, 4 channel formats are read back
+	static constexpr uint32_t BYTES_PER_PIXEL = 4;
+
+	WYVKReadbackRing(WYVKDevice& device, WYVKTimeline& timeline, uint32_t slotCount, VkExtent2D extent, VkFormat format);
+
+	inline void setCallback(Callback callback) { m_callback = std::move(callback); }
+
+	/*
+	* Records a copy of `image` into the next slot. The image has to be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL with its writes made
+	* visible to transfers. `frameSerial` is the serial the frame timeline reaches once `cmd` is done
+	*/
+	void record(VkCommandBuffer cmd, VkImage image, uint64_t frameSerial);
+
+	/*
+	* Hands every frame read back up to `completedSerial` to the callback, oldest first
+	*/
+	void collect(uint64_t completedSerial);
+
+	inline const Statistics& getStatistics() const { return m_statistics; }
+
+private:
+	struct Slot {
+		std::unique_ptr<WYVKBuffer> buffer;
+		uint64_t frameSerial = 0;
+		bool pending = false;
+	};
+
+	void deliver(Slot& slot);
+
+	std::vector<Slot> m_slots;
+	uint32_t m_next = 0;		// Slot written next, which is also the oldest one
+	VkExtent2D m_extent;
+	VkFormat m_format;
+	Callback m_callback;
+	Statistics m_statistics;
+
+	// Handles
+	WYVKDevice& m_device;
+	WYVKTimeline& m_timeline;
+};
+
+}
@@ -0,0 +1,143 @@
+#include "wyvk_staging_ring.h"
+
+namespace Wyvern {
+
+	WYVKStagingRing::WYVKStagingRing(WYVKDevice& device, VkDeviceSize capacity)
+		: m_capacity(capacity),
+		m_device(device)
+	{
+		m_buffer = std::make_unique<WYVKBuffer>(m_device, m_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, WYVKMemoryPolicy::ResourceUsage::STAGING);
+		m_buffer->createPersistentMapping();
+		m_mappedData = static_cast<char*>(m_buffer->getPersistentMapping());
+
+		WYVERN_LOG_INFO("Created staging ring of {} MB", m_capacity / (1024 * 1024));
+	}
+
+	WYVKStagingRing::~WYVKStagingRing()
+	{
+		if (!m_pendingCopies.empty()) {
+			WYVERN_LOG_WARN("Destroying staging ring with {} uploads that were never recorded", m_pendingCopies.size());
+		}
+	}
+
+	bool WYVKStagingRing::tryUpload(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset,
+		VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, UploadTicket& ticket)
+	{
+		if (size == 0 || size > m_capacity) {
+			return false;
+		}
+
+		uint64_t start = (m_head + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+
+		// Never split an upload across the end of the ring. Skip the leftover bytes and start over at physical offset 0
+		if ((start % m_capacity) + size > m_capacity) {
+			start += m_capacity - (start % m_capacity);
+		}
+
+		// Not enough space until the GPU is done with older frames
+		if (start + size - m_tail > m_capacity) {
+			return false;
+		}
+
+		VkDeviceSize physicalOffset = start % m_capacity;
+		memcpy(m_mappedData + physicalOffset, data, (size_t) size);
+		m_head = start + size;
+
+		VkBufferCopy region{};
+		region.srcOffset = physicalOffset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+		m_pendingCopies.push_back({ dst, region, dstStage, dstAccess });
+		m_pendingDstStages |= dstStage;
+		m_pendingDstAccess |= dstAccess;
+
+		ticket.id = m_nextTicket++;
+		return true;
+	}
+
+	void WYVKStagingRing::recordPendingUploads(VkCommandBuffer cmd, uint64_t frameSerial)
+	{
+		if (m_pendingCopies.empty()) {
+			return;
+		}
+		recordCopies(cmd);
+
+		// One barrier for the whole batch. Makes the transfer writes visible to whatever reads the destinations this frame
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = m_pendingDstAccess;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, m_pendingDstStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		commit(frameSerial);
+	}
+
+	void WYVKStagingRing::recordPendingUploads(VkCommandBuffer cmd, uint64_t serial, uint32_t srcQueueFamily, uint32_t dstQueueFamily, std::vector<OwnershipTransfer>& outTransfers)
+	{
+		if (m_pendingCopies.empty()) {
+			return;
+		}
+		recordCopies(cmd);
+
+		// Release half of the queue family ownership transfer. The dst access/stage is ignored for a release, the matching
+		// acquire on the consuming queue is what makes the data visible there
+		std::vector<VkBufferMemoryBarrier> releases;
+		releases.reserve(m_pendingCopies.size());
+		for (const PendingCopy& copy : m_pendingCopies) {
+			VkBufferMemoryBarrier release{};
+			release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			release.dstAccessMask = 0;
+			release.srcQueueFamilyIndex = srcQueueFamily;
+			release.dstQueueFamilyIndex = dstQueueFamily;
+			release.buffer = copy.dst;
+			release.offset = copy.region.dstOffset;
+			release.size = copy.region.size;
+			releases.push_back(release);
+
+			outTransfers.push_back({ copy.dst, copy.region.dstOffset, copy.region.size, copy.dstStage, copy.dstAccess });
+		}
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, static_cast<uint32_t>(releases.size()), releases.data(), 0, nullptr);
+
+		commit(serial);
+	}
+
+	void WYVKStagingRing::recordCopies(VkCommandBuffer cmd)
+	{
+		// Group the regions by destination so every destination buffer only needs a single copy command
+		std::stable_sort(m_pendingCopies.begin(), m_pendingCopies.end(),
+			[](const PendingCopy& a, const PendingCopy& b) { return a.dst < b.dst; });
+
+		std::vector<VkBufferCopy> regions;
+		regions.reserve(m_pendingCopies.size());
+
+		size_t i = 0;
+		while (i < m_pendingCopies.size()) {
+			VkBuffer dst = m_pendingCopies[i].dst;
+			regions.clear();
+			for (; i < m_pendingCopies.size() && m_pendingCopies[i].dst == dst; i++) {
+				regions.push_back(m_pendingCopies[i].region);
+			}
+			vkCmdCopyBuffer(cmd, m_buffer->getBuffer(), dst, static_cast<uint32_t>(regions.size()), regions.data());
+		}
+	}
+
+	void WYVKStagingRing::commit(uint64_t serial)
+	{
+		m_inFlight.push_back({ serial, m_nextTicket - 1, m_head });
+		m_pendingCopies.clear();
+		m_pendingDstStages = 0;
+		m_pendingDstAccess = 0;
+	}
+
+	void WYVKStagingRing::retire(uint64_t completedSerial)
+	{
+		while (!m_inFlight.empty() && m_inFlight.front().frameSerial <= completedSerial) {
+			m_tail = m_inFlight.front().end;
+			m_completedTicket = m_inFlight.front().lastTicket;
+			m_inFlight.pop_front();
+		}
+	}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <deque>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "buffer.h"
+
+namespace Wyvern {
+
+/*
+* Persistently mapped staging ring buffer used for CPU -> GPU uploads.
+*
+* Uploads are memcpy'd into the ring immediately and the copy commands are deferred until the next frame starts recording.
+* At that point every pending copy is recorded into the frame's command buffer (one vkCmdCopyBuffer per destination buffer
+* holding all of its regions) followed by a single barrier. The ring space used by a frame is only reclaimed once that frame's
+* serial has been reached on the frame timeline, so nothing ever blocks on a per-upload fence.
+*
+* Callers get a ticket back that can be polled with isComplete() to know when the data has actually landed on the GPU.
+*/
+class WYVKStagingRing
+{
+public:
+	struct UploadTicket {
+		uint64_t id = 0;
+		inline bool isValid() const { return id != 0; }
+	};
+
+	// Buffer range whose ownership was released by the uploading queue family and must be acquired by the consuming one
+	struct OwnershipTransfer {
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		VkPipelineStageFlags dstStage;
+		VkAccessFlags dstAccess;
+	};
+
+	static constexpr VkDeviceSize DEFAULT_CAPACITY = 32ull * 1024 * 1024;
+	static constexpr VkDeviceSize UPLOAD_ALIGNMENT = 16;
+
+	WYVKStagingRing(WYVKDevice& device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+	~WYVKStagingRing();
+
+	/*
+	* Copies `size` bytes into the ring and queues a copy into `dst` at `dstOffset`.
+	* dstStage and dstAccess describe how the destination is consumed afterwards so the right barrier can be recorded.
+	* Returns false (and leaves the ticket untouched) if the ring does not currently have enough free space.
+	*/
+	bool tryUpload(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset,
+		VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, UploadTicket& ticket);
+
+	/*
+	* Records every pending copy into `cmd`. Must be called outside of a render pass.
+	* The ring space consumed so far is tagged with `frameSerial` and is reclaimed once retire() is called with a serial >= frameSerial
+	*/
+	void recordPendingUploads(VkCommandBuffer cmd, uint64_t frameSerial);
+
+	/*
+	* Same as above, but for copies recorded on a queue of `srcQueueFamily` while the destinations are consumed on `dstQueueFamily`.
+	* Instead of a regular barrier, a queue family release barrier is recorded for every region. The matching acquire barriers are
+	* appended to `outTransfers` and have to be recorded on the consuming queue.
+	*/
+	void recordPendingUploads(VkCommandBuffer cmd, uint64_t serial, uint32_t srcQueueFamily, uint32_t dstQueueFamily, std::vector<OwnershipTransfer>& outTransfers);
+
+	/*
+	* Notifies the ring that all GPU work up to and including `completedSerial` has finished executing.
+	*/
+	void retire(uint64_t completedSerial);
+
+	bool isComplete(UploadTicket ticket) const { return ticket.id <= m_completedTicket; }
+	inline bool hasPendingUploads() const { return !m_pendingCopies.empty(); }
+	inline VkDeviceSize getCapacity() const { return m_capacity; }
+	inline VkDeviceSize getUsedBytes() const { return m_head - m_tail; }
+
+private:
+	struct PendingCopy {
+		VkBuffer dst;
+		VkBufferCopy region;
+		VkPipelineStageFlags dstStage;
+		VkAccessFlags dstAccess;
+	};
+
+	// Records the copy commands (grouped per destination) and marks the used ring space as in flight with `serial`
+	void recordCopies(VkCommandBuffer cmd);
+	void commit(uint64_t serial);
+
+	// Range of the ring that was recorded into the frame with the given serial
+	struct InFlightRange {
+		uint64_t frameSerial;
+		uint64_t lastTicket;
+		uint64_t end;
+	};
+
+	std::unique_ptr<WYVKBuffer> m_buffer;
+	char* m_mappedData = nullptr;
+	VkDeviceSize m_capacity;
+
+	// Virtual offsets that only ever increase. The physical offset is `offset % m_capacity`
+	uint64_t m_head = 0;
+	uint64_t m_tail = 0;
+
+	uint64_t m_nextTicket = 1;
+	uint64_t m_completedTicket = 0;
+
+	std::vector<PendingCopy> m_pendingCopies;
+	VkPipelineStageFlags m_pendingDstStages = 0;
+	VkAccessFlags m_pendingDstAccess = 0;
+	std::deque<InFlightRange> m_inFlight;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
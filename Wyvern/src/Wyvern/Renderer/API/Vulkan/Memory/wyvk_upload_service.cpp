@@ -0,0 +1,184 @@
+#include "wyvk_upload_service.h"
+
+namespace Wyvern {
+
+	WYVKUploadService::WYVKUploadService(WYVKDevice& device, VkDeviceSize stagingCapacity)
+		: m_device(device)
+	{
+		m_dedicatedQueue = m_device.getQueueFamilyIndices().hasDedicatedTransferFamily();
+		m_transferFamily = m_device.getTransferFamily();
+		m_graphicsFamily = m_device.getQueueFamilyIndices().graphicsFamily.value();
+
+		m_commandPool = std::make_unique<WYVKCommandPool>(m_device, m_transferFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+		m_stagingRing = std::make_unique<WYVKStagingRing>(m_device, stagingCapacity);
+
+		m_timeline = std::make_unique<WYVKTimeline>(m_device, "upload");
+
+		WYVERN_LOG_INFO("Upload service using {} queue (family {})", m_dedicatedQueue ? "dedicated transfer" : "graphics", m_transferFamily);
+	}
+
+	WYVKUploadService::~WYVKUploadService()
+	{
+		waitIdle();
+		m_inFlight.clear();
+		m_freeCommandBuffers.clear();
+	}
+
+	WYVKStagingRing::UploadTicket WYVKUploadService::upload(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset,
+		VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		WYVKStagingRing::UploadTicket ticket;
+		const char* bytes = static_cast<const char*>(data);
+
+		const VkDeviceSize chunkSize = m_stagingRing->getCapacity() / 4;
+		for (VkDeviceSize offset = 0; offset < size; offset += chunkSize) {
+			VkDeviceSize count = std::min(chunkSize, size - offset);
+			while (!m_stagingRing->tryUpload(bytes + offset, count, dst, dstOffset + offset, dstStage, dstAccess, ticket)) {
+				// Ring is full. Push what we have to the GPU and wait for the oldest submission to free up space
+				submitLocked();
+				m_timeline->wait(m_inFlight.empty() ? m_submittedValue : m_inFlight.front().timelineValue);
+				collectLocked();
+			}
+		}
+		return ticket;
+	}
+
+	uint64_t WYVKUploadService::submit()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return submitLocked();
+	}
+
+	uint64_t WYVKUploadService::submitLocked()
+	{
+		if (!m_stagingRing->hasPendingUploads()) {
+			return m_submittedValue;
+		}
+
+		uint64_t signalValue = m_submittedValue + 1;
+		std::unique_ptr<WYVKCommandBuffer> cmdBuffer = getCommandBuffer();
+		cmdBuffer->startRecording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+		if (m_dedicatedQueue) {
+			size_t firstNew = m_pendingAcquires.size();
+			m_stagingRing->recordPendingUploads(*cmdBuffer->getCommandBuffer(), signalValue, m_transferFamily, m_graphicsFamily, m_pendingAcquires);
+			for (size_t i = firstNew; i < m_pendingAcquires.size(); i++) {
+				m_acquireWaitStages |= m_pendingAcquires[i].dstStage;
+			}
+		}
+		else {
+			// Same queue as rendering, a regular barrier is enough and is honored by every later submission on the queue
+			m_stagingRing->recordPendingUploads(*cmdBuffer->getCommandBuffer(), signalValue);
+		}
+		cmdBuffer->stopRecording();
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = cmdBuffer->getCommandBuffer();
+		submitInfo.signalSemaphoreCount = 1;
+		VkSemaphore timeline = m_timeline->getSemaphore();
+		submitInfo.pSignalSemaphores = &timeline;
+		{
+			// The transfer queue may be the graphics queue the frame thread submits to
+			std::lock_guard<std::mutex> queueLock(m_device.getQueueMutex());
+			VK_CALL(vkQueueSubmit(m_device.getTransferQueue(), 1, &submitInfo, VK_NULL_HANDLE), "Failed to submit upload command buffer!");
+		}
+
+		m_submittedValue = signalValue;
+		if (m_dedicatedQueue) {
+			m_acquireWaitValue = signalValue;
+		}
+		m_inFlight.push_back({ signalValue, std::move(cmdBuffer) });
+		return signalValue;
+	}
+
+	uint64_t WYVKUploadService::recordAcquireBarriers(VkCommandBuffer cmd, VkPipelineStageFlags& outWaitStages)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		outWaitStages = 0;
+
+		// On a shared queue the barrier recorded after the copies already covers every later submission, nothing to acquire or wait on
+		if (!m_dedicatedQueue || m_pendingAcquires.empty()) {
+			return 0;
+		}
+
+		std::vector<VkBufferMemoryBarrier> acquires;
+		acquires.reserve(m_pendingAcquires.size());
+		for (const WYVKStagingRing::OwnershipTransfer& transfer : m_pendingAcquires) {
+			VkBufferMemoryBarrier acquire{};
+			acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			acquire.srcAccessMask = 0;
+			acquire.dstAccessMask = transfer.dstAccess;
+			acquire.srcQueueFamilyIndex = m_transferFamily;
+			acquire.dstQueueFamilyIndex = m_graphicsFamily;
+			acquire.buffer = transfer.buffer;
+			acquire.offset = transfer.offset;
+			acquire.size = transfer.size;
+			acquires.push_back(acquire);
+		}
+
+		// The semaphore wait happens at m_acquireWaitStages, so the acquire has to start from those stages to chain with it
+		vkCmdPipelineBarrier(cmd, m_acquireWaitStages, m_acquireWaitStages, 0,
+			0, nullptr, static_cast<uint32_t>(acquires.size()), acquires.data(), 0, nullptr);
+
+		outWaitStages = m_acquireWaitStages;
+		uint64_t waitValue = m_acquireWaitValue;
+		m_pendingAcquires.clear();
+		m_acquireWaitStages = 0;
+		m_acquireWaitValue = 0;
+		return waitValue;
+	}
+
+	void WYVKUploadService::collect()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		collectLocked();
+	}
+
+	void WYVKUploadService::collectLocked()
+	{
+		uint64_t completedValue = m_timeline->getCompletedValue();
+
+		while (!m_inFlight.empty() && m_inFlight.front().timelineValue <= completedValue) {
+			m_freeCommandBuffers.push_back(std::move(m_inFlight.front().commandBuffer));
+			m_inFlight.pop_front();
+		}
+		m_stagingRing->retire(completedValue);
+	}
+
+	void WYVKUploadService::waitIdle()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_timeline->wait(m_submittedValue);
+		collectLocked();
+	}
+
+	bool WYVKUploadService::isComplete(WYVKStagingRing::UploadTicket ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_stagingRing->isComplete(ticket)) {
+			collectLocked();
+		}
+		return m_stagingRing->isComplete(ticket);
+	}
+
+	std::unique_ptr<WYVKCommandBuffer> WYVKUploadService::getCommandBuffer()
+	{
+		if (m_freeCommandBuffers.empty()) {
+			return std::make_unique<WYVKCommandBuffer>(m_device, *m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+		}
+		std::unique_ptr<WYVKCommandBuffer> cmdBuffer = std::move(m_freeCommandBuffers.back());
+		m_freeCommandBuffers.pop_back();
+		cmdBuffer->reset();
+		return cmdBuffer;
+	}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "../Command/wyvk_commandpool.h"
+#include "../Command/wyvk_commandbuffer.h"
+#include "../Sync/wyvk_timeline.h"
+#include "wyvk_staging_ring.h"
+
+namespace Wyvern {
+
+/*
+* Asynchronous upload path that runs on the device's transfer queue so big uploads (e.g. model geometry) do not compete with frame rendering.
+*
+* Uploads go into a staging ring owned by this service and are recorded into the service's own command buffers when submit() is called.
+* Every submission signals a timeline semaphore with an increasing value, which is used both to reclaim staging space and to let the
+* graphics queue wait on the data.
+*
+* If the transfer queue belongs to another family than graphics, buffer ownership is released on the transfer queue and must be
+* acquired on the graphics queue with recordAcquireBarriers() before the data is used.
+* Without a dedicated transfer family (e.g. lavapipe) everything falls back to the graphics queue and no ownership transfer is needed.
+*/
+class WYVKUploadService
+{
+public:
+	static constexpr VkDeviceSize DEFAULT_STAGING_CAPACITY = 64ull * 1024 * 1024;
+
+	WYVKUploadService(WYVKDevice& device, VkDeviceSize stagingCapacity = DEFAULT_STAGING_CAPACITY);
+	~WYVKUploadService();
+
+	/*
+	* Queues an upload of `size` bytes into `dst`. Thread safe, so models can be built on another thread while frames are rendered.
+	* dstStage/dstAccess describe how the data is consumed on the graphics queue.
+	*/
+	WYVKStagingRing::UploadTicket upload(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset,
+		VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+	/*
+	* Submits every queued upload to the transfer queue. Returns the timeline value that will be signaled once the copies are done,
+	* or the last submitted value if nothing was queued. Thread safe, the submission holds the device's queue lock
+	* (see WYVKDevice::getQueueMutex()) since it may go to the graphics queue.
+	*/
+	uint64_t submit();
+
+	/*
+	* Records the acquire half of the queue family ownership transfers for all submitted uploads into a graphics command buffer.
+	* Returns the timeline value the graphics submission has to wait on (0 if there is nothing to wait for) and the stages that wait.
+	*/
+	uint64_t recordAcquireBarriers(VkCommandBuffer cmd, VkPipelineStageFlags& outWaitStages);
+
+	/*
+	* Reclaims staging space and command buffers of submissions the GPU has finished. Never blocks.
+	*/
+	void collect();
+
+	/*
+	* Blocks until every submitted upload has finished executing.
+	*/
+	void waitIdle();
+
+	bool isComplete(WYVKStagingRing::UploadTicket ticket);
+
+	inline VkSemaphore getTimelineSemaphore() const { return m_timeline->getSemaphore(); }
+	inline bool hasDedicatedQueue() const { return m_dedicatedQueue; }
+
+private:
+	struct Submission {
+		uint64_t timelineValue;
+		std::unique_ptr<WYVKCommandBuffer> commandBuffer;
+	};
+
+	uint64_t submitLocked();
+	void collectLocked();
+	std::unique_ptr<WYVKCommandBuffer> getCommandBuffer();
+
+	bool m_dedicatedQueue = false;
+	uint32_t m_transferFamily = 0;
+	uint32_t m_graphicsFamily = 0;
+
+	std::unique_ptr<WYVKCommandPool> m_commandPool;
+	std::unique_ptr<WYVKStagingRing> m_stagingRing;
+
+	std::unique_ptr<WYVKTimeline> m_timeline; // Signaled with the submission count by every transfer queue submission
+	uint64_t m_submittedValue = 0;
+
+	std::deque<Submission> m_inFlight;
+	std::vector<std::unique_ptr<WYVKCommandBuffer>> m_freeCommandBuffers;
+
+	// Released buffer ranges waiting to be acquired on the graphics queue
+	std::vector<WYVKStagingRing::OwnershipTransfer> m_pendingAcquires;
+	uint64_t m_acquireWaitValue = 0;
+	VkPipelineStageFlags m_acquireWaitStages = 0;
+
+	std::mutex m_mutex;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
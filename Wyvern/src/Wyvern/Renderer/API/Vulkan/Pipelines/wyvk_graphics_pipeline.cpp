@@ -7,15 +7,30 @@ namespace Wyvern {
 const std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
 
 
-WYVKGraphicsPipeline::WYVKGraphicsPipeline(WYVKDevice& device, WYVKSwapchain& swapchain, WYVKRenderPass& renderPass)
-    : m_device(device),
+WYVKGraphicsPipeline::WYVKGraphicsPipeline(WYVKDevice& device, WYVKSwapchain& swapchain, WYVKRenderPass& renderPass,
+    const std::filesystem::path& vertexShaderPath, const std::filesystem::path& fragmentShaderPath)
+    : m_vertexShaderPath(vertexShaderPath),
+    m_fragmentShaderPath(fragmentShaderPath),
+    m_device(device),
     m_swapchain(swapchain),
     m_renderPass(renderPass)
 {
 }
 
+void WYVKGraphicsPipeline::setVertexInput(const std::vector<VkVertexInputBindingDescription>& bindings, const std::vector<VkVertexInputAttributeDescription>& attributes)
+{
+    m_vertexBindings = bindings;
+    m_vertexAttributes = attributes;
+    m_vertexInputOverridden = true;
+}
+
 WYVKGraphicsPipeline::~WYVKGraphicsPipeline()
 {
+    // Workers may still be compiling into this pipeline
+    if (m_build.valid()) {
+        m_build.wait();
+    }
+
     vkDestroyPipeline(m_device.getLogicalDevice(), m_graphicsPipeline, nullptr);
     vkDestroyPipelineLayout(m_device.getLogicalDevice(), m_pipelineLayout, nullptr);
 
@@ -25,21 +40,59 @@ WYVKGraphicsPipeline::~WYVKGraphicsPipeline()
     }
 }
 
-void WYVKGraphicsPipeline::configureShader(std::filesystem::path path, VkShaderStageFlagBits shaderStage)
+WYVKGraphicsPipeline::CompiledStage WYVKGraphicsPipeline::compileShader(std::filesystem::path path, VkShaderStageFlagBits shaderStage)
 {
+    auto start = std::chrono::high_resolution_clock::now();
     WYVKShader shader(m_device, path, shaderStage);
-    shader.compile();
-    VkShaderModule module = shader.createShaderModule(shader.getBinary());
-    m_shaderModules.push_back(std::make_pair(shaderStage, module));
+
+    // Recorded even if compilation fails, so the pipeline is rebuilt once the shader is fixed
+    auto recordShaderFiles = [&]() {
+        std::lock_guard<std::mutex> lock(m_shaderFilesMutex);
+        m_shaderFiles.push_back(path.lexically_normal());
+        m_shaderFiles.insert(m_shaderFiles.end(), shader.getIncludedFiles().begin(), shader.getIncludedFiles().end());
+    };
+    try {
+        shader.compile();
+    }
+    catch (...) {
+        recordShaderFiles();
+        throw;
+    }
+    recordShaderFiles();
+
+    CompiledStage compiled;
+    compiled.stage = shaderStage;
+    compiled.reflection = WYVKShaderReflection::reflect(shader.getCacheKey(), shader.getBinary());
+    compiled.module = shader.createShaderModule(shader.getBinary());
+    compiled.compileTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return compiled;
 }
 
-void WYVKGraphicsPipeline::createShaderStates()
+void WYVKGraphicsPipeline::addCompiledStage(const CompiledStage& compiled)
 {
-    std::filesystem::path vertexShaderPath("src\\Wyvern\\Assets\\Shaders\\vertex.vert");
-    std::filesystem::path fragmentShaderPath("src\\Wyvern\\Assets\\Shaders\\fragment.frag");
+    m_shaderModules.push_back({ compiled.stage, compiled.module });
+    m_reflection.merge(*compiled.reflection);
+    m_shaderCompileTimeMs += compiled.compileTimeMs;
+}
 
-    configureShader(std::filesystem::absolute(vertexShaderPath), VK_SHADER_STAGE_VERTEX_BIT);
-    configureShader(std::filesystem::absolute(fragmentShaderPath), VK_SHADER_STAGE_FRAGMENT_BIT);
+bool WYVKGraphicsPipeline::dependsOn(const std::filesystem::path& file)
+{
+    std::filesystem::path normalized = file.lexically_normal();
+    std::lock_guard<std::mutex> lock(m_shaderFilesMutex);
+    return std::find(m_shaderFiles.begin(), m_shaderFiles.end(), normalized) != m_shaderFiles.end();
+}
+
+void WYVKGraphicsPipeline::createShaderStates()
+{
+    // Every stage gets every constant. Constants a stage does not declare are ignored
+    for (const SpecializationConstant& constant : m_specializationConstants) {
+        m_specializationEntries.push_back({ constant.id, static_cast<uint32_t>(m_specializationData.size() * sizeof(uint32_t)), sizeof(uint32_t) });
+        m_specializationData.push_back(constant.value);
+    }
+    m_specializationInfo.mapEntryCount = static_cast<uint32_t>(m_specializationEntries.size());
+    m_specializationInfo.pMapEntries = m_specializationEntries.data();
+    m_specializationInfo.dataSize = m_specializationData.size() * sizeof(uint32_t);
+    m_specializationInfo.pData = m_specializationData.data();
 
     WYVERN_LOG_INFO("Creating {} shader modules", m_shaderModules.size());
     for (const auto& shaderModule : m_shaderModules) {
@@ -48,31 +101,111 @@ void WYVKGraphicsPipeline::createShaderStates()
         shaderStageInfo.stage = shaderModule.first;
         shaderStageInfo.module = shaderModule.second;
         shaderStageInfo.pName = "main";
+        shaderStageInfo.pSpecializationInfo = m_specializationConstants.empty() ? nullptr : &m_specializationInfo;
 
         m_shaderStages.push_back(shaderStageInfo);
     }
 }
 
-void WYVKGraphicsPipeline::createGraphicsPipeline(VkDescriptorSetLayout& descriptorSetLayout)
+void WYVKGraphicsPipeline::createGraphicsPipeline(VkDescriptorSetLayout& descriptorSetLayout, VkPipelineCache pipelineCache)
+{
+    prepare(descriptorSetLayout);
+
+    addCompiledStage(compileShader(std::filesystem::absolute(m_vertexShaderPath), VK_SHADER_STAGE_VERTEX_BIT));
+    addCompiledStage(compileShader(std::filesystem::absolute(m_fragmentShaderPath), VK_SHADER_STAGE_FRAGMENT_BIT));
+
+    buildPipeline(pipelineCache);
+}
+
+std::shared_future<void> WYVKGraphicsPipeline::createGraphicsPipelineAsync(ThreadPool& threadPool, VkDescriptorSetLayout& descriptorSetLayout, VkPipelineCache pipelineCache)
+{
+    prepare(descriptorSetLayout);
+
+    std::vector<std::shared_future<CompiledStage>> stages;
+    std::filesystem::path vertexPath = std::filesystem::absolute(m_vertexShaderPath);
+    std::filesystem::path fragmentPath = std::filesystem::absolute(m_fragmentShaderPath);
+    stages.push_back(threadPool.submit([this, vertexPath]() { return compileShader(vertexPath, VK_SHADER_STAGE_VERTEX_BIT); }).share());
+    stages.push_back(threadPool.submit([this, fragmentPath]() { return compileShader(fragmentPath, VK_SHADER_STAGE_FRAGMENT_BIT); }).share());
+
+    // The pool runs jobs in FIFO order, so by the time a worker picks this up the compiles are running or done and waiting on them cannot deadlock
+    m_build = threadPool.submit([this, stages, pipelineCache]() {
+        std::exception_ptr error;
+        for (const auto& stage : stages) {
+            try {
+                addCompiledStage(stage.get());
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+        try {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            buildPipeline(pipelineCache);
+        }
+        catch (const std::exception& e) {
+            WYVERN_LOG_ERROR("Failed to build pipeline for {}: {}", m_vertexShaderPath.filename().string(), e.what());
+            m_failed.store(true, std::memory_order_release);
+            throw;
+        }
+    }).share();
+    return m_build;
+}
+
+void WYVKGraphicsPipeline::waitUntilReady()
+{
+    if (m_build.valid()) {
+        m_build.get(); // Rethrows compile or pipeline creation errors
+    }
+}
+
+void WYVKGraphicsPipeline::prepare(VkDescriptorSetLayout& descriptorSetLayout)
 {
-    createShaderStates();
     initializeDynamicStates(dynamicStates);
     initializeDefaultPipelineInfo();
     createPipelineLayoutInfo(descriptorSetLayout);
+}
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+void WYVKGraphicsPipeline::buildPipeline(VkPipelineCache pipelineCache)
+{
+    createShaderStates();
+
+    // The pipeline layout was created before the shaders were compiled, so make sure it covers their push constants
+    for (const VkPushConstantRange& range : m_reflection.pushConstants) {
+        bool covered = std::any_of(m_pushConstantRanges.begin(), m_pushConstantRanges.end(), [&](const VkPushConstantRange& r) {
+            return (r.stageFlags & range.stageFlags) == range.stageFlags && r.offset <= range.offset && r.offset + r.size >= range.offset + range.size;
+        });
+        if (!covered) {
+            WYVERN_THROW("Push constants of " + m_vertexShaderPath.filename().string() + " are not covered by the pipeline layout!");
+        }
+    }
+
+    if (!m_vertexInputOverridden) {
+        WYVKShaderReflection::deriveVertexInput(m_reflection, m_instanceInputLocation, m_vertexBindings, m_vertexAttributes);
+
+        // The derived layout assumes tightly packed attributes. A shader whose inputs don't add up to the structs the buffers hold
+        // would read the wrong bytes, so fail loudly instead
+        for (const VkVertexInputBindingDescription& binding : m_vertexBindings) {
+            uint32_t expected = binding.binding == InstanceData::BINDING ? sizeof(InstanceData) : sizeof(Vertex);
+            if (binding.stride != expected) {
+                WYVERN_LOG_ERROR("{}: vertex binding {} has a stride of {} bytes, the buffer holds {} byte elements", m_vertexShaderPath.filename().string(),
+                    binding.binding, binding.stride, expected);
+                WYVERN_THROW("Vertex inputs of " + m_vertexShaderPath.filename().string() + " don't match Vertex/InstanceData!");
+            }
+        }
+    }
 
     m_configInfo.vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    m_configInfo.vertexInputInfo.vertexBindingDescriptionCount = 1;
-    m_configInfo.vertexInputInfo.pVertexBindingDescriptions = &bindingDescription; // Optional
-    m_configInfo.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    m_configInfo.vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data(); // Optional
+    m_configInfo.vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(m_vertexBindings.size());
+    m_configInfo.vertexInputInfo.pVertexBindingDescriptions = m_vertexBindings.data(); // Optional
+    m_configInfo.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_vertexAttributes.size());
+    m_configInfo.vertexInputInfo.pVertexAttributeDescriptions = m_vertexAttributes.data(); // Optional
 
     // Create Pipeline
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
+    pipelineInfo.stageCount = static_cast<uint32_t>(m_shaderStages.size());
     pipelineInfo.pStages = m_shaderStages.data();
     pipelineInfo.pVertexInputState = &m_configInfo.vertexInputInfo;
     pipelineInfo.pInputAssemblyState = &m_configInfo.inputAssemblyInfo;
@@ -87,21 +220,36 @@ void WYVKGraphicsPipeline::createGraphicsPipeline(VkDescriptorSetLayout& descrip
     pipelineInfo.renderPass = m_renderPass.getRenderPass();
     pipelineInfo.subpass = 0; // index of first subpass
 
+    // Without a render pass the pipeline is only tied to the attachment formats
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    if (m_renderPass.isDynamicRendering()) {
+        renderingInfo = m_renderPass.getRenderingInfo();
+        pipelineInfo.pNext = &renderingInfo;
+    }
+
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex = -1; // Optional
 
-    VK_CALL(vkCreateGraphicsPipelines(m_device.getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline), "Failed to create graphics pipeline!");
+    auto start = std::chrono::high_resolution_clock::now();
+    VK_CALL(vkCreateGraphicsPipelines(m_device.getLogicalDevice(), pipelineCache, 1, &pipelineInfo, nullptr, &m_graphicsPipeline), "Failed to create graphics pipeline!");
+    m_creationTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    m_readyTime = std::chrono::steady_clock::now();
+    m_ready.store(true, std::memory_order_release);
 }
 
 void WYVKGraphicsPipeline::createPipelineLayoutInfo(VkDescriptorSetLayout& descriptorSetLayout)
 {
+    std::vector<VkDescriptorSetLayout> setLayouts = { descriptorSetLayout };
+    setLayouts.insert(setLayouts.end(), m_additionalSetLayouts.begin(), m_additionalSetLayouts.end());
+
     // Finalize layout
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(m_pushConstantRanges.size()); // Optional
+    pipelineLayoutInfo.pPushConstantRanges = m_pushConstantRanges.data(); // Optional
 
     VK_CALL(vkCreatePipelineLayout(m_device.getLogicalDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout), "Failed to create pipeline layout!");
 }
@@ -119,7 +267,7 @@ void WYVKGraphicsPipeline::initializeDefaultPipelineInfo()
 {
 
     m_configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    m_configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    m_configInfo.inputAssemblyInfo.topology = m_state.topology;
     m_configInfo.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
     if (!m_usingDynamicStates) {
@@ -137,13 +285,13 @@ void WYVKGraphicsPipeline::initializeDefaultPipelineInfo()
     m_configInfo.rasterizationInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     m_configInfo.rasterizationInfo.depthClampEnable = VK_FALSE;  // fragments beyond near and far plane are clamped to them
     m_configInfo.rasterizationInfo.rasterizerDiscardEnable = VK_FALSE; // Disables rasterization to the framebuffer. we want to set this to false for rasterization. not sure about raytracing though
-    m_configInfo.rasterizationInfo.polygonMode = VK_POLYGON_MODE_FILL; // How the rasterizer draws the triangles. e.g. Fill, line, point
+    m_configInfo.rasterizationInfo.polygonMode = m_state.polygonMode; // How the rasterizer draws the triangles. e.g. Fill, line, point
     m_configInfo.rasterizationInfo.lineWidth = 1.0f;
     // culls back face geomtry. The orientation of the geometry is specified in the following parameter
-    m_configInfo.rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+    m_configInfo.rasterizationInfo.cullMode = m_state.cullMode;
     // Specifies the orientation of vertices to NOT cull. So "front" facing geometry with clockwise vertices will be shown, 
     // while "back" facing geometry with counter-clockwise vertices will be culled
-    m_configInfo.rasterizationInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    m_configInfo.rasterizationInfo.frontFace = m_state.frontFace;
     m_configInfo.rasterizationInfo.depthBiasEnable = VK_FALSE;
     m_configInfo.rasterizationInfo.depthBiasConstantFactor = 0.0f; // Optional
     m_configInfo.rasterizationInfo.depthBiasClamp = 0.0f; // Optional
@@ -158,23 +306,25 @@ void WYVKGraphicsPipeline::initializeDefaultPipelineInfo()
     m_configInfo.multisampleInfo.alphaToCoverageEnable = VK_FALSE; // Optional
     m_configInfo.multisampleInfo.alphaToOneEnable = VK_FALSE; // Optional
 
-    m_configInfo.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    m_configInfo.colorBlendAttachment.blendEnable = VK_FALSE;
-    m_configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-    m_configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-    m_configInfo.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-    m_configInfo.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-    m_configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-    m_configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
-
-    // Alpha blending
-    //m_configInfo.colorBlendAttachment.blendEnable = VK_TRUE;
-    //m_configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    //m_configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    //m_configInfo.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    //m_configInfo.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    //m_configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    //m_configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    m_configInfo.colorBlendAttachment.colorWriteMask = m_state.colorWriteMask;
+    m_configInfo.colorBlendAttachment.blendEnable = m_state.blendEnable;
+    if (m_state.blendEnable) {
+        // Alpha blending
+        m_configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        m_configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        m_configInfo.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        m_configInfo.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        m_configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        m_configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
+    else {
+        m_configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+        m_configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+        m_configInfo.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
+        m_configInfo.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
+        m_configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
+        m_configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
+    }
 
     m_configInfo.colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     m_configInfo.colorBlendInfo.logicOpEnable = VK_FALSE;
@@ -187,9 +337,9 @@ void WYVKGraphicsPipeline::initializeDefaultPipelineInfo()
     m_configInfo.colorBlendInfo.blendConstants[3] = 0.0f; // Optional
 
     m_configInfo.depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    m_configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
-    m_configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
-    m_configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+    m_configInfo.depthStencilInfo.depthTestEnable = m_state.depthTestEnable;
+    m_configInfo.depthStencilInfo.depthWriteEnable = m_state.depthWriteEnable;
+    m_configInfo.depthStencilInfo.depthCompareOp = m_state.depthCompareOp;
     m_configInfo.depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
     m_configInfo.depthStencilInfo.minDepthBounds = 0.0f;  // Optional
     m_configInfo.depthStencilInfo.maxDepthBounds = 1.0f;  // Optional
@@ -1,11 +1,17 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 #include "wyvk_shader.h"
+#include "wyvk_shader_reflection.h"
 #include "../wyvk_swapchain.h"
 #include "wyvk_renderpass.h"
 
+#include <atomic>
 #include <filesystem>
+#include <future>
+#include <mutex>
+
+#include "Wyvern/Threading/thread_pool.h"
 
 namespace Wyvern {
 
@@ -31,30 +37,169 @@ public:
 		VkPipelineDepthStencilStateCreateInfo depthStencilInfo{};
 	};
 
-	WYVKGraphicsPipeline(WYVKDevice& device, WYVKSwapchain& swapchain, WYVKRenderPass& renderPass);
+	/*
+	* The part of the fixed function state that differs between pipeline variants (wireframe, depth only, alpha blended...).
+	* Every field is 4 bytes wide, so there is no padding and it can be compared & hashed bytewise
+	*/
+	struct PipelineState {
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL; // Anything but fill needs the fillModeNonSolid device feature
+		VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+		VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+		VkBool32 depthTestEnable = VK_TRUE;
+		VkBool32 depthWriteEnable = VK_TRUE;
+		VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+		VkBool32 blendEnable = VK_FALSE; // Standard alpha blending
+		VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT; // 0 for depth only
+
+		inline bool operator==(const PipelineState& other) const { return memcmp(this, &other, sizeof(PipelineState)) == 0; }
+		inline bool operator!=(const PipelineState& other) const { return !(*this == other); }
+	};
+
+	/*
+	* Value of a `layout(constant_id = id)` constant. 4 bytes cover bool, int, uint & float constants.
+	* Variants that only differ in their constants compile from the same SPIR-V
+	*/
+	struct SpecializationConstant {
+		uint32_t id;
+		uint32_t value;
+
+		inline bool operator==(const SpecializationConstant& other) const { return id == other.id && value == other.value; }
+	};
+
+	static constexpr const char* DEFAULT_VERTEX_SHADER = "src/Wyvern/Assets/Shaders/vertex.vert";
+	static constexpr const char* DEFAULT_FRAGMENT_SHADER = "src/Wyvern/Assets/Shaders/fragment.frag";
+
+	WYVKGraphicsPipeline(WYVKDevice& device, WYVKSwapchain& swapchain, WYVKRenderPass& renderPass,
+		const std::filesystem::path& vertexShaderPath = DEFAULT_VERTEX_SHADER, const std::filesystem::path& fragmentShaderPath = DEFAULT_FRAGMENT_SHADER);
 	~WYVKGraphicsPipeline();
 
-	void createGraphicsPipeline(VkDescriptorSetLayout& descriptorSetLayout);
+	/*
+	* Overrides the vertex input state. Must be called before createGraphicsPipeline().
+	* By default the vertex input is derived from the vertex shader's inputs (see WYVKShaderReflection::deriveVertexInput())
+	*/
+	void setVertexInput(const std::vector<VkVertexInputBindingDescription>& bindings, const std::vector<VkVertexInputAttributeDescription>& attributes);
+
+	/*
+	* Vertex shader inputs from `location` on are read from binding 1 and advance per instance. Only used by the derived vertex input
+	*/
+	inline void setInstanceInputLocation(uint32_t location) { m_instanceInputLocation = location; }
+
+	/*
+	* Push constant ranges of the pipeline layout. Pipelines that share descriptor sets need identical ranges, so this is usually
+	* the merged reflection of every shader used with the set layout. Must be called before createGraphicsPipeline()
+	*/
+	inline void setPushConstantRanges(const std::vector<VkPushConstantRange>& ranges) { m_pushConstantRanges = ranges; }
+
+	/*
+	* Set layouts that follow the one passed to createGraphicsPipeline(), i.e. sets 1, 2... (e.g. WYVKBindlessSet). Must be called before createGraphicsPipeline()
+	*/
+	inline void setAdditionalSetLayouts(const std::vector<VkDescriptorSetLayout>& setLayouts) { m_additionalSetLayouts = setLayouts; }
+
+	/*
+	* Fixed function state & specialization constants of the pipeline. Must be called before createGraphicsPipeline()
+	*/
+	inline void setState(const PipelineState& state) { m_state = state; }
+	inline void setSpecializationConstants(const std::vector<SpecializationConstant>& constants) { m_specializationConstants = constants; }
+
+	/*
+	* Compiles the shaders and creates the pipeline. With a `pipelineCache` (see WYVKPipelineCache) the driver can skip
+	* compiling pipeline state it has seen before
+	*/
+	void createGraphicsPipeline(VkDescriptorSetLayout& descriptorSetLayout, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+	/*
+	* Same as createGraphicsPipeline(), but each shader stage is compiled on its own job in `threadPool` and the pipeline is created
+	* by another job once they are done. Returns right away: the pipeline layout is valid immediately, the pipeline itself once
+	* isReady() returns true (or the returned future is ready). `threadPool` must outlive the returned future
+	*/
+	std::shared_future<void> createGraphicsPipelineAsync(ThreadPool& threadPool, VkDescriptorSetLayout& descriptorSetLayout, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+
+	/*
+	* Blocks until an async build is done. Rethrows the error if it failed
+	*/
+	void waitUntilReady();
+	inline bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+	// True once an async build has failed. The pipeline never becomes ready, waitUntilReady() rethrows the error
+	inline bool hasFailed() const { return m_failed.load(std::memory_order_acquire); }
 
 	inline VkPipeline& getPipeline() { return m_graphicsPipeline; }
 	inline VkPipelineLayout& getPipelineLayout() { return m_pipelineLayout; }
 	inline WYVKRenderPass& getWYVKRenderPass() { return m_renderPass; }
+	inline const std::filesystem::path& getVertexShaderPath() const { return m_vertexShaderPath; }
+	inline const std::filesystem::path& getFragmentShaderPath() const { return m_fragmentShaderPath; }
+	inline const std::vector<VkVertexInputBindingDescription>& getVertexBindings() const { return m_vertexBindings; }
+	inline const std::vector<VkVertexInputAttributeDescription>& getVertexAttributes() const { return m_vertexAttributes; }
+	inline bool isVertexInputOverridden() const { return m_vertexInputOverridden; }
+	inline uint32_t getInstanceInputLocation() const { return m_instanceInputLocation; }
+	inline const std::vector<VkPushConstantRange>& getPushConstantRanges() const { return m_pushConstantRanges; }
+	inline const std::vector<VkDescriptorSetLayout>& getAdditionalSetLayouts() const { return m_additionalSetLayouts; }
+	inline const PipelineState& getState() const { return m_state; }
+	inline const std::vector<SpecializationConstant>& getSpecializationConstants() const { return m_specializationConstants; }
+	// Merged reflection of every stage. Only complete once the pipeline is ready
+	inline const WYVKShaderReflection::Reflection& getReflection() const { return m_reflection; }
+
+	/*
+	* True if `file` is one of the shader sources this pipeline was compiled from, or a file they #include. Thread safe
+	*/
+	bool dependsOn(const std::filesystem::path& file);
+	// Time spent in vkCreateGraphicsPipelines, without shader compilation
+	inline double getCreationTimeMs() const { return m_creationTimeMs; }
+	// Time spent compiling (or loading from the SPIR-V cache) all shader stages, summed over stages
+	inline double getShaderCompileTimeMs() const { return m_shaderCompileTimeMs; }
+	inline std::chrono::steady_clock::time_point getReadyTime() const { return m_readyTime; }
 
 private:
 	void createPipelineLayoutInfo(VkDescriptorSetLayout& descriptorSetLayout);
 
 	void initializeDynamicStates(const std::vector<VkDynamicState>& dynamicStates);
 	void initializeDefaultPipelineInfo();
-	void configureShader(std::filesystem::path path, VkShaderStageFlagBits shaderStage);
+	struct CompiledStage {
+		VkShaderStageFlagBits stage;
+		VkShaderModule module = VK_NULL_HANDLE;
+		std::shared_ptr<const WYVKShaderReflection::Reflection> reflection;
+		double compileTimeMs = 0.0;
+	};
+
+	// Thread safe, so stages can be compiled in parallel
+	CompiledStage compileShader(std::filesystem::path path, VkShaderStageFlagBits shaderStage);
+	void addCompiledStage(const CompiledStage& compiled);
 	void createShaderStates();
 
+	// Fixed function state & pipeline layout. Cheap, so always done on the calling thread
+	void prepare(VkDescriptorSetLayout& descriptorSetLayout);
+	// Creates the pipeline from the compiled m_shaderModules
+	void buildPipeline(VkPipelineCache pipelineCache);
+
+	std::filesystem::path m_vertexShaderPath;
+	std::filesystem::path m_fragmentShaderPath;
+	std::vector<VkVertexInputBindingDescription> m_vertexBindings;
+	std::vector<VkVertexInputAttributeDescription> m_vertexAttributes;
+	bool m_vertexInputOverridden = false;
+	uint32_t m_instanceInputLocation = UINT32_MAX;
+	std::vector<VkPushConstantRange> m_pushConstantRanges;
+	std::vector<VkDescriptorSetLayout> m_additionalSetLayouts;
+	WYVKShaderReflection::Reflection m_reflection;
 	std::vector<std::pair<VkShaderStageFlagBits, VkShaderModule>> m_shaderModules;
 	std::vector<VkPipelineShaderStageCreateInfo> m_shaderStages;
+	PipelineState m_state;
+	std::vector<SpecializationConstant> m_specializationConstants;
+	std::vector<VkSpecializationMapEntry> m_specializationEntries;
+	std::vector<uint32_t> m_specializationData;
+	VkSpecializationInfo m_specializationInfo{};
 	PipelineConfigInfo m_configInfo;
 	VkPipelineLayout m_pipelineLayout = nullptr;
-	VkPipeline m_graphicsPipeline;
+	VkPipeline m_graphicsPipeline = VK_NULL_HANDLE;
 
 	bool m_usingDynamicStates = false;
+	double m_creationTimeMs = 0.0;
+	double m_shaderCompileTimeMs = 0.0;
+	std::chrono::steady_clock::time_point m_readyTime;
+	std::atomic<bool> m_ready{ false };
+	std::atomic<bool> m_failed{ false };
+	std::shared_future<void> m_build;
+	std::vector<std::filesystem::path> m_shaderFiles; // Sources & includes, filled in by compileShader()
+	std::mutex m_shaderFilesMutex;
 
 	// Handles
 	WYVKDevice& m_device;
@@ -0,0 +1,121 @@
+#include "wyvk_pipeline_cache.h"
+#include <fstream>
+
+namespace Wyvern {
+
+WYVKPipelineCache::WYVKPipelineCache(WYVKDevice& device, const std::filesystem::path& path)
+    : m_path(path),
+    m_lastSave(std::chrono::steady_clock::now()),
+    m_device(device)
+{
+    std::vector<char> data = loadCacheData();
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+    VK_CALL(vkCreatePipelineCache(m_device.getLogicalDevice(), &cacheInfo, nullptr, &m_pipelineCache), "Failed to create pipeline cache!");
+
+    m_loadedBytes = data.size();
+    m_savedBytes = data.size();
+    if (isWarm()) {
+        WYVERN_LOG_INFO("Loaded pipeline cache {} ({} bytes)", m_path.string(), m_loadedBytes);
+    }
+}
+
+WYVKPipelineCache::~WYVKPipelineCache()
+{
+    save();
+    vkDestroyPipelineCache(m_device.getLogicalDevice(), m_pipelineCache, nullptr);
+}
+
+std::vector<char> WYVKPipelineCache::loadCacheData()
+{
+    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        WYVERN_LOG_INFO("No pipeline cache found at {}. Starting cold", m_path.string());
+        return {};
+    }
+
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(data.data(), data.size()) || !isHeaderValid(data)) {
+        WYVERN_LOG_WARN("Discarding pipeline cache {}. It is unreadable or was written for another device or driver", m_path.string());
+        return {};
+    }
+    return data;
+}
+
+bool WYVKPipelineCache::isHeaderValid(const std::vector<char>& data)
+{
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device.getPhysicalDevice(), &properties);
+
+    return header.headerSize >= sizeof(header)
+        && header.headerSize <= data.size()
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+size_t WYVKPipelineCache::getCacheDataSize()
+{
+    size_t size = 0;
+    VK_CALL(vkGetPipelineCacheData(m_device.getLogicalDevice(), m_pipelineCache, &size, nullptr), "Failed to query pipeline cache size!");
+    return size;
+}
+
+bool WYVKPipelineCache::save()
+{
+    m_lastSave = std::chrono::steady_clock::now();
+
+    size_t size = getCacheDataSize();
+    std::vector<char> data(size);
+    VK_CALL(vkGetPipelineCacheData(m_device.getLogicalDevice(), m_pipelineCache, &size, data.data()), "Failed to get pipeline cache data!");
+    data.resize(size);
+
+    // Write everything to a temporary file first. Renaming it over the old cache replaces the file in one step
+    std::filesystem::path tempPath = m_path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(data.data(), data.size()) || !file.flush()) {
+            WYVERN_LOG_WARN("Failed to write pipeline cache to {}", tempPath.string());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, m_path, error);
+    if (error) {
+        WYVERN_LOG_WARN("Failed to replace pipeline cache {}: {}", m_path.string(), error.message());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    m_savedBytes = size;
+    WYVERN_LOG_INFO("Saved pipeline cache {} ({} bytes)", m_path.string(), size);
+    return true;
+}
+
+void WYVKPipelineCache::saveIfStale(std::chrono::seconds interval)
+{
+    if (std::chrono::steady_clock::now() - m_lastSave < interval) {
+        return;
+    }
+    // Pipeline caches only grow, so a different size means new pipelines were added since the last save
+    if (getCacheDataSize() == m_savedBytes) {
+        m_lastSave = std::chrono::steady_clock::now();
+        return;
+    }
+    save();
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+
+namespace Wyvern {
+
+/*
+* VkPipelineCache that persists between launches so the driver does not have to compile every pipeline from scratch at startup.
+*
+* The file is only loaded if its header matches the current device (vendorID, deviceID & pipelineCacheUUID). Drivers are supposed to
+* reject foreign data themselves, but some of them crash on it instead. Saving writes to a temporary file that is then renamed over the
+* old one, so a crash while saving leaves the previous cache intact.
+*/
+class WYVKPipelineCache
+{
+public:
+	static constexpr const char* DEFAULT_PATH = "pipeline_cache.bin";
+	static constexpr std::chrono::seconds DEFAULT_SAVE_INTERVAL{ 60 };
+
+	WYVKPipelineCache(WYVKDevice& device, const std::filesystem::path& path = DEFAULT_PATH);
+
+	/*
+	* Saves the cache one last time before destroying it
+	*/
+	~WYVKPipelineCache();
+
+	/*
+	* Writes the cache data to disk. Returns false (and keeps the old file) if writing failed
+	*/
+	bool save();
+
+	/*
+	* Saves the cache if `interval` has passed since the last save and the driver added data to it in the meantime.
+	* Cheap enough to call once per frame
+	*/
+	void saveIfStale(std::chrono::seconds interval = DEFAULT_SAVE_INTERVAL);
+
+	inline VkPipelineCache getPipelineCache() const { return m_pipelineCache; }
+
+	// True if valid data was loaded from disk, meaning pipeline creation should mostly hit the cache
+	inline bool isWarm() const { return m_loadedBytes > 0; }
+	inline size_t getLoadedBytes() const { return m_loadedBytes; }
+
+private:
+	/*
+	* Reads the cache file and checks its header. Returns an empty vector if the file is missing or was written for another device/driver
+	*/
+	std::vector<char> loadCacheData();
+	bool isHeaderValid(const std::vector<char>& data);
+	size_t getCacheDataSize();
+
+	std::filesystem::path m_path;
+	VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+	size_t m_loadedBytes = 0;
+	size_t m_savedBytes = 0;
+	std::chrono::steady_clock::time_point m_lastSave;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -0,0 +1,134 @@
+#include "wyvk_pipeline_registry.h"
+#include "Wyvern/hash.h"
+
+namespace Wyvern {
+
+bool WYVKPipelineRegistry::PipelineKey::operator==(const PipelineKey& other) const
+{
+    return vertexShaderPath == other.vertexShaderPath && fragmentShaderPath == other.fragmentShaderPath && renderPass == other.renderPass &&
+        state == other.state && specializationConstants == other.specializationConstants && instanceInputLocation == other.instanceInputLocation;
+}
+
+size_t WYVKPipelineRegistry::PipelineKeyHash::operator()(const PipelineKey& key) const
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    const std::filesystem::path::string_type& vertexPath = key.vertexShaderPath.native();
+    const std::filesystem::path::string_type& fragmentPath = key.fragmentShaderPath.native();
+    hashBytes(hash, vertexPath.data(), vertexPath.size() * sizeof(vertexPath[0]));
+    hashBytes(hash, fragmentPath.data(), fragmentPath.size() * sizeof(fragmentPath[0]));
+    hashBytes(hash, &key.renderPass, sizeof(key.renderPass));
+    hashBytes(hash, &key.state, sizeof(key.state));
+    hashBytes(hash, key.specializationConstants.data(), key.specializationConstants.size() * sizeof(WYVKGraphicsPipeline::SpecializationConstant));
+    hashBytes(hash, &key.instanceInputLocation, sizeof(key.instanceInputLocation));
+    return static_cast<size_t>(hash);
+}
+
+WYVKPipelineRegistry::WYVKPipelineRegistry(WYVKDevice& device, WYVKSwapchain& swapchain, WYVKRenderPass& renderPass, VkDescriptorSetLayout descriptorSetLayout,
+    const std::vector<VkPushConstantRange>& pushConstantRanges, VkPipelineCache pipelineCache, ThreadPool* compilePool)
+    : m_descriptorSetLayout(descriptorSetLayout),
+    m_pushConstantRanges(pushConstantRanges),
+    m_pipelineCache(pipelineCache),
+    m_compilePool(compilePool),
+    m_device(device),
+    m_swapchain(swapchain),
+    m_renderPass(renderPass)
+{
+}
+
+WYVKPipelineRegistry::~WYVKPipelineRegistry()
+{
+    WYVERN_LOG_INFO("Destroying {} pipeline variants", m_pipelines.size());
+}
+
+WYVKGraphicsPipeline& WYVKPipelineRegistry::getPipeline(const PipelineKey& key, uint64_t frameSerial)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_pipelines.find(key);
+    if (it == m_pipelines.end()) {
+        WYVKRenderPass& renderPass = key.renderPass ? *key.renderPass : m_renderPass;
+        auto pipeline = std::make_unique<WYVKGraphicsPipeline>(m_device, m_swapchain, renderPass, key.vertexShaderPath, key.fragmentShaderPath);
+        pipeline->setState(key.state);
+        pipeline->setSpecializationConstants(key.specializationConstants);
+        pipeline->setInstanceInputLocation(key.instanceInputLocation);
+        pipeline->setPushConstantRanges(m_pushConstantRanges);
+        if (m_compilePool) {
+            pipeline->createGraphicsPipelineAsync(*m_compilePool, m_descriptorSetLayout, m_pipelineCache);
+        }
+        else {
+            pipeline->createGraphicsPipeline(m_descriptorSetLayout, m_pipelineCache);
+        }
+
+        WYVERN_LOG_INFO("Creating pipeline variant {} for {} ({} variants)", PipelineKeyHash()(key), key.vertexShaderPath.filename().string(), m_pipelines.size() + 1);
+        Entry entry;
+        entry.pipeline = std::move(pipeline);
+        entry.createdFrame = frameSerial;
+        it = m_pipelines.emplace(key, std::move(entry)).first;
+    }
+
+    it->second.useCount++;
+    it->second.lastUsedFrame = std::max(it->second.lastUsedFrame, frameSerial);
+    return *it->second.pipeline;
+}
+
+void WYVKPipelineRegistry::evictUnused(uint64_t completedSerial, uint64_t maxIdleFrames)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_pipelines.begin(); it != m_pipelines.end();) {
+        const Entry& entry = it->second;
+        if (entry.pipeline->isReady() && entry.lastUsedFrame + maxIdleFrames <= completedSerial) {
+            WYVERN_LOG_INFO("Evicting pipeline variant for {} (used {} times, last in frame {})",
+                it->first.vertexShaderPath.filename().string(), entry.useCount, entry.lastUsedFrame);
+            it = m_pipelines.erase(it);
+        }
+        else if (entry.pipeline->hasFailed() && entry.createdFrame + FAILED_RETRY_FRAMES <= completedSerial) {
+            WYVERN_LOG_WARN("Evicting failed pipeline variant for {}, it is built again the next time it is asked for",
+                it->first.vertexShaderPath.filename().string());
+            it = m_pipelines.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+std::vector<std::unique_ptr<WYVKGraphicsPipeline>> WYVKPipelineRegistry::invalidate(const std::vector<std::filesystem::path>& changedFiles)
+{
+    std::vector<std::unique_ptr<WYVKGraphicsPipeline>> removed;
+    if (changedFiles.empty()) {
+        return removed;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_pipelines.begin(); it != m_pipelines.end();) {
+        WYVKGraphicsPipeline& pipeline = *it->second.pipeline;
+        bool affected = pipeline.hasFailed() ||
+            std::any_of(changedFiles.begin(), changedFiles.end(), [&](const std::filesystem::path& file) { return pipeline.dependsOn(file); });
+        if (affected) {
+            removed.push_back(std::move(it->second.pipeline));
+            it = m_pipelines.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+std::vector<WYVKPipelineRegistry::UsageInfo> WYVKPipelineRegistry::getUsage()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<UsageInfo> usage;
+    usage.reserve(m_pipelines.size());
+    for (const auto& pipeline : m_pipelines) {
+        usage.push_back({ &pipeline.first, pipeline.second.useCount, pipeline.second.lastUsedFrame, pipeline.second.pipeline->isReady() });
+    }
+    return usage;
+}
+
+size_t WYVKPipelineRegistry::getPipelineCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pipelines.size();
+}
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "../wyvk_swapchain.h"
+#include "wyvk_graphics_pipeline.h"
+#include "wyvk_renderpass.h"
+
+namespace Wyvern {
+
+/*
+* Owns every pipeline variant the renderer asks for and creates them on first use.
+*
+* A variant is identified by a PipelineKey: the shader pair, the render pass, the variable fixed function state and the specialization
+* constants. Lookups are a hash map find, so asking for a pipeline every frame is cheap. Missing variants are built on the compile pool
+* when there is one, callers keep drawing with something else until isReady() returns true.
+* Every lookup counts as a use, and variants that have not been used for a while can be evicted with evictUnused().
+* Variants whose build failed are dropped as well, so they are built again by a later lookup or a shader reload.
+*/
+class WYVKPipelineRegistry
+{
+public:
+	// A failed variant is built again at most this often while it keeps being asked for
+	static constexpr uint64_t FAILED_RETRY_FRAMES = 120;
+
+	struct PipelineKey {
+		std::filesystem::path vertexShaderPath = WYVKGraphicsPipeline::DEFAULT_VERTEX_SHADER;
+		std::filesystem::path fragmentShaderPath = WYVKGraphicsPipeline::DEFAULT_FRAGMENT_SHADER;
+		WYVKRenderPass* renderPass = nullptr; // The registry's default render pass if null
+		WYVKGraphicsPipeline::PipelineState state;
+		std::vector<WYVKGraphicsPipeline::SpecializationConstant> specializationConstants;
+		uint32_t instanceInputLocation = UINT32_MAX; // See WYVKGraphicsPipeline::setInstanceInputLocation()
+
+		bool operator==(const PipelineKey& other) const;
+	};
+
+	struct PipelineKeyHash {
+		size_t operator()(const PipelineKey& key) const;
+	};
+
+	struct UsageInfo {
+		const PipelineKey* key;
+		uint64_t useCount;
+		uint64_t lastUsedFrame;
+		bool ready;
+	};
+
+	/*
+	* Every variant is created with `descriptorSetLayout` & `pushConstantRanges`, so they can all share the same descriptor sets.
+	* Without a `compilePool` variants are built right away on the thread that asks for them
+	*/
+	WYVKPipelineRegistry(WYVKDevice& device, WYVKSwapchain& swapchain, WYVKRenderPass& renderPass, VkDescriptorSetLayout descriptorSetLayout,
+		const std::vector<VkPushConstantRange>& pushConstantRanges, VkPipelineCache pipelineCache, ThreadPool* compilePool = nullptr);
+	~WYVKPipelineRegistry();
+
+	/*
+	* Returns the pipeline for `key`, starting its build if it does not exist yet. Counts as a use in `frameSerial`. Thread safe.
+	* The pipeline may still be building, check isReady() before binding it
+	*/
+	WYVKGraphicsPipeline& getPipeline(const PipelineKey& key, uint64_t frameSerial);
+
+	/*
+	* Removes the variants last used `maxIdleFrames` or more frames before `completedSerial`. The GPU is done with every frame up to
+	* `completedSerial`, so they can be destroyed right away. Variants that are still building are kept. Variants whose build failed
+	* were never bound, they are removed FAILED_RETRY_FRAMES after they were created
+	*/
+	void evictUnused(uint64_t completedSerial, uint64_t maxIdleFrames);
+
+	/*
+	* Removes the variants built from any of `changedFiles` (sources or includes) and every variant whose build failed, so the next
+	* getPipeline() rebuilds them. The removed pipelines are returned because in flight frames may still use them
+	*/
+	std::vector<std::unique_ptr<WYVKGraphicsPipeline>> invalidate(const std::vector<std::filesystem::path>& changedFiles);
+
+	std::vector<UsageInfo> getUsage();
+	size_t getPipelineCount();
+
+private:
+	struct Entry {
+		std::unique_ptr<WYVKGraphicsPipeline> pipeline;
+		uint64_t useCount = 0;
+		uint64_t lastUsedFrame = 0;
+		uint64_t createdFrame = 0;
+	};
+
+	std::unordered_map<PipelineKey, Entry, PipelineKeyHash> m_pipelines;
+	std::mutex m_mutex;
+
+	VkDescriptorSetLayout m_descriptorSetLayout;
+	std::vector<VkPushConstantRange> m_pushConstantRanges;
+	VkPipelineCache m_pipelineCache;
+	ThreadPool* m_compilePool;
+
+	// Handles
+	WYVKDevice& m_device;
+	WYVKSwapchain& m_swapchain;
+	WYVKRenderPass& m_renderPass;
+};
+
+}
@@ -2,30 +2,35 @@
 
 namespace Wyvern {
 
-WYVKRenderPass::WYVKRenderPass(WYVKSwapchain& swapchain, WYVKDevice& device)
-	: m_device(device),
+WYVKRenderPass::WYVKRenderPass(WYVKSwapchain& swapchain, WYVKDevice& device, bool dynamicRendering)
+	: m_dynamicRendering(dynamicRendering),
+	m_device(device),
 	m_swapchain(swapchain)
 {
-	createImageResources();
+	m_colorFormat = m_swapchain.getImageFormat();
+	m_depthFormat = WYVKImage::findDepthFormat(m_device);
 }
 
 WYVKRenderPass::~WYVKRenderPass()
 {
-	destroyImageResources();
-	destroyFramebuffers();
 	// Destroy render pass
 	vkDestroyRenderPass(m_device.getLogicalDevice(), m_renderPass, nullptr);
 }
 
 void WYVKRenderPass::createRenderPass()
 {
+	// Nothing to create, pipelines only need the attachment formats
+	if (m_dynamicRendering) {
+		return;
+	}
+
 	/*
 	* =============================================
 	*  COLOR ATTACHMENT
 	* =============================================
 	*/
 	VkAttachmentDescription colorAttachment{};
-	colorAttachment.format = m_swapchain.getImageFormat();
+	colorAttachment.format = m_colorFormat;
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT; // multisampling for msaa
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -44,7 +49,7 @@ void WYVKRenderPass::createRenderPass()
 	* =============================================
 	*/
 	VkAttachmentDescription depthAttachment{};
-	depthAttachment.format = m_depthImage->getFormat();
+	depthAttachment.format = m_depthFormat;
 	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -72,14 +77,9 @@ void WYVKRenderPass::createRenderPass()
 	* =============================================
 	* SUBPASS DEPENDENCIES
 	* =============================================
+	* None. The render graph records the barriers around its passes, and a dependency here would make this pass incompatible
+	* with the graph's render passes
 	*/
-	VkSubpassDependency dependency{};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL; // Source/before subpass. EXTERNAL here represents the implicit starting subpass
-	dependency.dstSubpass = 0; // Destination subpass index
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT; // Wait on color attachment image and depth early fragment tests before proceeding with the next subpass
-	dependency.srcAccessMask = 0;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT; // What we are doing next basically. The operations that are waiting on the VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
 	// =============================================
 	// NOTE
@@ -95,55 +95,24 @@ void WYVKRenderPass::createRenderPass()
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
 
 	VK_CALL(vkCreateRenderPass(m_device.getLogicalDevice(), &renderPassInfo, nullptr, &m_renderPass), "Failed to create Renderpass!");
 }
 
-void WYVKRenderPass::createFramebuffers()
-{
-	std::vector<VkImageView>& imageViews = m_swapchain.getImageViews();
-	m_framebuffers.resize(imageViews.size());
-
-	for (size_t i = 0; i < imageViews.size(); i++) {
-
-		std::array<VkImageView, 2> attachments = {
-			imageViews[i],
-			m_depthImage->getImageView()
-		};
-
-		VkFramebufferCreateInfo framebufferInfo{};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = m_renderPass;
-		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		framebufferInfo.pAttachments = attachments.data();
-		framebufferInfo.width = m_swapchain.getExtent().width;
-		framebufferInfo.height = m_swapchain.getExtent().height;
-		framebufferInfo.layers = 1;
-
-		VK_CALL(vkCreateFramebuffer(m_device.getLogicalDevice(), &framebufferInfo, nullptr, &m_framebuffers[i]), "Failed to create framebuffer!");
-	}
-}
-
-void WYVKRenderPass::createImageResources()
+VkFormat WYVKRenderPass::getStencilFormat() const
 {
-	m_depthImage = std::make_unique<WYVKImage>(m_device, WYVKImage::ImageType::WYVK_DEPTH_IMAGE, m_swapchain.getExtent().width, m_swapchain.getExtent().height,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	m_depthImage->createImageView(VK_IMAGE_ASPECT_DEPTH_BIT);
+	return WYVKImage::hasStencilComponent(m_depthFormat) ? m_depthFormat : VK_FORMAT_UNDEFINED;
 }
 
-void WYVKRenderPass::destroyImageResources()
+VkPipelineRenderingCreateInfo WYVKRenderPass::getRenderingInfo() const
 {
-	m_depthImage.reset();
-}
-
-void WYVKRenderPass::destroyFramebuffers()
-{
-	// Destroy all framebuffers
-	for (auto framebuffer : m_framebuffers) {
-		vkDestroyFramebuffer(m_device.getLogicalDevice(), framebuffer, nullptr);
-	}
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachmentFormats = &m_colorFormat;
+	renderingInfo.depthAttachmentFormat = m_depthFormat;
+	renderingInfo.stencilAttachmentFormat = getStencilFormat();
+	return renderingInfo;
 }
 
 }
@@ -1,14 +1,22 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "../wyvk_device.h"
 #include "../wyvk_swapchain.h"
 
 namespace Wyvern {
 
+/*
+* Render pass the graphics pipelines and ImGui are created against. Frames are drawn by the render graph, which builds its own
+* render passes & framebuffers. The graph's "Scene" pass has the same attachments (swapchain color, depth) and no subpass dependencies
+* either, so the two are compatible and pipelines created for this pass can be used inside it.
+*
+* With dynamic rendering there is no VkRenderPass at all (getRenderPass() is VK_NULL_HANDLE). Pipelines are created against the
+* attachment formats (see getRenderingInfo()) and the graph begins its passes with vkCmdBeginRendering.
+*/
 class WYVKRenderPass
 {
 public:
-	WYVKRenderPass(WYVKSwapchain& swapchain, WYVKDevice& device);
+	WYVKRenderPass(WYVKSwapchain& swapchain, WYVKDevice& device, bool dynamicRendering = false);
 	~WYVKRenderPass();
 
 	/*
@@ -45,23 +53,25 @@ public:
 	* - VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : Images to be used as destination for a memory copy operation. most likely for post processing?
 	*/
 	void createRenderPass();
-	void createFramebuffers();
-	void createImageResources();
-
-	// Deletes all images and image views related to the renderpass attachments. For example depth and stencil attachments
-	void destroyImageResources();
-	void destroyFramebuffers();
 
 	inline VkRenderPass getRenderPass() { return m_renderPass; }
-	inline std::vector<VkFramebuffer>& getFrameBuffers() { return m_framebuffers; }
+	inline bool isDynamicRendering() const { return m_dynamicRendering; }
+	inline VkFormat getColorFormat() const { return m_colorFormat; }
+	inline VkFormat getDepthFormat() const { return m_depthFormat; }
+	// VK_FORMAT_UNDEFINED if the depth format has no stencil
+	VkFormat getStencilFormat() const;
+
+	/*
+	* Attachment formats for VkGraphicsPipelineCreateInfo::pNext when using dynamic rendering. The color format points into this object
+	*/
+	VkPipelineRenderingCreateInfo getRenderingInfo() const;
 
 private:
 	VkRenderPass m_renderPass = VK_NULL_HANDLE;
 	std::vector<VkSubpassDescription> subpasses;
-
-	// Image attachments used in subpasses e.g. depth, stencil or color images
-	std::unique_ptr<WYVKImage> m_depthImage;
-	std::vector<VkFramebuffer> m_framebuffers;
+	VkFormat m_depthFormat;
+	VkFormat m_colorFormat;
+	bool m_dynamicRendering;
 
 	// Handles
 	WYVKDevice& m_device;
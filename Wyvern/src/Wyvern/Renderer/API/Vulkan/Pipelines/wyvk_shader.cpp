@@ -3,8 +3,8 @@
 
 Wyvern::WYVKShader::WYVKShader(WYVKDevice& device, std::filesystem::path& filePath, VkShaderStageFlagBits shaderStage)
     : m_filePath(filePath),
-    m_device(device),
-    m_shaderStage(shaderStage)
+    m_shaderStage(shaderStage),
+    m_device(device)
 {
 }
 
@@ -14,13 +14,10 @@ Wyvern::WYVKShader::~WYVKShader()
 
 void Wyvern::WYVKShader::compile()
 {
-    shaderc::Compiler compiler;
-    shaderc::CompileOptions options;
-
 #ifdef NDEBUG
-    options.SetOptimizationLevel(shaderc_optimization_level_size);
+    shaderc_optimization_level optimizationLevel = shaderc_optimization_level_size;
 #else
-    options.SetOptimizationLevel(shaderc_optimization_level_zero);
+    shaderc_optimization_level optimizationLevel = shaderc_optimization_level_zero;
 #endif
 
     std::ifstream file(m_filePath, std::ios::binary);
@@ -32,8 +29,24 @@ void Wyvern::WYVKShader::compile()
     // Get contents of file in string format
     std::string source((std::istreambuf_iterator<char>(file)), 
                         std::istreambuf_iterator<char>()); 
-    // Compile (source file contents, shader kind: vert or frag, file path, compiler options)
     shaderc_shader_kind kind = mapShaderStageToKind(m_shaderStage);
+
+    // Unchanged shaders are loaded from the SPIR-V cache without creating a compiler at all
+    m_includedFiles.clear();
+    uint64_t key = WYVKShaderCache::computeKey(source, m_filePath, kind, optimizationLevel, &m_includedFiles);
+    m_cacheKey = key;
+    if (m_cache.load(key, m_binary)) {
+        m_fromCache = true;
+        return;
+    }
+
+    // shaderc compilers are not thread safe, so every thread compiling shaders keeps its own. Creating one is not free either
+    static thread_local shaderc::Compiler compiler;
+    shaderc::CompileOptions options;
+    options.SetOptimizationLevel(optimizationLevel);
+    options.SetIncluder(std::make_unique<WYVKShaderIncluder>());
+
+    // Compile (source file contents, shader kind: vert or frag, file path, compiler options)
     shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(source, kind, m_filePath.string().c_str(), options);
 
     // Check if compilation succeeded
@@ -43,6 +56,7 @@ void Wyvern::WYVKShader::compile()
     }
 
     m_binary = std::vector<uint32_t>(module.begin(), module.end());
+    m_cache.store(key, m_binary);
 }
 
 VkShaderModule Wyvern::WYVKShader::createShaderModule(const std::vector<uint32_t>& code)
@@ -1,7 +1,8 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/Renderer/API/Vulkan/wyvk_device.h"
 #include <shaderc/shaderc.hpp>
+#include "wyvk_shader_cache.h"
 
 namespace Wyvern {
 
@@ -11,9 +12,17 @@ public:
 	WYVKShader(WYVKDevice& device, std::filesystem::path& filePath, VkShaderStageFlagBits shaderStage);
 	~WYVKShader();
 
+	/*
+	* Compiles the GLSL source to SPIR-V, or loads it from the SPIR-V cache if neither the source, its includes nor the compile settings changed
+	*/
 	void compile();
 	VkShaderModule createShaderModule(const std::vector<uint32_t>& code);
 	std::vector<uint32_t> getBinary() { return m_binary; }
+	inline bool isFromCache() const { return m_fromCache; }
+	// Identifies the compiled binary (see WYVKShaderCache::computeKey()). Valid after compile()
+	inline uint64_t getCacheKey() const { return m_cacheKey; }
+	// Every file #included by the shader, found while computing the cache key
+	inline const std::vector<std::filesystem::path>& getIncludedFiles() const { return m_includedFiles; }
 
 private:
 	shaderc_shader_kind mapShaderStageToKind(VkShaderStageFlagBits stage);
@@ -21,6 +30,10 @@ private:
 	std::filesystem::path m_filePath;
 	VkShaderStageFlagBits m_shaderStage;
 	std::vector<uint32_t> m_binary;
+	std::vector<std::filesystem::path> m_includedFiles;
+	WYVKShaderCache m_cache;
+	uint64_t m_cacheKey = 0;
+	bool m_fromCache = false;
 
 	// Handles
 	WYVKDevice& m_device;
@@ -0,0 +1,239 @@
+#include "wyvk_shader_cache.h"
+#include <fstream>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+
+#include "Wyvern/hash.h"
+
+// glslang (the compiler inside shaderc) publishes its version since SDK 1.3.2xx. shaderc itself has no version query
+#if __has_include(<glslang/build_info.h>)
+	#include <glslang/build_info.h>
+	#define WYVK_GLSLANG_VERSION (GLSLANG_VERSION_MAJOR * 1000000 + GLSLANG_VERSION_MINOR * 1000 + GLSLANG_VERSION_PATCH)
+#else
+	#define WYVK_GLSLANG_VERSION 0
+#endif
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Wyvern {
+
+// Bump when the key layout or the blob format changes, or when shaderc is upgraded without the SDK headers changing
+// (the compiler identity in computeKey() can't see that)
+static constexpr uint64_t CACHE_FORMAT_VERSION = 2;
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+static bool readFile(const std::filesystem::path& path, std::string& outContent)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    outContent.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/*
+* Hashes the contents of every file included by `source`, depth first in include order. Files already visited are skipped
+* the same way an include guard would skip them
+*/
+static void hashIncludes(uint64_t& hash, const std::string& source, const std::filesystem::path& sourcePath,
+    std::unordered_set<std::string>& visited, std::vector<std::filesystem::path>* includedFiles)
+{
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t directive = line.find_first_not_of(" \t");
+        if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0) {
+            continue;
+        }
+        size_t open = line.find_first_of("\"<", directive + 8);
+        if (open == std::string::npos) {
+            continue;
+        }
+        size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+        if (close == std::string::npos) {
+            continue;
+        }
+
+        shaderc_include_type type = line[open] == '"' ? shaderc_include_type_relative : shaderc_include_type_standard;
+        std::filesystem::path includePath = WYVKShaderIncluder::resolve(line.substr(open + 1, close - open - 1), type, sourcePath);
+        if (!visited.insert(includePath.string()).second) {
+            continue;
+        }
+
+        std::string includeSource;
+        readFile(includePath, includeSource); // A missing include still changes the key (empty content), compilation reports the error
+        std::string name = includePath.string();
+        hashBytes(hash, name.data(), name.size());
+        hashBytes(hash, includeSource.data(), includeSource.size());
+        if (includedFiles) {
+            includedFiles->push_back(includePath);
+        }
+        hashIncludes(hash, includeSource, includePath, visited, includedFiles);
+    }
+}
+
+WYVKShaderCache::WYVKShaderCache(const std::filesystem::path& directory)
+    : m_directory(directory)
+{
+}
+
+uint64_t WYVKShaderCache::computeKey(const std::string& source, const std::filesystem::path& sourcePath, shaderc_shader_kind kind,
+    shaderc_optimization_level optimizationLevel, std::vector<std::filesystem::path>* includedFiles)
+{
+    unsigned int spirvVersion = 0;
+    unsigned int spirvRevision = 0;
+    shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+
+    // Compiler identity. shaderc comes with the Vulkan SDK, so the SDK header version changes with every compiler it ships.
+    // The glslang version catches compilers built outside the SDK when glslang publishes it
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hashValue(hash, CACHE_FORMAT_VERSION);
+    hashValue(hash, static_cast<uint64_t>(VK_HEADER_VERSION_COMPLETE));
+    hashValue(hash, static_cast<uint64_t>(WYVK_GLSLANG_VERSION));
+    hashValue(hash, spirvVersion);
+    hashValue(hash, spirvRevision);
+    hashValue(hash, kind);
+    hashValue(hash, optimizationLevel);
+    hashBytes(hash, source.data(), source.size());
+
+    std::unordered_set<std::string> visited;
+    hashIncludes(hash, source, sourcePath, visited, includedFiles);
+    return hash;
+}
+
+std::filesystem::path WYVKShaderCache::getBlobPath(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+    return m_directory / name;
+}
+
+bool WYVKShaderCache::load(uint64_t key, std::vector<uint32_t>& outBinary) const
+{
+    std::filesystem::path path = getBlobPath(key);
+    const void* view = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    HANDLE mapping = size > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat fileStat {};
+    fstat(file, &fileStat);
+    size = static_cast<size_t>(fileStat.st_size);
+    if (size > 0) {
+        view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view == MAP_FAILED) {
+            view = nullptr;
+        }
+    }
+#endif
+
+    bool valid = view && size >= sizeof(uint32_t) && size % sizeof(uint32_t) == 0 && *static_cast<const uint32_t*>(view) == SPIRV_MAGIC;
+    if (valid) {
+        outBinary.resize(size / sizeof(uint32_t));
+        memcpy(outBinary.data(), view, size);
+    }
+
+#ifdef _WIN32
+    if (view) {
+        UnmapViewOfFile(view);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    if (view) {
+        munmap(const_cast<void*>(view), size);
+    }
+    close(file);
+#endif
+
+    if (!valid) {
+        WYVERN_LOG_WARN("Ignoring invalid SPIR-V cache entry {}", path.string());
+    }
+    return valid;
+}
+
+void WYVKShaderCache::store(uint64_t key, const std::vector<uint32_t>& binary) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    std::filesystem::path path = getBlobPath(key);
+    // Unique per writer. Pool threads compiling the same shader on a cold cache must not write into each other's file
+    static std::atomic<uint64_t> s_tempCounter{ 0 };
+    std::filesystem::path tempPath = path;
+    tempPath += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." + std::to_string(s_tempCounter++) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(reinterpret_cast<const char*>(binary.data()), binary.size() * sizeof(uint32_t))) {
+            WYVERN_LOG_WARN("Failed to write SPIR-V cache entry {}", tempPath.string());
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        WYVERN_LOG_WARN("Failed to store SPIR-V cache entry {}: {}", path.string(), error.message());
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+std::filesystem::path WYVKShaderIncluder::resolve(const std::string& requestedSource, shaderc_include_type type, const std::filesystem::path& requestingSource)
+{
+    // Relative includes start next to the including file. Standard includes start in the directory of the shaders
+    std::filesystem::path base = type == shaderc_include_type_relative
+        ? requestingSource.parent_path()
+        : std::filesystem::absolute("src/Wyvern/Assets/Shaders");
+    return (base / requestedSource).lexically_normal();
+}
+
+shaderc_include_result* WYVKShaderIncluder::GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth)
+{
+    IncludeData* data = new IncludeData();
+    std::filesystem::path path = resolve(requestedSource, type, requestingSource);
+    if (readFile(path, data->content)) {
+        data->sourceName = path.string();
+    }
+    else {
+        // An empty source name tells shaderc the include failed, the content is the error message
+        data->content = "Cannot open include file " + path.string();
+    }
+
+    data->result.source_name = data->sourceName.c_str();
+    data->result.source_name_length = data->sourceName.size();
+    data->result.content = data->content.c_str();
+    data->result.content_length = data->content.size();
+    data->result.user_data = data;
+    return &data->result;
+}
+
+void WYVKShaderIncluder::ReleaseInclude(shaderc_include_result* data)
+{
+    delete static_cast<IncludeData*>(data->user_data);
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include <shaderc/shaderc.hpp>
+
+namespace Wyvern {
+
+/*
+* On disk cache of compiled SPIR-V, one `<key>.spv` file per shader variant.
+*
+* The key hashes everything that changes the output of shaderc: the GLSL source, the contents of every file it #includes
+* (resolved the same way WYVKShaderIncluder resolves them, recursively), the shader stage, the optimization level, the
+* SPIR-V version shaderc targets and the compiler's identity (Vulkan SDK & glslang version). Editing an included file or upgrading
+* the compiler therefore produces a new key, and stale blobs are simply never looked up again.
+* Hits are read through a memory mapped view of the file and never touch shaderc.
+*/
+class WYVKShaderCache
+{
+public:
+	static constexpr const char* DEFAULT_DIRECTORY = "shader_cache";
+
+	WYVKShaderCache(const std::filesystem::path& directory = DEFAULT_DIRECTORY);
+
+	/*
+	* Hashes `source` (read from `sourcePath`) together with its includes and compile settings. `includedFiles` receives every
+	* file the source pulls in, which is what a file watcher needs to know when the shader has to be rebuilt
+	*/
+	static uint64_t computeKey(const std::string& source, const std::filesystem::path& sourcePath, shaderc_shader_kind kind,
+		shaderc_optimization_level optimizationLevel, std::vector<std::filesystem::path>* includedFiles = nullptr);
+
+	/*
+	* Loads the SPIR-V stored under `key`. Returns false if there is none or the file is not valid SPIR-V
+	*/
+	bool load(uint64_t key, std::vector<uint32_t>& outBinary) const;
+
+	/*
+	* Stores `binary` under `key`. Written to a temporary file unique to the call and renamed, so concurrent readers never see a
+	* partial blob and concurrent writers of the same key don't interleave
+	*/
+	void store(uint64_t key, const std::vector<uint32_t>& binary) const;
+
+private:
+	std::filesystem::path getBlobPath(uint64_t key) const;
+
+	std::filesystem::path m_directory;
+};
+
+/*
+* Resolves `#include "file"` relative to the including file (and `#include <file>` relative to the shader directory) for shaderc.
+* WYVKShaderCache::computeKey() resolves includes with the same rules
+*/
+class WYVKShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+{
+public:
+	static std::filesystem::path resolve(const std::string& requestedSource, shaderc_include_type type, const std::filesystem::path& requestingSource);
+
+	shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override;
+	void ReleaseInclude(shaderc_include_result* data) override;
+
+private:
+	// Owns the strings a shaderc_include_result points to until shaderc releases it
+	struct IncludeData {
+		shaderc_include_result result;
+		std::string sourceName;
+		std::string content;
+	};
+};
+
+}
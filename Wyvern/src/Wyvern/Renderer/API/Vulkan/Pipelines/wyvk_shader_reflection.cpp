@@ -0,0 +1,473 @@
+#include "wyvk_shader_reflection.h"
+#include <cstring>
+#include <map>
+
+namespace Wyvern {
+
+std::unordered_map<uint64_t, std::shared_ptr<const WYVKShaderReflection::Reflection>> WYVKShaderReflection::s_cache;
+std::mutex WYVKShaderReflection::s_cacheMutex;
+
+// The subset of the SPIR-V spec the parser needs (https://registry.khronos.org/SPIR-V/specs/unified1/SPIRV.html)
+namespace SpirV {
+    static constexpr uint32_t MAGIC = 0x07230203;
+    static constexpr uint32_t HEADER_WORDS = 5;
+
+    enum Op : uint32_t {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructureKHR = 5341,
+    };
+
+    enum Decoration : uint32_t {
+        Block = 2,
+        BufferBlock = 3,
+        ArrayStride = 6,
+        MatrixStride = 7,
+        BuiltIn = 11,
+        Location = 30,
+        Binding = 33,
+        DescriptorSet = 34,
+        Offset = 35,
+    };
+
+    enum StorageClass : uint32_t {
+        UniformConstant = 0,
+        Input = 1,
+        Uniform = 2,
+        PushConstant = 9,
+        StorageBuffer = 12,
+    };
+
+    enum Dim : uint32_t {
+        DimBuffer = 5,
+        DimSubpassData = 6,
+    };
+}
+
+namespace {
+
+struct Decorations {
+    std::map<uint32_t, uint32_t> values;                        // Decoration -> first literal
+    std::map<uint32_t, std::map<uint32_t, uint32_t>> members;    // Member -> decoration -> first literal
+
+    bool has(uint32_t decoration) const { return values.count(decoration) > 0; }
+    uint32_t get(uint32_t decoration, uint32_t fallback = 0) const {
+        auto it = values.find(decoration);
+        return it == values.end() ? fallback : it->second;
+    }
+    uint32_t getMember(uint32_t member, uint32_t decoration, uint32_t fallback = 0) const {
+        auto it = members.find(member);
+        if (it == members.end()) {
+            return fallback;
+        }
+        auto value = it->second.find(decoration);
+        return value == it->second.end() ? fallback : value->second;
+    }
+};
+
+struct Module {
+    std::unordered_map<uint32_t, std::vector<uint32_t>> types;  // Result id -> instruction words (opcode first)
+    std::unordered_map<uint32_t, uint32_t> constants;
+    std::unordered_map<uint32_t, Decorations> decorations;
+    std::unordered_map<uint32_t, std::string> names;            // OpName debug names. Missing if the shader was stripped
+    std::vector<std::vector<uint32_t>> variables;
+    VkShaderStageFlags stages = 0;
+
+    const std::vector<uint32_t>& type(uint32_t id) const {
+        auto it = types.find(id);
+        if (it == types.end()) {
+            WYVERN_THROW("SPIR-V reflection: unknown type id " + std::to_string(id));
+        }
+        return it->second;
+    }
+    std::string nameOf(uint32_t id) const {
+        auto it = names.find(id);
+        return it == names.end() ? std::string() : it->second;
+    }
+    const Decorations& decorationsOf(uint32_t id) const {
+        static const Decorations none;
+        auto it = decorations.find(id);
+        return it == decorations.end() ? none : it->second;
+    }
+
+    /*
+    * Size in bytes of a type inside a block (std140/std430/scalar all use the explicit Offset & Stride decorations)
+    */
+    uint32_t sizeOf(uint32_t id, uint32_t matrixStride = 0) const {
+        const std::vector<uint32_t>& t = type(id);
+        switch (t[0]) {
+        case SpirV::OpTypeBool:
+            return 4;
+        case SpirV::OpTypeInt:
+        case SpirV::OpTypeFloat:
+            return t[2] / 8;
+        case SpirV::OpTypeVector:
+            return sizeOf(t[2]) * t[3];
+        case SpirV::OpTypeMatrix:
+            return (matrixStride ? matrixStride : sizeOf(t[2])) * t[3];
+        case SpirV::OpTypeArray:
+            return decorationsOf(id).get(SpirV::ArrayStride, sizeOf(t[2])) * constants.at(t[3]);
+        case SpirV::OpTypeRuntimeArray:
+            return 0;
+        case SpirV::OpTypeStruct: {
+            // The struct ends after its last member. Members are not guaranteed to be ordered by offset
+            const Decorations& memberDecorations = decorationsOf(id);
+            uint32_t size = 0;
+            for (uint32_t member = 0; member + 2 < t.size(); member++) {
+                uint32_t offset = memberDecorations.getMember(member, SpirV::Offset);
+                uint32_t stride = memberDecorations.getMember(member, SpirV::MatrixStride);
+                size = std::max(size, offset + sizeOf(t[member + 2], stride));
+            }
+            return size;
+        }
+        default:
+            return 0;
+        }
+    }
+};
+
+VkShaderStageFlags executionModelToStage(uint32_t model)
+{
+    switch (model) {
+    case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+    case 5313: return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+    case 5314: return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+    case 5315: return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+    case 5316: return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+    case 5317: return VK_SHADER_STAGE_MISS_BIT_KHR;
+    case 5318: return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+    default: return 0;
+    }
+}
+
+/*
+* Format of a scalar or vector vertex input. `scalar` is the OpTypeInt/OpTypeFloat instruction of the component type
+*/
+VkFormat vertexFormat(const std::vector<uint32_t>& scalar, uint32_t componentCount)
+{
+    static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static const VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+    if ((scalar[0] != SpirV::OpTypeFloat && scalar[0] != SpirV::OpTypeInt) || componentCount < 1 || componentCount > 4 || scalar[2] != 32) {
+        return VK_FORMAT_UNDEFINED; // Only 32 bit scalars & vectors. No 16/64 bit or block inputs
+    }
+    if (scalar[0] == SpirV::OpTypeFloat) {
+        return floatFormats[componentCount - 1];
+    }
+    return scalar[3] ? intFormats[componentCount - 1] : uintFormats[componentCount - 1];
+}
+
+}
+
+WYVKShaderReflection::Reflection WYVKShaderReflection::parse(const std::vector<uint32_t>& spirv)
+{
+    if (spirv.size() < SpirV::HEADER_WORDS || spirv[0] != SpirV::MAGIC) {
+        WYVERN_THROW("SPIR-V reflection: not a SPIR-V binary");
+    }
+
+    Module module;
+    for (size_t i = SpirV::HEADER_WORDS; i < spirv.size();) {
+        uint32_t wordCount = spirv[i] >> 16;
+        uint32_t opcode = spirv[i] & 0xFFFF;
+        if (wordCount == 0 || i + wordCount > spirv.size()) {
+            WYVERN_THROW("SPIR-V reflection: malformed instruction stream");
+        }
+        std::vector<uint32_t> words(spirv.begin() + i, spirv.begin() + i + wordCount);
+        words[0] = opcode;
+        i += wordCount;
+
+        switch (opcode) {
+        case SpirV::OpName: {
+            // Nul terminated UTF-8 packed into the words after the target id
+            const char* name = reinterpret_cast<const char*>(words.data() + 2);
+            module.names[words[1]] = std::string(name, strnlen(name, (words.size() - 2) * sizeof(uint32_t)));
+            break;
+        }
+        case SpirV::OpEntryPoint:
+            module.stages |= executionModelToStage(words[1]);
+            break;
+        case SpirV::OpTypeBool:
+        case SpirV::OpTypeInt:
+        case SpirV::OpTypeFloat:
+        case SpirV::OpTypeVector:
+        case SpirV::OpTypeMatrix:
+        case SpirV::OpTypeImage:
+        case SpirV::OpTypeSampler:
+        case SpirV::OpTypeSampledImage:
+        case SpirV::OpTypeArray:
+        case SpirV::OpTypeRuntimeArray:
+        case SpirV::OpTypeStruct:
+        case SpirV::OpTypePointer:
+        case SpirV::OpTypeAccelerationStructureKHR:
+            module.types[words[1]] = words;
+            break;
+        case SpirV::OpConstant:
+            module.constants[words[2]] = words[3]; // Lower 32 bits are enough for array lengths
+            break;
+        case SpirV::OpVariable:
+            module.variables.push_back(words);
+            break;
+        case SpirV::OpDecorate:
+            module.decorations[words[1]].values[words[2]] = words.size() > 3 ? words[3] : 0;
+            break;
+        case SpirV::OpMemberDecorate:
+            module.decorations[words[1]].members[words[2]][words[3]] = words.size() > 4 ? words[4] : 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    Reflection reflection;
+    reflection.stages = module.stages;
+    uint32_t pushConstantSize = 0;
+
+    for (const std::vector<uint32_t>& variable : module.variables) {
+        uint32_t id = variable[2];
+        uint32_t storageClass = variable[3];
+        const std::vector<uint32_t>& pointer = module.type(variable[1]);
+        uint32_t typeId = pointer[3];
+        const Decorations& decorations = module.decorationsOf(id);
+
+        if (storageClass == SpirV::PushConstant) {
+            pushConstantSize = std::max(pushConstantSize, module.sizeOf(typeId));
+            continue;
+        }
+
+        if (storageClass == SpirV::Input) {
+            if (!(module.stages & VK_SHADER_STAGE_VERTEX_BIT) || decorations.has(SpirV::BuiltIn) || !decorations.has(SpirV::Location)) {
+                continue;
+            }
+            const std::vector<uint32_t>* type = &module.type(typeId);
+            uint32_t columns = 1;
+            if ((*type)[0] == SpirV::OpTypeMatrix) {
+                columns = (*type)[3];
+                type = &module.type((*type)[2]);
+            }
+            uint32_t components = 1;
+            const std::vector<uint32_t>* scalar = type;
+            if ((*type)[0] == SpirV::OpTypeVector) {
+                components = (*type)[3];
+                scalar = &module.type((*type)[2]);
+            }
+            VkFormat format = vertexFormat(*scalar, components);
+            if (format == VK_FORMAT_UNDEFINED) {
+                WYVERN_THROW("SPIR-V reflection: unsupported vertex input type at location " + std::to_string(decorations.get(SpirV::Location)));
+            }
+            for (uint32_t column = 0; column < columns; column++) {
+                reflection.vertexInputs.push_back({ decorations.get(SpirV::Location) + column, format, 4 * components });
+            }
+            continue;
+        }
+
+        if (storageClass != SpirV::UniformConstant && storageClass != SpirV::Uniform && storageClass != SpirV::StorageBuffer) {
+            continue;
+        }
+        if (!decorations.has(SpirV::Binding)) {
+            continue;
+        }
+
+        DescriptorBinding binding;
+        binding.set = decorations.get(SpirV::DescriptorSet);
+        binding.binding = decorations.get(SpirV::Binding);
+        binding.stages = module.stages;
+        binding.name = module.nameOf(id);
+
+        // Unwrap arrays of resources
+        const std::vector<uint32_t>* type = &module.type(typeId);
+        if ((*type)[0] == SpirV::OpTypeArray) {
+            binding.count = module.constants.at((*type)[3]);
+            type = &module.type((*type)[2]);
+        }
+        else if ((*type)[0] == SpirV::OpTypeRuntimeArray) {
+            binding.count = 0;
+            type = &module.type((*type)[2]);
+        }
+
+        const Decorations& typeDecorations = module.decorationsOf((*type)[1]);
+        if (binding.name.empty()) {
+            binding.name = module.nameOf((*type)[1]); // A block without an instance name only names its type
+        }
+        switch ((*type)[0]) {
+        case SpirV::OpTypeStruct:
+            if (storageClass == SpirV::StorageBuffer || typeDecorations.has(SpirV::BufferBlock)) {
+                binding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+            else {
+                binding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            }
+            break;
+        case SpirV::OpTypeSampledImage:
+            binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+        case SpirV::OpTypeSampler:
+            binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+        case SpirV::OpTypeImage: {
+            uint32_t dim = (*type)[3];
+            uint32_t sampled = (*type)[7]; // 1: sampled, 2: storage
+            if (dim == SpirV::DimSubpassData) {
+                binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            else if (dim == SpirV::DimBuffer) {
+                binding.type = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            else {
+                binding.type = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            break;
+        }
+        case SpirV::OpTypeAccelerationStructureKHR:
+            binding.type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            break;
+        default:
+            continue;
+        }
+        reflection.bindings.push_back(binding);
+    }
+
+    if (pushConstantSize > 0) {
+        reflection.pushConstants.push_back({ module.stages, 0, pushConstantSize });
+    }
+
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const VertexInput& a, const VertexInput& b) {
+        return a.location < b.location;
+    });
+    return reflection;
+}
+
+std::shared_ptr<const WYVKShaderReflection::Reflection> WYVKShaderReflection::reflect(uint64_t shaderKey, const std::vector<uint32_t>& spirv)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_cacheMutex);
+        auto it = s_cache.find(shaderKey);
+        if (it != s_cache.end()) {
+            return it->second;
+        }
+    }
+
+    auto reflection = std::make_shared<const Reflection>(parse(spirv));
+    std::lock_guard<std::mutex> lock(s_cacheMutex);
+    return s_cache.emplace(shaderKey, std::move(reflection)).first->second;
+}
+
+void WYVKShaderReflection::Reflection::merge(const Reflection& other)
+{
+    stages |= other.stages;
+
+    for (const DescriptorBinding& binding : other.bindings) {
+        auto existing = std::find_if(bindings.begin(), bindings.end(), [&](const DescriptorBinding& b) {
+            return b.set == binding.set && b.binding == binding.binding;
+        });
+        if (existing == bindings.end()) {
+            bindings.push_back(binding);
+            continue;
+        }
+        if (existing->type != binding.type || existing->count != binding.count) {
+            WYVERN_THROW("SPIR-V reflection: stages disagree on the type of set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) +
+                " (" + binding.name + ")");
+        }
+        existing->stages |= binding.stages;
+        if (existing->name.empty()) {
+            existing->name = binding.name;
+        }
+    }
+    std::sort(bindings.begin(), bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+
+    // Push constant blocks of different stages overlap at offset 0, so one range covering the largest block is shared by all of them
+    for (const VkPushConstantRange& range : other.pushConstants) {
+        if (pushConstants.empty()) {
+            pushConstants.push_back(range);
+            continue;
+        }
+        pushConstants[0].stageFlags |= range.stageFlags;
+        pushConstants[0].size = std::max(pushConstants[0].size, range.offset + range.size);
+    }
+
+    if (vertexInputs.empty()) {
+        vertexInputs = other.vertexInputs;
+    }
+}
+
+void WYVKShaderReflection::Reflection::makeDynamic(uint32_t set, uint32_t binding)
+{
+    for (DescriptorBinding& b : bindings) {
+        if (b.set != set || b.binding != binding) {
+            continue;
+        }
+        if (b.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+            b.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        }
+        else if (b.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            b.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        }
+    }
+}
+
+uint32_t WYVKShaderReflection::Reflection::getSetCount() const
+{
+    return bindings.empty() ? 0 : bindings.back().set + 1;
+}
+
+std::vector<VkDescriptorPoolSize> WYVKShaderReflection::Reflection::getPoolSizes(uint32_t setCount, uint32_t runtimeArraySize) const
+{
+    std::map<VkDescriptorType, uint32_t> counts;
+    for (const DescriptorBinding& binding : bindings) {
+        counts[binding.type] += (binding.count == 0 ? runtimeArraySize : binding.count) * setCount;
+    }
+
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (const auto& count : counts) {
+        sizes.push_back({ count.first, count.second });
+    }
+    return sizes;
+}
+
+void WYVKShaderReflection::deriveVertexInput(const Reflection& reflection, uint32_t firstInstanceLocation,
+    std::vector<VkVertexInputBindingDescription>& outBindings, std::vector<VkVertexInputAttributeDescription>& outAttributes)
+{
+    outBindings.clear();
+    outAttributes.clear();
+
+    uint32_t strides[2] = { 0, 0 };
+    for (const VertexInput& input : reflection.vertexInputs) {
+        uint32_t binding = input.location < firstInstanceLocation ? 0 : 1;
+        outAttributes.push_back({ input.location, binding, input.format, strides[binding] });
+        strides[binding] += input.size;
+    }
+
+    for (uint32_t binding = 0; binding < 2; binding++) {
+        if (strides[binding] > 0) {
+            outBindings.push_back({ binding, strides[binding], binding == 0 ? VK_VERTEX_INPUT_RATE_VERTEX : VK_VERTEX_INPUT_RATE_INSTANCE });
+        }
+    }
+}
+
+}
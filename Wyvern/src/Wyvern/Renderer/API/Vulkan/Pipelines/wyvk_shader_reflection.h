@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Wyvern/Core.h"
+
+namespace Wyvern {
+
+/*
+* Minimal SPIR-V reflection. Walks the instruction stream of a compiled shader and pulls out everything the host side otherwise
+* has to keep in sync with the GLSL by hand: descriptor bindings, push constant ranges and vertex shader inputs.
+*
+* Reflections are cached by the shader's cache key (see WYVKShaderCache::computeKey()), so reflecting the same shader
+* for several pipelines or after a hot reload that did not change it costs a map lookup.
+*/
+class WYVKShaderReflection
+{
+public:
+	struct DescriptorBinding {
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uint32_t count = 1;				// Array size. 0 for runtime sized arrays
+		VkShaderStageFlags stages = 0;
+		std::string name;				// Variable name, or the block name for a block without an instance name. Empty if stripped
+	};
+
+	// One attribute location. Matrix inputs are split into one location per column
+	struct VertexInput {
+		uint32_t location = 0;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t size = 0;				// Size of `format` in bytes
+	};
+
+	/*
+	* Reflection of one shader, or of every stage of a pipeline after merge()
+	*/
+	struct Reflection {
+		VkShaderStageFlags stages = 0;
+		std::vector<DescriptorBinding> bindings;		// Sorted by set, then binding
+		std::vector<VkPushConstantRange> pushConstants;
+		std::vector<VertexInput> vertexInputs;		// Vertex stage only, sorted by location
+
+		/*
+		* Adds the bindings & push constants of `other`. Bindings used by several stages get the union of their stage flags.
+		* Throws if both declare the same binding with different types
+		*/
+		void merge(const Reflection& other);
+
+		/*
+		* SPIR-V cannot tell a dynamic uniform/storage buffer from a regular one. Turns the given binding into its dynamic variant
+		*/
+		void makeDynamic(uint32_t set, uint32_t binding);
+
+		// Number of descriptor sets, i.e. highest set index + 1
+		uint32_t getSetCount() const;
+
+		/*
+		* Pool sizes for `setCount` copies of every descriptor set. Runtime sized arrays count as `runtimeArraySize` descriptors
+		*/
+		std::vector<VkDescriptorPoolSize> getPoolSizes(uint32_t setCount, uint32_t runtimeArraySize = 1) const;
+	};
+
+	/*
+	* Returns the reflection of `spirv`. `shaderKey` identifies the binary (its SPIR-V cache key), results are cached by it. Thread safe
+	*/
+	static std::shared_ptr<const Reflection> reflect(uint64_t shaderKey, const std::vector<uint32_t>& spirv);
+
+	/*
+	* Builds a vertex input state from the vertex shader's inputs. Locations below `firstInstanceLocation` go to binding 0 and advance
+	* per vertex, the others go to binding 1 and advance per instance. Attributes are tightly packed in location order, which matches
+	* plain structs of glm types like Vertex and InstanceData
+	*/
+	static void deriveVertexInput(const Reflection& reflection, uint32_t firstInstanceLocation,
+		std::vector<VkVertexInputBindingDescription>& outBindings, std::vector<VkVertexInputAttributeDescription>& outAttributes);
+
+private:
+	static Reflection parse(const std::vector<uint32_t>& spirv);
+
+	static std::unordered_map<uint64_t, std::shared_ptr<const Reflection>> s_cache;
+	static std::mutex s_cacheMutex;
+};
+
+}
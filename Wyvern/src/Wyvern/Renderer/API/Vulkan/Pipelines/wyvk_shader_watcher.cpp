@@ -0,0 +1,90 @@
+#include "wyvk_shader_watcher.h"
+
+namespace Wyvern {
+
+WYVKShaderWatcher::WYVKShaderWatcher(const std::filesystem::path& directory, std::chrono::milliseconds pollInterval)
+    : m_directory(std::filesystem::absolute(directory).lexically_normal()),
+    m_pollInterval(pollInterval)
+{
+    // Record the current write times so the files that exist at startup are not reported as changed
+    std::set<std::filesystem::path> ignored;
+    poll(ignored);
+
+    m_thread = std::thread(&WYVKShaderWatcher::watchLoop, this);
+    WYVERN_LOG_INFO("Watching {} for shader changes", m_directory.string());
+}
+
+WYVKShaderWatcher::~WYVKShaderWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+std::vector<std::filesystem::path> WYVKShaderWatcher::takeChangedFiles()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::filesystem::path> changed(m_changedFiles.begin(), m_changedFiles.end());
+    m_changedFiles.clear();
+    return changed;
+}
+
+void WYVKShaderWatcher::watchLoop()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_condition.wait_for(lock, m_pollInterval, [this]() { return m_stopping; })) {
+                return;
+            }
+        }
+
+        std::set<std::filesystem::path> changed;
+        poll(changed);
+        if (!changed.empty()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_changedFiles.insert(changed.begin(), changed.end());
+        }
+    }
+}
+
+void WYVKShaderWatcher::poll(std::set<std::filesystem::path>& changed)
+{
+    // Editors often save by writing a new file and renaming it, so every lookup has to tolerate files vanishing mid poll
+    std::error_code error;
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+    for (std::filesystem::recursive_directory_iterator it(m_directory, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error)) {
+            continue;
+        }
+        std::filesystem::file_time_type writeTime = it->last_write_time(error);
+        if (error) {
+            error.clear();
+            continue;
+        }
+
+        std::filesystem::path path = it->path().lexically_normal();
+        auto previous = m_writeTimes.find(path.string());
+        if (previous == m_writeTimes.end() || previous->second != writeTime) {
+            changed.insert(path);
+        }
+        writeTimes[path.string()] = writeTime;
+    }
+
+    if (error) {
+        return; // Keep the old write times, a partial listing would look like deleted files
+    }
+
+    // Deleted files matter too, a shader including one of them has to report the error
+    for (const auto& file : m_writeTimes) {
+        if (writeTimes.find(file.first) == writeTimes.end()) {
+            changed.insert(file.first);
+        }
+    }
+    m_writeTimes = std::move(writeTimes);
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Wyvern/Core.h"
+
+namespace Wyvern {
+
+/*
+* Watches a shader directory (recursively) on a background thread and collects the files that were modified, created or deleted.
+* The main thread picks them up with takeChangedFiles() whenever it suits it, so nothing ever blocks the frame loop.
+*
+* Changes are found by polling last_write_time, which works the same on every platform. The directory only holds a handful of files,
+* so a poll is a few stat calls.
+*/
+class WYVKShaderWatcher
+{
+public:
+	static constexpr std::chrono::milliseconds DEFAULT_POLL_INTERVAL{ 250 };
+
+	WYVKShaderWatcher(const std::filesystem::path& directory, std::chrono::milliseconds pollInterval = DEFAULT_POLL_INTERVAL);
+	~WYVKShaderWatcher();
+
+	/*
+	* Returns every file that changed since the last call (absolute, normalized paths) and clears the list. Thread safe
+	*/
+	std::vector<std::filesystem::path> takeChangedFiles();
+
+	inline const std::filesystem::path& getDirectory() const { return m_directory; }
+
+private:
+	void watchLoop();
+
+	/*
+	* Stats every file in the directory and adds the ones whose write time differs from the last poll to `changed`
+	*/
+	void poll(std::set<std::filesystem::path>& changed);
+
+	std::filesystem::path m_directory;
+	std::chrono::milliseconds m_pollInterval;
+	std::unordered_map<std::string, std::filesystem::file_time_type> m_writeTimes; // Only touched by the watch thread
+
+	std::set<std::filesystem::path> m_changedFiles;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stopping = false;
+	std::thread m_thread;
+};
+
+}
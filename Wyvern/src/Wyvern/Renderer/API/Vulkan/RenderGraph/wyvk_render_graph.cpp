@@ -0,0 +1,827 @@
+#include "wyvk_render_graph.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "Wyvern/hash.h"
+
+namespace Wyvern {
+
+static constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+// Fill colors of the DOT export, one per aliased memory allocation
+static const std::array<const char*, 6> DOT_MEMORY_COLORS = { "#fdd0a2", "#c7e9c0", "#dadaeb", "#fcbba1", "#c6dbef", "#f0f0f0" };
+
+WYVKRenderGraph::PassBuilder::PassBuilder(WYVKRenderGraph& graph, Pass& pass)
+    : m_graph(graph),
+    m_pass(pass)
+{
+}
+
+void WYVKRenderGraph::PassBuilder::read(ResourceId resource, Access access)
+{
+    WYVERN_ASSERT((resource < m_graph.m_resources.size()), "Render graph pass reads an unknown resource");
+    m_pass.uses.push_back({ resource, access, false });
+}
+
+void WYVKRenderGraph::PassBuilder::write(ResourceId resource, Access access)
+{
+    WYVERN_ASSERT((resource < m_graph.m_resources.size()), "Render graph pass writes an unknown resource");
+    m_pass.uses.push_back({ resource, access, true });
+}
+
+WYVKRenderGraph::WYVKRenderGraph(WYVKDevice& device, bool dynamicRendering)
+    : m_dynamicRendering(dynamicRendering),
+    m_device(device)
+{
+}
+
+WYVKRenderGraph::~WYVKRenderGraph()
+{
+    if (m_compiled) {
+        destroy(*m_compiled);
+    }
+    for (auto& retired : m_retired) {
+        destroy(*retired.second);
+    }
+}
+
+void WYVKRenderGraph::reset(VkExtent2D extent)
+{
+    m_extent = extent;
+    m_resources.clear();
+    m_passes.clear();
+}
+
+WYVKRenderGraph::ResourceId WYVKRenderGraph::createImage(const std::string& name, const ImageDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_resources.push_back(resource);
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+WYVKRenderGraph::ResourceId WYVKRenderGraph::importImage(const std::string& name, const ImageDesc& desc, VkImage image, VkImageView view,
+    VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags initialStage)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = true;
+    resource.image = image;
+    resource.view = view;
+    resource.initialLayout = initialLayout;
+    resource.finalLayout = finalLayout;
+    resource.initialStage = initialStage;
+    m_resources.push_back(resource);
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+WYVKRenderGraph::PassId WYVKRenderGraph::addPass(const std::string& name, const SetupFunc& setup, ExecuteFunc execute)
+{
+    m_passes.emplace_back();
+    Pass& pass = m_passes.back();
+    pass.name = name;
+    pass.execute = std::move(execute);
+
+    PassBuilder builder(*this, pass);
+    setup(builder);
+    return static_cast<PassId>(m_passes.size() - 1);
+}
+
+bool WYVKRenderGraph::compile(uint64_t frameSerial)
+{
+    uint64_t hash = hashDeclarations();
+    if (m_compiled && m_compiled->hash == hash) {
+        return false;
+    }
+    if (m_compiled) {
+        m_retired.emplace_back(frameSerial, std::move(m_compiled));
+    }
+
+    auto compiled = std::make_unique<Compiled>();
+    compiled->hash = hash;
+
+    std::vector<bool> culled;
+    cullPasses(culled);
+    compiled->passOrder.assign(m_passes.size(), INVALID_ID);
+    for (PassId pass = 0; pass < m_passes.size(); pass++) {
+        if (!culled[pass]) {
+            compiled->passOrder[pass] = static_cast<uint32_t>(compiled->passes.size());
+            compiled->passes.emplace_back();
+            compiled->passes.back().pass = pass;
+        }
+    }
+
+    // Lifetimes in execution order. Transient images have to be written before anything can read them
+    std::vector<uint32_t> firstUse(m_resources.size(), INVALID_ID);
+    std::vector<uint32_t> lastUse(m_resources.size(), INVALID_ID);
+    std::vector<bool> written(m_resources.size(), false);
+    for (uint32_t order = 0; order < compiled->passes.size(); order++) {
+        const Pass& pass = m_passes[compiled->passes[order].pass];
+        for (const ResourceUse& use : pass.uses) {
+            const Resource& resource = m_resources[use.resource];
+            if (!use.write && !written[use.resource] && !resource.imported) {
+                WYVERN_LOG_ERROR("Render graph pass {} reads {} before any pass wrote it", pass.name, resource.name);
+                WYVERN_THROW("Render graph reads an image that was never written!");
+            }
+            written[use.resource] = written[use.resource] || use.write;
+            if (firstUse[use.resource] == INVALID_ID) {
+                firstUse[use.resource] = order;
+            }
+            lastUse[use.resource] = order;
+        }
+    }
+
+    std::vector<ResourceId> previousOccupants;
+    createTransientImages(*compiled, firstUse, lastUse, previousOccupants);
+    planBarriers(*compiled, lastUse, previousOccupants);
+    createRenderPasses(*compiled, firstUse, lastUse);
+
+    Statistics& statistics = compiled->statistics;
+    statistics.passCount = static_cast<uint32_t>(m_passes.size());
+    statistics.culledPassCount = static_cast<uint32_t>(m_passes.size() - compiled->passes.size());
+    statistics.compileCount = ++m_compileCount;
+    WYVERN_LOG_INFO("Render graph compiled: {} passes ({} culled) | {} barriers | {} transient images in {} allocations ({:.2f} MB instead of {:.2f} MB)",
+        statistics.passCount, statistics.culledPassCount, statistics.barrierCount, statistics.transientImageCount, statistics.memoryAllocationCount,
+        statistics.allocatedBytes / (1024.0 * 1024.0), statistics.transientBytes / (1024.0 * 1024.0));
+
+    m_compiled = std::move(compiled);
+    return true;
+}
+
+void WYVKRenderGraph::execute(VkCommandBuffer cmd)
+{
+    WYVERN_ASSERT((m_compiled && m_compiled->passOrder.size() == m_passes.size()), "Render graph executed without compiling the current declarations");
+
+    for (const CompiledPass& compiledPass : m_compiled->passes) {
+        recordBarriers(cmd, compiledPass.barriers);
+
+        Pass& pass = m_passes[compiledPass.pass];
+        if (compiledPass.attachments.empty()) {
+            if (pass.execute) {
+                pass.execute(cmd);
+            }
+            continue;
+        }
+
+        if (m_dynamicRendering) {
+            beginRendering(cmd, compiledPass, pass.secondaryCommandBuffers);
+            if (pass.execute) {
+                pass.execute(cmd);
+            }
+            vkCmdEndRendering(cmd);
+            continue;
+        }
+
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = compiledPass.renderPass;
+        renderPassInfo.framebuffer = getFramebuffer(compiledPass.pass);
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = compiledPass.extent;
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(compiledPass.clearValues.size());
+        renderPassInfo.pClearValues = compiledPass.clearValues.data();
+        vkCmdBeginRenderPass(cmd, &renderPassInfo, pass.secondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+        if (pass.execute) {
+            pass.execute(cmd);
+        }
+        vkCmdEndRenderPass(cmd);
+    }
+
+    recordBarriers(cmd, m_compiled->finalBarriers);
+}
+
+void WYVKRenderGraph::retire(uint64_t completedSerial)
+{
+    for (auto it = m_retired.begin(); it != m_retired.end();) {
+        if (it->first <= completedSerial) {
+            destroy(*it->second);
+            it = m_retired.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void WYVKRenderGraph::invalidate(uint64_t frameSerial)
+{
+    if (m_compiled) {
+        m_retired.emplace_back(frameSerial, std::move(m_compiled));
+    }
+}
+
+void WYVKRenderGraph::releaseFramebuffers(uint64_t frameSerial)
+{
+    if (!m_compiled || m_compiled->framebuffers.empty()) {
+        return;
+    }
+    // Retired like a graph that only owns the framebuffers
+    auto retired = std::make_unique<Compiled>();
+    retired->framebuffers = std::move(m_compiled->framebuffers);
+    m_compiled->framebuffers.clear();
+    m_retired.emplace_back(frameSerial, std::move(retired));
+}
+
+VkRenderPass WYVKRenderGraph::getRenderPass(PassId pass) const
+{
+    if (!m_compiled || pass >= m_compiled->passOrder.size() || m_compiled->passOrder[pass] == INVALID_ID) {
+        return VK_NULL_HANDLE;
+    }
+    return m_compiled->passes[m_compiled->passOrder[pass]].renderPass;
+}
+
+VkFramebuffer WYVKRenderGraph::getFramebuffer(PassId pass)
+{
+    if (getRenderPass(pass) == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+    const CompiledPass& compiledPass = m_compiled->passes[m_compiled->passOrder[pass]];
+
+    // Imported views change from frame to frame (one per swapchain image), so framebuffers are cached per set of views
+    std::vector<VkImageView> views;
+    uint64_t key = FNV_OFFSET_BASIS;
+    hashValue(key, pass);
+    for (ResourceId attachment : compiledPass.attachments) {
+        views.push_back(getImageView(attachment));
+        hashValue(key, views.back());
+    }
+
+    auto cached = m_compiled->framebuffers.find(key);
+    if (cached != m_compiled->framebuffers.end()) {
+        return cached->second;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = compiledPass.renderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    framebufferInfo.pAttachments = views.data();
+    framebufferInfo.width = compiledPass.extent.width;
+    framebufferInfo.height = compiledPass.extent.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VK_CALL(vkCreateFramebuffer(m_device.getLogicalDevice(), &framebufferInfo, nullptr, &framebuffer), "Failed to create render graph framebuffer!");
+    m_compiled->framebuffers.emplace(key, framebuffer);
+    return framebuffer;
+}
+
+bool WYVKRenderGraph::isCulled(PassId pass) const
+{
+    return !m_compiled || pass >= m_compiled->passOrder.size() || m_compiled->passOrder[pass] == INVALID_ID;
+}
+
+const WYVKRenderGraph::Statistics& WYVKRenderGraph::getStatistics() const
+{
+    static const Statistics empty;
+    return m_compiled ? m_compiled->statistics : empty;
+}
+
+std::string WYVKRenderGraph::exportDot() const
+{
+    std::ostringstream dot;
+    dot << "digraph RenderGraph {\n";
+    dot << "    rankdir=LR;\n";
+    dot << "    node [fontname=\"Helvetica\", fontsize=10];\n";
+    dot << "    edge [fontname=\"Helvetica\", fontsize=9];\n";
+
+    for (PassId pass = 0; pass < m_passes.size(); pass++) {
+        dot << "    pass" << pass << " [shape=box, label=\"" << m_passes[pass].name << "\"";
+        if (isCulled(pass)) {
+            dot << ", style=dashed, color=gray, fontcolor=gray";
+        }
+        else {
+            dot << ", style=filled, fillcolor=\"#9ecae1\"";
+        }
+        dot << "];\n";
+    }
+
+    for (ResourceId id = 0; id < m_resources.size(); id++) {
+        const Resource& resource = m_resources[id];
+        VkExtent2D extent = getExtent(id);
+        dot << "    image" << id << " [shape=ellipse, label=\"" << resource.name << "\\n" << extent.width << "x" << extent.height
+            << " | format " << resource.desc.format;
+        if (resource.imported) {
+            dot << "\\nimported\", style=bold";
+        }
+        else if (m_compiled && id < m_compiled->images.size() && m_compiled->images[id].memorySlot != INVALID_ID) {
+            uint32_t slot = m_compiled->images[id].memorySlot;
+            dot << "\\nmemory " << slot << "\", style=filled, fillcolor=\"" << DOT_MEMORY_COLORS[slot % DOT_MEMORY_COLORS.size()] << "\"";
+        }
+        else {
+            dot << "\\nunused\", color=gray, fontcolor=gray";
+        }
+        dot << "];\n";
+    }
+
+    for (PassId pass = 0; pass < m_passes.size(); pass++) {
+        for (const ResourceUse& use : m_passes[pass].uses) {
+            if (use.write) {
+                dot << "    pass" << pass << " -> image" << use.resource;
+            }
+            else {
+                dot << "    image" << use.resource << " -> pass" << pass;
+            }
+            dot << " [label=\"" << getAccessName(use.access) << "\"" << (isCulled(pass) ? ", style=dashed, color=gray" : "") << "];\n";
+        }
+    }
+
+    dot << "}\n";
+    return dot.str();
+}
+
+void WYVKRenderGraph::writeDot(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+    if (!file) {
+        WYVERN_LOG_WARN("Unable to write render graph to {}", path.string());
+        return;
+    }
+    file << exportDot();
+    WYVERN_LOG_INFO("Wrote render graph to {}", path.string());
+}
+
+const WYVKRenderGraph::AccessInfo& WYVKRenderGraph::getAccessInfo(Access access)
+{
+    static const std::array<AccessInfo, ACCESS_COUNT> infos = { {
+        { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true },
+        { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true },
+        { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true },
+        { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, false },
+        { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false },
+        { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT, false },
+    } };
+    return infos[static_cast<uint32_t>(access)];
+}
+
+const char* WYVKRenderGraph::getAccessName(Access access)
+{
+    static const std::array<const char*, ACCESS_COUNT> names = {
+        "COLOR_ATTACHMENT", "DEPTH_ATTACHMENT", "DEPTH_READ", "SHADER_READ", "TRANSFER_SRC", "TRANSFER_DST"
+    };
+    return names[static_cast<uint32_t>(access)];
+}
+
+uint64_t WYVKRenderGraph::hashDeclarations() const
+{
+    // Everything but the execute callbacks and the imported image handles, which are allowed to change every frame
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hashValue(hash, m_extent.width);
+    hashValue(hash, m_extent.height);
+    hashValue(hash, m_dynamicRendering);
+    for (const Resource& resource : m_resources) {
+        hashBytes(hash, resource.name.data(), resource.name.size());
+        hashValue(hash, resource.desc.format);
+        hashValue(hash, resource.desc.extent.width);
+        hashValue(hash, resource.desc.extent.height);
+        hashValue(hash, resource.desc.aspect);
+        hashValue(hash, resource.desc.clear);
+        hashValue(hash, resource.desc.clearValue.color.uint32); // Covers the depth/stencil values as well
+        hashValue(hash, resource.imported);
+        hashValue(hash, resource.initialLayout);
+        hashValue(hash, resource.finalLayout);
+        hashValue(hash, resource.initialStage);
+    }
+    for (const Pass& pass : m_passes) {
+        hashBytes(hash, pass.name.data(), pass.name.size());
+        hashValue(hash, pass.secondaryCommandBuffers);
+        hashValue(hash, pass.sideEffects);
+        for (const ResourceUse& use : pass.uses) {
+            hashValue(hash, use.resource);
+            hashValue(hash, use.access);
+            hashValue(hash, use.write);
+        }
+        hashValue(hash, pass.uses.size());
+    }
+    return hash;
+}
+
+void WYVKRenderGraph::cullPasses(std::vector<bool>& culled) const
+{
+    // Imported images are seen outside of the graph, so whatever ends up in them is needed. Walking the passes backwards,
+    // a pass is needed if it writes something that is needed, and then everything it reads is needed too
+    std::vector<bool> needed(m_resources.size(), false);
+    for (ResourceId id = 0; id < m_resources.size(); id++) {
+        needed[id] = m_resources[id].imported;
+    }
+
+    culled.assign(m_passes.size(), true);
+    for (size_t i = m_passes.size(); i-- > 0;) {
+        const Pass& pass = m_passes[i];
+        bool isNeeded = pass.sideEffects || std::any_of(pass.uses.begin(), pass.uses.end(), [&](const ResourceUse& use) { return use.write && needed[use.resource]; });
+        if (!isNeeded) {
+            continue;
+        }
+        culled[i] = false;
+        for (const ResourceUse& use : pass.uses) {
+            if (!use.write) {
+                needed[use.resource] = true;
+            }
+        }
+    }
+}
+
+void WYVKRenderGraph::createTransientImages(Compiled& compiled, const std::vector<uint32_t>& firstUse, const std::vector<uint32_t>& lastUse,
+    std::vector<ResourceId>& outPreviousOccupants)
+{
+    compiled.images.resize(m_resources.size());
+    outPreviousOccupants.assign(m_resources.size(), INVALID_ID);
+
+    std::vector<VkImageUsageFlags> usage(m_resources.size(), 0);
+    for (const CompiledPass& compiledPass : compiled.passes) {
+        for (const ResourceUse& use : m_passes[compiledPass.pass].uses) {
+            usage[use.resource] |= getAccessInfo(use.access).usage;
+        }
+    }
+
+    std::vector<ResourceId> transients;
+    for (ResourceId id = 0; id < m_resources.size(); id++) {
+        if (!m_resources[id].imported && firstUse[id] != INVALID_ID) {
+            transients.push_back(id);
+        }
+    }
+    std::sort(transients.begin(), transients.end(), [&](ResourceId a, ResourceId b) { return firstUse[a] < firstUse[b]; });
+
+    // Greedy interval packing: an image goes into the first memory slot whose images are all dead by the time it is first used
+    struct MemorySlot {
+        VkMemoryRequirements requirements;
+        uint32_t lastUse;
+        ResourceId firstOccupant;
+        ResourceId lastOccupant;
+    };
+    std::vector<MemorySlot> slots;
+
+    for (ResourceId id : transients) {
+        const Resource& resource = m_resources[id];
+        VkExtent2D extent = getExtent(id);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = resource.desc.format;
+        imageInfo.extent = { extent.width, extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = usage[id];
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VK_CALL(vkCreateImage(m_device.getLogicalDevice(), &imageInfo, nullptr, &compiled.images[id].image), "Failed to create render graph image!");
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(m_device.getLogicalDevice(), compiled.images[id].image, &requirements);
+        compiled.statistics.transientBytes += requirements.size;
+        compiled.statistics.transientImageCount++;
+
+        uint32_t slotIndex = INVALID_ID;
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            if (slots[i].lastUse < firstUse[id] && (slots[i].requirements.memoryTypeBits & requirements.memoryTypeBits) != 0) {
+                slotIndex = i;
+                break;
+            }
+        }
+
+        if (slotIndex == INVALID_ID) {
+            slots.push_back({ requirements, lastUse[id], id, id });
+            slotIndex = static_cast<uint32_t>(slots.size() - 1);
+        }
+        else {
+            MemorySlot& slot = slots[slotIndex];
+            slot.requirements.size = std::max(slot.requirements.size, requirements.size);
+            slot.requirements.alignment = std::max(slot.requirements.alignment, requirements.alignment);
+            slot.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+            outPreviousOccupants[id] = slot.lastOccupant;
+            slot.lastUse = lastUse[id];
+            slot.lastOccupant = id;
+        }
+        compiled.images[id].memorySlot = slotIndex;
+    }
+
+    for (const MemorySlot& slot : slots) {
+        // The first image of a slot follows the last one of the previous frame, which used the same memory
+        outPreviousOccupants[slot.firstOccupant] = slot.lastOccupant;
+
+        compiled.memory.push_back(m_device.getAllocator().allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, WYVKAllocator::ResourceKind::OPTIMAL));
+        compiled.statistics.allocatedBytes += slot.requirements.size;
+    }
+    compiled.statistics.memoryAllocationCount = static_cast<uint32_t>(slots.size());
+
+    for (ResourceId id : transients) {
+        TransientImage& image = compiled.images[id];
+        const WYVKAllocator::Allocation& allocation = compiled.memory[image.memorySlot];
+        VK_CALL(vkBindImageMemory(m_device.getLogicalDevice(), image.image, allocation.memory, allocation.offset), "Unable to bind render graph image memory!");
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = m_resources[id].desc.format;
+        viewInfo.subresourceRange.aspectMask = m_resources[id].desc.aspect;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        VK_CALL(vkCreateImageView(m_device.getLogicalDevice(), &viewInfo, nullptr, &image.view), "Failed to create render graph image view!");
+    }
+}
+
+void WYVKRenderGraph::planBarriers(Compiled& compiled, const std::vector<uint32_t>& lastUse, const std::vector<ResourceId>& previousOccupants)
+{
+    // What a pass does with one image. A pass may use an image more than once (e.g. depth test & sample it), as long as the layouts agree
+    struct MergedUse {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags access = 0;
+        bool write = false;
+    };
+    auto mergeUses = [&](const Pass& pass) {
+        std::vector<std::pair<ResourceId, MergedUse>> merged;
+        for (const ResourceUse& use : pass.uses) {
+            const AccessInfo& info = getAccessInfo(use.access);
+            auto it = std::find_if(merged.begin(), merged.end(), [&](const auto& entry) { return entry.first == use.resource; });
+            if (it == merged.end()) {
+                merged.push_back({ use.resource, { info.layout, 0, 0, false } });
+                it = merged.end() - 1;
+            }
+            else if (it->second.layout != info.layout) {
+                WYVERN_LOG_ERROR("Render graph pass {} uses {} in two different layouts", pass.name, m_resources[use.resource].name);
+                WYVERN_THROW("Render graph pass uses an image in two different layouts!");
+            }
+            it->second.stages |= info.stages;
+            it->second.access |= use.write ? info.access : (info.access & ~WRITE_ACCESS_MASK);
+            it->second.write = it->second.write || use.write;
+        }
+        return merged;
+    };
+
+    // Where every image is at while walking the passes
+    struct State {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStages = 0;	// Stages of the last write or layout transition
+        VkAccessFlags writeAccess = 0;
+        VkPipelineStageFlags readStages = 0;	// Stages that read since then
+        VkPipelineStageFlags syncedStages = 0;	// Stages that already wait on the last write
+    };
+    std::vector<State> states(m_resources.size());
+
+    std::vector<std::vector<std::pair<ResourceId, MergedUse>>> passUses;
+    for (const CompiledPass& compiledPass : compiled.passes) {
+        passUses.push_back(mergeUses(m_passes[compiledPass.pass]));
+    }
+
+    for (ResourceId id = 0; id < m_resources.size(); id++) {
+        const Resource& resource = m_resources[id];
+        if (resource.imported) {
+            states[id].layout = resource.initialLayout;
+            states[id].writeStages = resource.initialStage;
+        }
+        else if (previousOccupants[id] != INVALID_ID) {
+            // Memory shared with another image. Its contents are gone, but the previous image has to be done with the memory first
+            ResourceId previous = previousOccupants[id];
+            for (const auto& use : passUses[lastUse[previous]]) {
+                if (use.first == previous) {
+                    states[id].writeStages = use.second.stages;
+                    states[id].writeAccess = use.second.access & WRITE_ACCESS_MASK;
+                }
+            }
+        }
+    }
+
+    auto addBarrier = [&](BarrierBatch& batch, ResourceId resource, VkImageLayout oldLayout, VkImageLayout newLayout,
+        VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) {
+        batch.srcStages |= srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        batch.dstStages |= dstStages;
+        batch.barriers.push_back({ resource, oldLayout, newLayout, srcAccess, dstAccess });
+        compiled.statistics.barrierCount++;
+    };
+
+    for (uint32_t order = 0; order < compiled.passes.size(); order++) {
+        BarrierBatch& batch = compiled.passes[order].barriers;
+        for (const auto& entry : passUses[order]) {
+            ResourceId id = entry.first;
+            const MergedUse& use = entry.second;
+            State& state = states[id];
+
+            // Read after read or after a write the stage already waits on
+            if (!use.write && state.layout == use.layout) {
+                VkPipelineStageFlags missing = use.stages & ~state.syncedStages;
+                if (missing != 0 && state.writeStages != 0) {
+                    addBarrier(batch, id, state.layout, state.layout, state.writeStages, state.writeAccess, missing, use.access);
+                    state.syncedStages |= missing;
+                }
+                state.readStages |= use.stages;
+                continue;
+            }
+
+            // Writes & layout transitions wait on everything that touched the image before
+            addBarrier(batch, id, state.layout, use.layout, state.writeStages | state.readStages, state.writeAccess, use.stages, use.access);
+            state.layout = use.layout;
+            state.writeStages = use.stages;
+            state.writeAccess = use.write ? (use.access & WRITE_ACCESS_MASK) : 0;
+            state.readStages = use.write ? 0 : use.stages;
+            state.syncedStages = use.stages;
+        }
+    }
+
+    for (ResourceId id = 0; id < m_resources.size(); id++) {
+        const Resource& resource = m_resources[id];
+        const State& state = states[id];
+        if (resource.imported && resource.finalLayout != state.layout) {
+            addBarrier(compiled.finalBarriers, id, state.layout, resource.finalLayout, state.writeStages | state.readStages, state.writeAccess,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+        }
+    }
+}
+
+void WYVKRenderGraph::createRenderPasses(Compiled& compiled, const std::vector<uint32_t>& firstUse, const std::vector<uint32_t>& lastUse)
+{
+    for (uint32_t order = 0; order < compiled.passes.size(); order++) {
+        CompiledPass& compiledPass = compiled.passes[order];
+        const Pass& pass = m_passes[compiledPass.pass];
+
+        std::vector<const ResourceUse*> colors;
+        const ResourceUse* depth = nullptr;
+        for (const ResourceUse& use : pass.uses) {
+            const AccessInfo& info = getAccessInfo(use.access);
+            if (!info.attachment) {
+                continue;
+            }
+            if (info.usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+                WYVERN_ASSERT((depth == nullptr), "Render graph pass has more than one depth attachment");
+                depth = &use;
+            }
+            else {
+                colors.push_back(&use);
+            }
+        }
+        if (colors.empty() && depth == nullptr) {
+            continue;
+        }
+
+        std::vector<const ResourceUse*> attachmentUses = colors;
+        if (depth) {
+            attachmentUses.push_back(depth);
+        }
+
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkAttachmentReference> references;
+        for (const ResourceUse* use : attachmentUses) {
+            const Resource& resource = m_resources[use->resource];
+            const AccessInfo& info = getAccessInfo(use->access);
+
+            // Contents only have to be loaded if something wrote them before, and stored if something reads them after
+            VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            if (firstUse[use->resource] == order && !(resource.imported && resource.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED)) {
+                loadOp = use->write && resource.desc.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            }
+            VkAttachmentStoreOp storeOp = resource.imported || lastUse[use->resource] > order ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            bool hasStencil = (resource.desc.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+
+            VkAttachmentDescription attachment{};
+            attachment.format = resource.desc.format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = loadOp;
+            attachment.storeOp = storeOp;
+            attachment.stencilLoadOp = hasStencil ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = hasStencil ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            // The graph's barriers already put the image in this layout, the render pass never transitions anything
+            attachment.initialLayout = info.layout;
+            attachment.finalLayout = info.layout;
+            attachments.push_back(attachment);
+            references.push_back({ static_cast<uint32_t>(references.size()), info.layout });
+
+            compiledPass.attachments.push_back(use->resource);
+            compiledPass.clearValues.push_back(resource.desc.clearValue);
+        }
+        compiledPass.attachmentDescriptions = attachments;
+        compiledPass.colorAttachmentCount = static_cast<uint32_t>(colors.size());
+
+        compiledPass.extent = getExtent(compiledPass.attachments[0]);
+        for (ResourceId attachment : compiledPass.attachments) {
+            VkExtent2D extent = getExtent(attachment);
+            if (extent.width != compiledPass.extent.width || extent.height != compiledPass.extent.height) {
+                WYVERN_LOG_ERROR("Render graph pass {} has attachments of different sizes", pass.name);
+                WYVERN_THROW("Render graph pass has attachments of different sizes!");
+            }
+        }
+
+        // Dynamic rendering only needs the attachment descriptions, see beginRendering()
+        if (m_dynamicRendering) {
+            continue;
+        }
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(colors.size());
+        subpass.pColorAttachments = colors.empty() ? nullptr : references.data();
+        subpass.pDepthStencilAttachment = depth ? &references.back() : nullptr;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        VK_CALL(vkCreateRenderPass(m_device.getLogicalDevice(), &renderPassInfo, nullptr, &compiledPass.renderPass), "Failed to create render graph render pass!");
+    }
+}
+
+void WYVKRenderGraph::recordBarriers(VkCommandBuffer cmd, const BarrierBatch& batch)
+{
+    if (batch.barriers.empty()) {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    barriers.reserve(batch.barriers.size());
+    for (const ImageBarrier& barrier : batch.barriers) {
+        VkImageMemoryBarrier imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = barrier.srcAccess;
+        imageBarrier.dstAccessMask = barrier.dstAccess;
+        imageBarrier.oldLayout = barrier.oldLayout;
+        imageBarrier.newLayout = barrier.newLayout;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = getImage(barrier.resource);
+        imageBarrier.subresourceRange.aspectMask = m_resources[barrier.resource].desc.aspect;
+        imageBarrier.subresourceRange.levelCount = 1;
+        imageBarrier.subresourceRange.layerCount = 1;
+        barriers.push_back(imageBarrier);
+    }
+    vkCmdPipelineBarrier(cmd, batch.srcStages, batch.dstStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void WYVKRenderGraph::beginRendering(VkCommandBuffer cmd, const CompiledPass& compiledPass, bool secondaryCommandBuffers)
+{
+    std::vector<VkRenderingAttachmentInfo> attachments(compiledPass.attachments.size());
+    for (size_t i = 0; i < attachments.size(); i++) {
+        const VkAttachmentDescription& description = compiledPass.attachmentDescriptions[i];
+        attachments[i].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        attachments[i].imageView = getImageView(compiledPass.attachments[i]);
+        attachments[i].imageLayout = description.initialLayout;
+        attachments[i].loadOp = description.loadOp;
+        attachments[i].storeOp = description.storeOp;
+        attachments[i].clearValue = compiledPass.clearValues[i];
+    }
+
+    VkRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.flags = secondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = compiledPass.extent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = compiledPass.colorAttachmentCount;
+    renderingInfo.pColorAttachments = attachments.data();
+    if (compiledPass.colorAttachmentCount < attachments.size()) {
+        const VkRenderingAttachmentInfo& depth = attachments.back();
+        renderingInfo.pDepthAttachment = &depth;
+        if (m_resources[compiledPass.attachments.back()].desc.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) {
+            renderingInfo.pStencilAttachment = &depth;
+        }
+    }
+    vkCmdBeginRendering(cmd, &renderingInfo);
+}
+
+VkImage WYVKRenderGraph::getImage(ResourceId resource) const
+{
+    return m_resources[resource].imported ? m_resources[resource].image : m_compiled->images[resource].image;
+}
+
+VkImageView WYVKRenderGraph::getImageView(ResourceId resource) const
+{
+    return m_resources[resource].imported ? m_resources[resource].view : m_compiled->images[resource].view;
+}
+
+VkExtent2D WYVKRenderGraph::getExtent(ResourceId resource) const
+{
+    const ImageDesc& desc = m_resources[resource].desc;
+    return desc.extent.width == 0 || desc.extent.height == 0 ? m_extent : desc.extent;
+}
+
+void WYVKRenderGraph::destroy(Compiled& compiled)
+{
+    VkDevice device = m_device.getLogicalDevice();
+    for (auto& framebuffer : compiled.framebuffers) {
+        vkDestroyFramebuffer(device, framebuffer.second, nullptr);
+    }
+    for (CompiledPass& compiledPass : compiled.passes) {
+        vkDestroyRenderPass(device, compiledPass.renderPass, nullptr);
+    }
+    for (TransientImage& image : compiled.images) {
+        vkDestroyImageView(device, image.view, nullptr);
+        vkDestroyImage(device, image.image, nullptr);
+    }
+    for (WYVKAllocator::Allocation& allocation : compiled.memory) {
+        m_device.getAllocator().free(allocation);
+    }
+    compiled = Compiled();
+}
+
+}
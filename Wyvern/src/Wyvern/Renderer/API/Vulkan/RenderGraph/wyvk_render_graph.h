@@ -0,0 +1,273 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "../Memory/wyvk_allocator.h"
+
+namespace Wyvern {
+
+/*
+* Frame render graph. Passes declare which named images they read and write, the graph works out the rest:
+*
+*   - Passes run in declaration order. Passes whose results never reach an imported image (or a pass with side effects) are culled
+*   - Pipeline barriers & layout transitions are derived from the declared accesses. Read after read in the same layout needs none,
+*     every other hazard gets one barrier batch in front of the pass that needs it
+*   - Transient images (createImage()) are owned by the graph. Images whose lifetimes don't overlap share memory, the first user
+*     of shared memory waits on the last user before it
+*   - Passes with attachments get a VkRenderPass & framebuffer built from their declarations. They have no subpass dependencies,
+*     all synchronization is done by the graph's barriers. With dynamic rendering they are begun with vkCmdBeginRendering instead
+*     and have neither
+*
+* The graph is declared again every frame (reset(), createImage()/importImage(), addPass(), compile()). compile() hashes the
+* declarations and reuses the compiled graph while they stay the same, so only the execute callbacks and imported images are swapped.
+*
+*     graph.reset(extent);
+*     ResourceId backbuffer = graph.importImage("Backbuffer", desc, image, view, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+*     ResourceId depth = graph.createImage("Depth", depthDesc);
+*     graph.addPass("Scene", [&](PassBuilder& pass) {
+*         pass.write(backbuffer, Access::COLOR_ATTACHMENT);
+*         pass.write(depth, Access::DEPTH_ATTACHMENT);
+*     }, [&](VkCommandBuffer cmd) { ... });
+*     graph.compile(frameSerial);
+*     graph.execute(cmd);
+*/
+class WYVKRenderGraph
+{
+public:
+	using ResourceId = uint32_t;
+	using PassId = uint32_t;
+	static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+	// How a pass uses an image. Decides its layout and the stages & access masks of the barriers around it
+	enum class Access : uint32_t {
+		COLOR_ATTACHMENT = 0,	// Color attachment output
+		DEPTH_ATTACHMENT,		// Depth tested & written
+		DEPTH_READ,				// Depth tested but read only, e.g. after a depth prepass
+		SHADER_READ,			// Sampled by fragment shaders
+		TRANSFER_SRC,
+		TRANSFER_DST,
+	};
+	static constexpr uint32_t ACCESS_COUNT = 6;
+
+	struct ImageDesc {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkExtent2D extent = { 0, 0 };						// { 0, 0 } uses the extent passed to reset()
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		bool clear = true;									// Cleared by the first pass that writes it. Otherwise its first contents are undefined
+		VkClearValue clearValue{};
+	};
+
+	struct Statistics {
+		uint32_t passCount = 0;
+		uint32_t culledPassCount = 0;
+		uint32_t barrierCount = 0;				// Image barriers recorded per execute()
+		uint32_t transientImageCount = 0;
+		uint32_t memoryAllocationCount = 0;		// Allocations backing the transient images after aliasing
+		VkDeviceSize transientBytes = 0;		// What the transient images would need without aliasing
+		VkDeviceSize allocatedBytes = 0;
+		uint64_t compileCount = 0;				// Times the graph was actually rebuilt
+	};
+
+private:
+	struct ResourceUse {
+		ResourceId resource;
+		Access access;
+		bool write;
+	};
+
+	struct Pass {
+		std::string name;
+		std::vector<ResourceUse> uses;
+		std::function<void(VkCommandBuffer)> execute;
+		bool secondaryCommandBuffers = false;
+		bool sideEffects = false;
+	};
+
+public:
+	/*
+	* Handed to the setup callback of addPass() to declare what the pass does
+	*/
+	class PassBuilder
+	{
+	public:
+		void read(ResourceId resource, Access access);
+		void write(ResourceId resource, Access access);
+
+		// The pass only executes secondary command buffers (VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		inline void useSecondaryCommandBuffers() { m_pass.secondaryCommandBuffers = true; }
+		// Never culled, even if nothing reads what it writes
+		inline void setSideEffects() { m_pass.sideEffects = true; }
+
+	private:
+		friend class WYVKRenderGraph;
+		PassBuilder(WYVKRenderGraph& graph, Pass& pass);
+
+		WYVKRenderGraph& m_graph;
+		Pass& m_pass;
+	};
+
+	using SetupFunc = std::function<void(PassBuilder& pass)>;
+	using ExecuteFunc = std::function<void(VkCommandBuffer cmd)>;
+
+	WYVKRenderGraph(WYVKDevice& device, bool dynamicRendering = false);
+	~WYVKRenderGraph();
+
+	/*
+	* Starts a new set of declarations. The compiled graph is kept until compile() sees declarations that differ from it
+	*/
+	void reset(VkExtent2D extent);
+
+	/*
+	* Image owned by the graph that only lives within the frame. Its memory may be shared with other transient images
+	*/
+	ResourceId createImage(const std::string& name, const ImageDesc& desc);
+
+	/*
+	* Image owned by someone else (e.g. a swapchain image). It is in `initialLayout` when the graph starts, after being used up to
+	* `initialStage`, and is left in `finalLayout`. The image & view may change every frame without the graph being rebuilt
+	*/
+	ResourceId importImage(const std::string& name, const ImageDesc& desc, VkImage image, VkImageView view, VkImageLayout initialLayout,
+		VkImageLayout finalLayout, VkPipelineStageFlags initialStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+	PassId addPass(const std::string& name, const SetupFunc& setup, ExecuteFunc execute);
+
+	/*
+	* Culls the passes, plans the barriers and creates & aliases the transient images. Returns false if the last compiled graph
+	* was reused. A replaced graph is destroyed by retire() once `frameSerial` is done on the GPU
+	*/
+	bool compile(uint64_t frameSerial);
+
+	/*
+	* Records every pass that was not culled, with its barriers & render pass, into `cmd`
+	*/
+	void execute(VkCommandBuffer cmd);
+
+	/*
+	* Destroys the graphs replaced up to `completedSerial`
+	*/
+	void retire(uint64_t completedSerial);
+
+	/*
+	* Drops the compiled graph so the next compile() rebuilds it, e.g. when imported images are destroyed
+	*/
+	void invalidate(uint64_t frameSerial);
+
+	/*
+	* Drops the cached framebuffers but keeps the compiled graph, e.g. when imported image views are destroyed but their extent stays the same.
+	* They are destroyed by retire() once `frameSerial` is done on the GPU
+	*/
+	void releaseFramebuffers(uint64_t frameSerial);
+
+	/*
+	* Render pass & framebuffer of a pass with attachments. The framebuffer is built for the images imported this frame.
+	* Both are VK_NULL_HANDLE for passes without attachments, passes that were culled and with dynamic rendering
+	*/
+	VkRenderPass getRenderPass(PassId pass) const;
+	VkFramebuffer getFramebuffer(PassId pass);
+
+	bool isCulled(PassId pass) const;
+	inline bool isDynamicRendering() const { return m_dynamicRendering; }
+	const Statistics& getStatistics() const;
+
+	/*
+	* Graphviz description of the declared graph. Passes are boxes (dashed if culled), images are ellipses colored by the memory
+	* they alias into. Edges are labeled with the access
+	*/
+	std::string exportDot() const;
+	void writeDot(const std::filesystem::path& path) const;
+
+private:
+	struct Resource {
+		std::string name;
+		ImageDesc desc;
+		bool imported = false;
+		VkImage image = VK_NULL_HANDLE;			// Imported images only
+		VkImageView view = VK_NULL_HANDLE;
+		VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags initialStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	};
+
+	struct ImageBarrier {
+		ResourceId resource;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+		VkAccessFlags srcAccess;
+		VkAccessFlags dstAccess;
+	};
+
+	struct BarrierBatch {
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		std::vector<ImageBarrier> barriers;
+	};
+
+	struct CompiledPass {
+		PassId pass;
+		BarrierBatch barriers;						// Recorded before the pass
+		VkRenderPass renderPass = VK_NULL_HANDLE;	// Only for passes with attachments, without dynamic rendering
+		std::vector<ResourceId> attachments;		// Color attachments first, depth last
+		std::vector<VkAttachmentDescription> attachmentDescriptions; // Load/store ops & layouts per attachment
+		uint32_t colorAttachmentCount = 0;
+		std::vector<VkClearValue> clearValues;
+		VkExtent2D extent = { 0, 0 };
+	};
+
+	struct TransientImage {
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		uint32_t memorySlot = INVALID_ID;			// Index into Compiled::memory. Images sharing a slot alias
+	};
+
+	struct Compiled {
+		uint64_t hash = 0;
+		std::vector<CompiledPass> passes;			// Execution order, culled passes left out
+		std::vector<uint32_t> passOrder;			// Index into `passes` per declared pass, INVALID_ID if culled
+		BarrierBatch finalBarriers;					// Moves imported images into their final layout
+		std::vector<TransientImage> images;			// Per resource, empty for imported ones
+		std::vector<WYVKAllocator::Allocation> memory;
+		std::unordered_map<uint64_t, VkFramebuffer> framebuffers; // Keyed by pass & attachment views
+		Statistics statistics;
+	};
+
+	struct AccessInfo {
+		VkImageLayout layout;
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		VkImageUsageFlags usage;
+		bool attachment;
+	};
+	static const AccessInfo& getAccessInfo(Access access);
+	static const char* getAccessName(Access access);
+
+	uint64_t hashDeclarations() const;
+	void cullPasses(std::vector<bool>& culled) const;
+	void createTransientImages(Compiled& compiled, const std::vector<uint32_t>& firstUse, const std::vector<uint32_t>& lastUse,
+		std::vector<ResourceId>& outPreviousOccupants);
+	void planBarriers(Compiled& compiled, const std::vector<uint32_t>& lastUse, const std::vector<ResourceId>& previousOccupants);
+	void createRenderPasses(Compiled& compiled, const std::vector<uint32_t>& firstUse, const std::vector<uint32_t>& lastUse);
+	void recordBarriers(VkCommandBuffer cmd, const BarrierBatch& batch);
+	void beginRendering(VkCommandBuffer cmd, const CompiledPass& compiledPass, bool secondaryCommandBuffers);
+	VkImage getImage(ResourceId resource) const;
+	VkImageView getImageView(ResourceId resource) const;
+	VkExtent2D getExtent(ResourceId resource) const;
+	void destroy(Compiled& compiled);
+
+	// Declarations of the current frame
+	VkExtent2D m_extent = { 0, 0 };
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+
+	std::unique_ptr<Compiled> m_compiled;
+	std::vector<std::pair<uint64_t, std::unique_ptr<Compiled>>> m_retired; // Replaced graphs & the frame serial they were last used in
+	uint64_t m_compileCount = 0;
+	bool m_dynamicRendering;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -0,0 +1,147 @@
+#include "wyvk_frame_pacer.h"
+#include <thread>
+
+namespace Wyvern {
+
+WYVKFramePacer::WYVKFramePacer(WYVKDevice& device, uint32_t frameCount)
+	: m_device(device)
+{
+	if (m_device.getTimestampPeriod() > 0.0f) {
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = frameCount * 2;
+		VK_CALL(vkCreateQueryPool(m_device.getLogicalDevice(), &queryPoolInfo, nullptr, &m_queryPool), "Unable to create frame timestamp query pool!");
+	}
+	else {
+		WYVERN_LOG_WARN("Device has no graphics queue timestamps. Low latency pacing falls back to waiting for the GPU");
+	}
+	m_lastFrameStart = Clock::now();
+	m_inputTime = m_lastFrameStart;
+	m_predictedFinish = m_lastFrameStart;
+}
+
+WYVKFramePacer::~WYVKFramePacer()
+{
+	vkDestroyQueryPool(m_device.getLogicalDevice(), m_queryPool, nullptr);
+}
+
+void WYVKFramePacer::waitForInput(WYVKTimeline& timeline, uint64_t lastSerial)
+{
+	Clock::time_point start = Clock::now();
+	frameCompleted(timeline.getCompletedValue());
+
+	if (m_mode == Mode::LOW_LATENCY && !timeline.isComplete(lastSerial)) {
+		if (hasGpuTimings()) {
+			// The GPU is still busy with the last frame. Start this one so it is submitted right before the GPU runs out of work
+			sleepUntil(m_predictedFinish - toDuration(m_cpuFrameMs + LATENCY_SAFETY_MARGIN_MS));
+		}
+		else {
+			timeline.wait(lastSerial);
+		}
+		frameCompleted(timeline.getCompletedValue());
+	}
+
+	if (m_frameLimit > 0.0f) {
+		sleepUntil(m_lastFrameStart + toDuration(1000.0 / m_frameLimit));
+	}
+
+	m_inputTime = Clock::now();
+	m_lastFrameStart = m_inputTime;
+	m_statistics.sleepMs = toMilliseconds(m_inputTime - start);
+}
+
+void WYVKFramePacer::beginGpuFrame(VkCommandBuffer cmd, uint32_t frame)
+{
+	m_recordingFrame = frame;
+	if (!hasGpuTimings()) {
+		return;
+	}
+	vkCmdResetQueryPool(cmd, m_queryPool, frame * 2, 2);
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, frame * 2);
+}
+
+void WYVKFramePacer::endGpuFrame(VkCommandBuffer cmd, uint32_t frame)
+{
+	if (!hasGpuTimings()) {
+		return;
+	}
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, frame * 2 + 1);
+}
+
+float WYVKFramePacer::readGpuFrameMs(uint32_t frame)
+{
+	if (!hasGpuTimings()) {
+		return 0.0f;
+	}
+	uint64_t timestamps[2] = {};
+	VkResult result = vkGetQueryPoolResults(m_device.getLogicalDevice(), m_queryPool, frame * 2, 2, sizeof(timestamps), timestamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS || timestamps[1] < timestamps[0]) {
+		return 0.0f;
+	}
+	return static_cast<float>((timestamps[1] - timestamps[0]) * static_cast<double>(m_device.getTimestampPeriod()) / 1e6);
+}
+
+void WYVKFramePacer::frameSubmitted(uint64_t serial)
+{
+	Clock::time_point now = Clock::now();
+	m_statistics.cpuFrameMs = toMilliseconds(now - m_inputTime);
+	m_cpuFrameMs = m_cpuFrameMs == 0.0f ? m_statistics.cpuFrameMs : m_cpuFrameMs + SMOOTHING * (m_statistics.cpuFrameMs - m_cpuFrameMs);
+
+	// The GPU starts the frame once it is submitted and the frame before it is done
+	m_predictedFinish = std::max(now, m_predictedFinish) + toDuration(m_gpuFrameMs);
+	m_pending.push_back({ serial, m_recordingFrame, m_inputTime, m_statistics.cpuFrameMs });
+}
+
+void WYVKFramePacer::frameCompleted(uint64_t completedSerial)
+{
+	Clock::time_point now = Clock::now();
+	while (!m_pending.empty() && m_pending.front().serial <= completedSerial) {
+		const PendingFrame& pending = m_pending.front();
+		FrameTiming timing;
+		timing.serial = pending.serial;
+		timing.cpuFrameMs = pending.cpuFrameMs;
+		timing.gpuFrameMs = readGpuFrameMs(pending.frame);
+		timing.latencyMs = toMilliseconds(now - pending.inputTime);
+
+		if (timing.gpuFrameMs > 0.0f) {
+			m_statistics.gpuFrameMs = timing.gpuFrameMs;
+			m_gpuFrameMs = m_gpuFrameMs == 0.0f ? timing.gpuFrameMs : m_gpuFrameMs + SMOOTHING * (timing.gpuFrameMs - m_gpuFrameMs);
+		}
+		m_statistics.latencyMs = timing.latencyMs;
+		m_statistics.averageLatencyMs = m_statistics.averageLatencyMs == 0.0f ? m_statistics.latencyMs
+			: m_statistics.averageLatencyMs + SMOOTHING * (m_statistics.latencyMs - m_statistics.averageLatencyMs);
+		m_pending.pop_front();
+
+		if (m_frameCallback) {
+			m_frameCallback(timing);
+		}
+	}
+}
+
+void WYVKFramePacer::sleepUntil(Clock::time_point deadline)
+{
+	Clock::duration remaining = deadline - Clock::now();
+	if (remaining <= Clock::duration::zero()) {
+		return;
+	}
+	if (remaining > toDuration(SPIN_THRESHOLD_MS)) {
+		std::this_thread::sleep_for(remaining - toDuration(SPIN_THRESHOLD_MS));
+	}
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
+
+WYVKFramePacer::Clock::duration WYVKFramePacer::toDuration(double milliseconds)
+{
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(milliseconds));
+}
+
+float WYVKFramePacer::toMilliseconds(Clock::duration duration)
+{
+	return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+#include "wyvk_timeline.h"
+
+namespace Wyvern {
+
+/*
+* Decides when the frame loop may start the next frame and measures how long frames take from input to GPU completion.
+*
+*   - THROUGHPUT starts a frame as soon as a frame context is free, so the CPU can run up to the frames in flight count ahead of the GPU.
+*     Every queued frame adds a frame of input latency
+*   - LOW_LATENCY holds the frame back until just before the GPU runs out of work. The GPU time of a frame is measured with timestamp
+*     queries and the CPU time from input sampling to submit, so input is sampled when the frame can be submitted right as the GPU
+*     finishes the previous one. Without timestamp support it waits for the GPU to finish instead
+*
+* Independently of the mode, a frame limiter caps the frame rate. It sleeps most of the way and spins the rest, since a plain sleep
+* overshoots by up to the OS scheduler granularity.
+*
+* Latency is measured from input sampling to the frame's serial being reached on the frame timeline, which is when the frame can be
+* presented. It is only noticed the next time the pacer looks at the timeline, so it reads a little high in THROUGHPUT mode.
+*/
+class WYVKFramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Mode : uint32_t {
+		THROUGHPUT = 0,
+		LOW_LATENCY,
+	};
+
+	struct Statistics {
+		float cpuFrameMs = 0.0f;		// Input sampled to submit, last submitted frame
+		float gpuFrameMs = 0.0f;		// Frame command buffer on the GPU, last completed frame. 0 without timestamp support
+		float latencyMs = 0.0f;			// Input sampled to the frame being done on the GPU, last completed frame
+		float averageLatencyMs = 0.0f;
+		float sleepMs = 0.0f;			// How long the last frame was held back by pacing & the limiter
+	};
+
+	// Measurements of a single frame, reported once its serial is done on the GPU
+	struct FrameTiming {
+		uint64_t serial = 0;
+		float cpuFrameMs = 0.0f;
+		float gpuFrameMs = 0.0f;		// 0 without timestamp support
+		float latencyMs = 0.0f;
+	};
+	using FrameCallback = std::function<void(const FrameTiming& timing)>;
+
+	// The limiter stops sleeping this long before its deadline and spins the rest
+	static constexpr double SPIN_THRESHOLD_MS = 2.0;
+	// LOW_LATENCY starts frames this much earlier than predicted, so a slow frame doesn't leave the GPU waiting
+	static constexpr double LATENCY_SAFETY_MARGIN_MS = 1.0;
+	// Weight of the newest sample in the smoothed CPU/GPU times
+	static constexpr float SMOOTHING = 0.1f;
+
+	/*
+	* `frameCount` is the number of frame contexts, each gets its own pair of timestamp queries
+	*/
+	WYVKFramePacer(WYVKDevice& device, uint32_t frameCount);
+	~WYVKFramePacer();
+
+	inline void setMode(Mode mode) { m_mode = mode; }
+	inline Mode getMode() const { return m_mode; }
+	// Caps the frame rate to `framesPerSecond`. 0 disables the limiter
+	inline void setFrameLimit(float framesPerSecond) { m_frameLimit = framesPerSecond; }
+	inline float getFrameLimit() const { return m_frameLimit; }
+	inline bool hasGpuTimings() const { return m_queryPool != VK_NULL_HANDLE; }
+	// Called by frameCompleted() for every frame, in submission order, e.g. to collect per frame samples
+	inline void setFrameCallback(FrameCallback callback) { m_frameCallback = std::move(callback); }
+
+	/*
+	* Blocks until the next frame should start. Must be called right before input is sampled, the frame's latency is measured from here.
+	* `lastSerial` is the serial of the last frame submitted to the queue `timeline` belongs to
+	*/
+	void waitForInput(WYVKTimeline& timeline, uint64_t lastSerial);
+
+	/*
+	* Writes the timestamps of the frame recorded into frame context `frame`. beginGpuFrame() has to be recorded outside a render pass,
+	* before anything else in the frame's primary command buffer, endGpuFrame() after everything. The previous submission of `frame`
+	* must be done and passed to frameCompleted(), its timestamps are read there
+	*/
+	void beginGpuFrame(VkCommandBuffer cmd, uint32_t frame);
+	void endGpuFrame(VkCommandBuffer cmd, uint32_t frame);
+
+	void frameSubmitted(uint64_t serial);
+	/*
+	* Measures the GPU time & latency of every submitted frame up to `completedSerial` and reports them to the frame callback.
+	* UINT64_MAX after the device is idle drains every pending frame
+	*/
+	void frameCompleted(uint64_t completedSerial);
+
+	inline const Statistics& getStatistics() const { return m_statistics; }
+
+private:
+	struct PendingFrame {
+		uint64_t serial;
+		uint32_t frame;					// Frame context holding its timestamps
+		Clock::time_point inputTime;
+		float cpuFrameMs;
+	};
+
+	// GPU time of the timestamps in frame context `frame`, 0 if they can't be read
+	float readGpuFrameMs(uint32_t frame);
+
+	static void sleepUntil(Clock::time_point deadline);
+	static Clock::duration toDuration(double milliseconds);
+	static float toMilliseconds(Clock::duration duration);
+
+	Mode m_mode = Mode::THROUGHPUT;
+	float m_frameLimit = 0.0f;
+
+	VkQueryPool m_queryPool = VK_NULL_HANDLE;	// Two timestamps per frame context. Null without timestamp support
+	uint32_t m_recordingFrame = 0;				// Frame context of the frame between beginGpuFrame() & frameSubmitted()
+
+	Clock::time_point m_inputTime;
+	Clock::time_point m_lastFrameStart;
+	Clock::time_point m_predictedFinish;		// When the GPU should be done with the last submitted frame
+	float m_cpuFrameMs = 0.0f;					// Smoothed
+	float m_gpuFrameMs = 0.0f;
+	std::deque<PendingFrame> m_pending;
+	Statistics m_statistics;
+	FrameCallback m_frameCallback;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
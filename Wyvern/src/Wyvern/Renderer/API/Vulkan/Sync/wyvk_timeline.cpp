@@ -0,0 +1,54 @@
+#include "wyvk_timeline.h"
+
+namespace Wyvern {
+
+WYVKTimeline::WYVKTimeline(WYVKDevice& device, const char* name)
+	: m_name(name),
+	m_device(device)
+{
+	VkSemaphoreTypeCreateInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &timelineInfo;
+	VK_CALL(vkCreateSemaphore(m_device.getLogicalDevice(), &semaphoreInfo, nullptr, &m_semaphore), "Unable to create timeline semaphore!");
+}
+
+WYVKTimeline::~WYVKTimeline()
+{
+	vkDestroySemaphore(m_device.getLogicalDevice(), m_semaphore, nullptr);
+}
+
+uint64_t WYVKTimeline::getCompletedValue()
+{
+	VK_CALL(vkGetSemaphoreCounterValue(m_device.getLogicalDevice(), m_semaphore, &m_completedValue), "Failed to query timeline semaphore!");
+	return m_completedValue;
+}
+
+bool WYVKTimeline::wait(uint64_t value, uint64_t timeout)
+{
+	if (isComplete(value)) {
+		return true;
+	}
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_semaphore;
+	waitInfo.pValues = &value;
+	VkResult result = vkWaitSemaphores(m_device.getLogicalDevice(), &waitInfo, timeout);
+	if (result == VK_TIMEOUT) {
+		return false;
+	}
+	if (result != VK_SUCCESS) {
+		WYVERN_LOG_ERROR("Failed to wait for the {} timeline to reach {}", m_name, value);
+		WYVERN_THROW("Failed to wait for timeline semaphore!");
+	}
+	m_completedValue = std::max(m_completedValue, value);
+	return true;
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Wyvern/Core.h"
+#include "../wyvk_device.h"
+
+namespace Wyvern {
+
+/*
+* Timeline semaphore owned by one queue. Every submission to the queue signals it with a value higher than the last one, so a single
+* value tells both the CPU and other queues how far the queue has come. Values are handed out by the owner of the queue (the renderer
+* signals its frame serials, the upload service its submission count), this only waits on & queries them.
+*
+* Not thread safe. The owner of the queue synchronizes access
+*/
+class WYVKTimeline
+{
+public:
+	WYVKTimeline(WYVKDevice& device, const char* name);
+	~WYVKTimeline();
+
+	/*
+	* Queries the value the GPU has reached. Never blocks
+	*/
+	uint64_t getCompletedValue();
+
+	/*
+	* True once `value` has been reached. Only queries the semaphore if the last known value is below it
+	*/
+	inline bool isComplete(uint64_t value) { return value <= m_completedValue || value <= getCompletedValue(); }
+
+	/*
+	* Blocks until `value` has been reached or `timeout` (in nanoseconds) runs out. Returns false on timeout. Waiting for 0 returns right away
+	*/
+	bool wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+	inline VkSemaphore getSemaphore() const { return m_semaphore; }
+
+private:
+	VkSemaphore m_semaphore = VK_NULL_HANDLE;
+	uint64_t m_completedValue = 0;		// Last value read from the semaphore
+	const char* m_name;
+
+	// Handles
+	WYVKDevice& m_device;
+};
+
+}
@@ -2,14 +2,25 @@
 #include <set>
 
 #include "wyvk_device.h"
+#include "Memory/wyvk_allocator.h"
 
 namespace Wyvern {
 
 WYVKDevice::WYVKDevice(WYVKInstance& instance)
     : m_instance(instance)
 {
+    // Nothing is presented without a window system
+    if (m_instance.isHeadless()) {
+        m_deviceExtensions.clear();
+    }
     createPhysicalDevice();
     createLogicalDevice();
+    m_allocator = std::make_unique<WYVKAllocator>(*this);
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &deviceProperties);
+    m_memoryPolicy = std::make_unique<WYVKMemoryPolicy>(m_allocator->getMemoryProperties(), deviceProperties.deviceType);
+    m_memoryPolicy->logDecisionTable();
 }
 
 /*
@@ -18,10 +29,22 @@ WYVKDevice::WYVKDevice(WYVKInstance& instance)
 */
 WYVKDevice::~WYVKDevice()
 {
+    // All device memory has to be released before the device goes away
+    m_allocator.reset();
     WYVERN_LOG_INFO("Destroying Logical Device...");
     vkDestroyDevice(m_logicalDevice, nullptr);
 }
 
+WYVKAllocator& WYVKDevice::getAllocator()
+{
+    return *m_allocator;
+}
+
+const WYVKMemoryPolicy& WYVKDevice::getMemoryPolicy() const
+{
+    return *m_memoryPolicy;
+}
+
 void WYVKDevice::createPhysicalDevice() {
     // Retrieve valid physical devices from the system
     std::vector<VkPhysicalDevice> devices = queryPhysicalDevices(m_instance.getInstance());
@@ -57,6 +80,9 @@ void WYVKDevice::createLogicalDevice() {
         m_queueFamilyIndices.presentFamily.value(),
         m_queueFamilyIndices.computeFamily.value()
     };
+    if (m_queueFamilyIndices.hasDedicatedTransferFamily()) {
+        uniqueQueueFamilies.insert(m_queueFamilyIndices.transferFamily.value());
+    }
     // Create queue info's for all queue families in uniqueQueueFamilies
     // Some queue families may have the same index which is ok.
     float queuePriority = 1.0f;
@@ -69,7 +95,69 @@ void WYVKDevice::createLogicalDevice() {
         queueCreateInfos.push_back(deviceQueueInfo);
     }
 
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &deviceProperties);
+
+    // Query the optional indirect draw features and only enable what the device actually has.
+    // The 1.3 features can only be queried on a device that reports 1.3
+    VkPhysicalDeviceVulkan13Features supported13Features{};
+    supported13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    VkPhysicalDeviceVulkan12Features supported12Features{};
+    supported12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    supported12Features.pNext = deviceProperties.apiVersion >= VK_API_VERSION_1_3 ? &supported13Features : nullptr;
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supported12Features;
+    vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures);
+
+    m_indirectDrawSupport.multiDrawIndirect = supportedFeatures.features.multiDrawIndirect;
+    m_indirectDrawSupport.drawIndirectFirstInstance = supportedFeatures.features.drawIndirectFirstInstance;
+    m_indirectDrawSupport.drawIndirectCount = supported12Features.drawIndirectCount;
+    m_indirectDrawSupport.maxDrawIndirectCount = m_indirectDrawSupport.multiDrawIndirect ? deviceProperties.limits.maxDrawIndirectCount : 1;
+    WYVERN_LOG_INFO("Indirect draws (multi draw: {} | first instance: {} | draw count: {} | max draws: {})",
+        m_indirectDrawSupport.multiDrawIndirect, m_indirectDrawSupport.drawIndirectFirstInstance,
+        m_indirectDrawSupport.drawIndirectCount, m_indirectDrawSupport.maxDrawIndirectCount);
+
+    // Bindless descriptors. Falls back to classic descriptor sets unless every feature it relies on is there
+    m_bindlessSupport.supported = supported12Features.descriptorIndexing && supported12Features.runtimeDescriptorArray &&
+        supported12Features.descriptorBindingPartiallyBound && supported12Features.descriptorBindingUpdateUnusedWhilePending &&
+        supported12Features.descriptorBindingStorageBufferUpdateAfterBind && supported12Features.descriptorBindingSampledImageUpdateAfterBind &&
+        supported12Features.shaderStorageBufferArrayNonUniformIndexing && supported12Features.shaderSampledImageArrayNonUniformIndexing;
+    // The update after bind limits are 1.2 properties. Without them the set is never created, so the limits stay 0
+    VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+    vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceProperties2 deviceProperties2{};
+        deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        deviceProperties2.pNext = &vulkan12Properties;
+        vkGetPhysicalDeviceProperties2(m_physicalDevice, &deviceProperties2);
+    }
+    // The arrays are visible to every stage, so the per stage limits apply as well
+    m_bindlessSupport.maxStorageBuffers = std::min(vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+    m_bindlessSupport.maxSampledImages = std::min(vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+    m_bindlessSupport.maxSamplers = std::min(vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers);
+    WYVERN_LOG_INFO("Bindless descriptors: {}", m_bindlessSupport.supported);
+
+    // Descriptor update templates are core since 1.1, so only a device reporting 1.0 goes without them
+    m_descriptorUpdateTemplates = deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+
+    m_dynamicRendering = supported13Features.dynamicRendering;
+    WYVERN_LOG_INFO("Dynamic rendering: {}", m_dynamicRendering);
+
+    m_timestampPeriod = deviceProperties.limits.timestampComputeAndGraphics ? deviceProperties.limits.timestampPeriod : 0.0f;
+
+    m_rayTracing = checkPhysicalDeviceExtensionSupport(m_physicalDevice, m_rayTracingExtensions);
+    WYVERN_LOG_INFO("Ray tracing: {}", m_rayTracing);
+    std::vector<const char*> enabledExtensions = m_deviceExtensions;
+    if (m_rayTracing) {
+        enabledExtensions.insert(enabledExtensions.end(), m_rayTracingExtensions.begin(), m_rayTracingExtensions.end());
+    }
+
     VkPhysicalDeviceFeatures deviceFeatures{};
+    deviceFeatures.multiDrawIndirect = supportedFeatures.features.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.features.drawIndirectFirstInstance;
+    deviceFeatures.fillModeNonSolid = supportedFeatures.features.fillModeNonSolid;
+    m_fillModeNonSolid = supportedFeatures.features.fillModeNonSolid;
 
     VkPhysicalDeviceRayTracingPipelineFeaturesKHR rayTracingFeatures{};
     rayTracingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR;
@@ -80,14 +168,36 @@ void WYVKDevice::createLogicalDevice() {
     accelerationStructureFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
     accelerationStructureFeatures.pNext = &rayTracingFeatures;
 
+    VkPhysicalDeviceVulkan13Features vulkan13Features{};
+    vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    vulkan13Features.pNext = m_rayTracing ? &accelerationStructureFeatures : nullptr;
+    vulkan13Features.dynamicRendering = VK_TRUE;
+
+    // Timeline semaphores are used to track async uploads on the transfer queue. Draw count is optional (see m_indirectDrawSupport)
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.pNext = m_dynamicRendering ? static_cast<void*>(&vulkan13Features) : (m_rayTracing ? &accelerationStructureFeatures : nullptr);
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+    vulkan12Features.drawIndirectCount = supported12Features.drawIndirectCount;
+    if (m_bindlessSupport.supported) {
+        vulkan12Features.descriptorIndexing = VK_TRUE;
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    }
+
     VkDeviceCreateInfo deviceCreateInfo{};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.pNext = &accelerationStructureFeatures;
+    deviceCreateInfo.pNext = &vulkan12Features;
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
     deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
-    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
-    deviceCreateInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
+    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if (ENABLE_VALIDATION_LAYERS) {
         deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(m_instance.getValidationLayers().size());
@@ -100,7 +210,16 @@ void WYVKDevice::createLogicalDevice() {
 
     vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndices.presentFamily.value(), 0, &m_presentQueue);
     vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndices.graphicsFamily.value(), 0, &m_graphicsQueue);
-    vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndices.computeFamily.value(), 0, &m_graphicsQueue);
+    vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndices.computeFamily.value(), 0, &m_computeQueue);
+
+    if (m_queueFamilyIndices.hasDedicatedTransferFamily()) {
+        vkGetDeviceQueue(m_logicalDevice, m_queueFamilyIndices.transferFamily.value(), 0, &m_transferQueue);
+        WYVERN_LOG_INFO("Using dedicated transfer queue family {}", m_queueFamilyIndices.transferFamily.value());
+    }
+    else {
+        m_transferQueue = m_graphicsQueue;
+        WYVERN_LOG_INFO("No dedicated transfer queue family found. Uploads will use the graphics queue");
+    }
 }
 
 //  Retrieves a list of physical device objects representing the physical devices installed in the system
@@ -139,14 +258,13 @@ bool WYVKDevice::ratePhysicalDeviceSuitability(VkPhysicalDevice device)
 bool WYVKDevice::isPhysicalDeviceSuitable(VkPhysicalDevice device)
 {
     QueueFamilyIndices indices = findQueueFamilies(device);
-    bool extensionsSupported = checkPhysicalDeviceExtensionSupport(device);
+    bool extensionsSupported = checkPhysicalDeviceExtensionSupport(device, m_deviceExtensions);
 
     return indices.hasAllValidFamilies() && extensionsSupported;
 }
 
-// Retrieves all available extensions from the device and checks the extensions against the m_deviceExtensions member variable to
-// see if our required extensions exist
-bool WYVKDevice::checkPhysicalDeviceExtensionSupport(VkPhysicalDevice device)
+// Retrieves all available extensions from the device and checks if every one of `extensions` exists
+bool WYVKDevice::checkPhysicalDeviceExtensionSupport(VkPhysicalDevice device, const std::vector<const char*>& extensions)
 {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -154,7 +272,7 @@ bool WYVKDevice::checkPhysicalDeviceExtensionSupport(VkPhysicalDevice device)
     std::vector<VkExtensionProperties> availableExtensions(extensionCount);
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(m_deviceExtensions.begin(), m_deviceExtensions.end());
+    std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
     for (const auto& extension : availableExtensions) {
         requiredExtensions.erase(extension.extensionName);
@@ -172,24 +290,35 @@ WYVKDevice::QueueFamilyIndices WYVKDevice::findQueueFamilies(VkPhysicalDevice de
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-    int i = 0;
+    uint32_t i = 0;
     for (const auto& queueFamily : queueFamilies) {
 
-        if (indices.hasAllValidFamilies()) { // Breaks out of loop if all families are valid
-            break;
+        if (queueFamily.queueCount == 0) {
+            i++;
+            continue;
         }
 
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        if (!indices.graphicsFamily.has_value() && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
             indices.graphicsFamily = i;
         }
 
-        if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) {
+        if (!indices.computeFamily.has_value() && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
             indices.computeFamily = i;
         }
 
-        if (queueFamily.queueCount > 0) {
+        if (!indices.presentFamily.has_value()) {
             indices.presentFamily = i;
         }
+
+        // Look for a family that can do transfers but not graphics. These map to the DMA engines on discrete GPUs.
+        // A transfer-only family is preferred over an async compute family that also supports transfers
+        if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            bool transferOnly = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+            if (!indices.transferFamily.has_value() || transferOnly) {
+                indices.transferFamily = i;
+            }
+        }
+        i++;
     }
 
     return indices;
@@ -1,12 +1,16 @@
 #pragma once
+#include <mutex>
 #include <optional>
 
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "CreateInfo/info.h"
 #include "Wyvern/Renderer/API/Vulkan/wyvk_instance.h"
 
 namespace Wyvern {
 
+class WYVKAllocator;
+class WYVKMemoryPolicy;
+
 class WYVKDevice
 {
 public:
@@ -14,10 +18,31 @@ public:
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
 		std::optional<uint32_t> computeFamily;
+		std::optional<uint32_t> transferFamily; // Optional. Only set when the device has a transfer queue family separate from graphics
 
 		bool hasAllValidFamilies() {
 			return graphicsFamily.has_value() && presentFamily.has_value() && computeFamily.has_value();
 		}
+
+		bool hasDedicatedTransferFamily() const {
+			return transferFamily.has_value() && transferFamily != graphicsFamily;
+		}
+	};
+
+	// Optional features used by indirect draw submission. Only the supported ones are enabled on the logical device
+	struct IndirectDrawSupport {
+		bool multiDrawIndirect = false;			// drawCount > 1 in a single vkCmdDrawIndexedIndirect
+		bool drawIndirectFirstInstance = false;	// Non zero firstInstance in indirect commands. Used to index per draw data
+		bool drawIndirectCount = false;			// vkCmdDrawIndexedIndirectCount (Vulkan 1.2)
+		uint32_t maxDrawIndirectCount = 1;
+	};
+
+	// Descriptor indexing features needed by the bindless descriptor set (see WYVKBindlessSet). All or nothing
+	struct BindlessSupport {
+		bool supported = false;
+		uint32_t maxStorageBuffers = 0;		// Update after bind limits
+		uint32_t maxSampledImages = 0;
+		uint32_t maxSamplers = 0;
 	};
 
 public:
@@ -45,16 +70,54 @@ public:
 	inline VkQueue getPresentQueue() { return m_presentQueue; }
 	inline VkQueue getComputeQueue() { return m_computeQueue; }
 
+	/*
+	* Queue used for asynchronous uploads. This is the graphics queue when the device has no separate transfer family (e.g. lavapipe),
+	* use getTransferFamily() to know which family it belongs to.
+	*/
+	inline VkQueue getTransferQueue() { return m_transferQueue; }
+	inline uint32_t getTransferFamily() const {
+		return m_queueFamilyIndices.hasDedicatedTransferFamily() ? m_queueFamilyIndices.transferFamily.value() : m_queueFamilyIndices.graphicsFamily.value();
+	}
+
+	/*
+	* Queues have to be externally synchronized and the getters above may return the same VkQueue (e.g. transfer falling back to graphics).
+	* Every vkQueueSubmit, vkQueuePresentKHR & vkDeviceWaitIdle holds this lock, whichever thread it is made from
+	*/
+	inline std::mutex& getQueueMutex() { return m_queueMutex; }
+
+	inline const IndirectDrawSupport& getIndirectDrawSupport() const { return m_indirectDrawSupport; }
+	// Line & point polygon modes, e.g. for wireframe pipeline variants
+	inline bool supportsFillModeNonSolid() const { return m_fillModeNonSolid; }
+	inline const BindlessSupport& getBindlessSupport() const { return m_bindlessSupport; }
+	// vkUpdateDescriptorSetWithTemplate (core in Vulkan 1.1)
+	inline bool supportsDescriptorUpdateTemplates() const { return m_descriptorUpdateTemplates; }
+	// vkCmdBeginRendering & pipelines built against attachment formats instead of a render pass (core in Vulkan 1.3)
+	inline bool supportsDynamicRendering() const { return m_dynamicRendering; }
+	// VK_KHR_ray_tracing_pipeline & VK_KHR_acceleration_structure. Optional, software drivers like lavapipe don't have them
+	inline bool supportsRayTracing() const { return m_rayTracing; }
+	// Nanoseconds per timestamp query tick on the graphics queue. 0 if the device can't write timestamps there
+	inline float getTimestampPeriod() const { return m_timestampPeriod; }
+
+	// Device memory sub-allocator. All buffers and images should get their memory from here
+	WYVKAllocator& getAllocator();
+
+	// Decides which memory each kind of buffer should be placed in
+	const WYVKMemoryPolicy& getMemoryPolicy() const;
+
 private:
 	std::vector<VkPhysicalDevice> queryPhysicalDevices(VkInstance instance);
 	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
 
 	bool ratePhysicalDeviceSuitability(VkPhysicalDevice device);
 	bool isPhysicalDeviceSuitable(VkPhysicalDevice device);
-	bool checkPhysicalDeviceExtensionSupport(VkPhysicalDevice device);
+	bool checkPhysicalDeviceExtensionSupport(VkPhysicalDevice device, const std::vector<const char*>& extensions);
 
-	const std::vector<const char*> m_deviceExtensions = {
+	// Required, except for the swapchain on a headless instance
+	std::vector<const char*> m_deviceExtensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+	};
+	// Enabled all together if the device has every one of them
+	const std::vector<const char*> m_rayTracingExtensions = {
 		VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,	// To build acceleration structures
 		VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,		// To use vkCmdTraceRaysKHR
 		VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,	// Required by ray tracing pipeline
@@ -68,6 +131,19 @@ private:
 	VkQueue m_presentQueue = VK_NULL_HANDLE;
 	VkQueue m_graphicsQueue = VK_NULL_HANDLE;
 	VkQueue m_computeQueue = VK_NULL_HANDLE;
+	VkQueue m_transferQueue = VK_NULL_HANDLE;
+	std::mutex m_queueMutex;
+
+	IndirectDrawSupport m_indirectDrawSupport;
+	bool m_fillModeNonSolid = false;
+	BindlessSupport m_bindlessSupport;
+	bool m_descriptorUpdateTemplates = false;
+	bool m_dynamicRendering = false;
+	bool m_rayTracing = false;
+	float m_timestampPeriod = 0.0f;
+
+	std::unique_ptr<WYVKAllocator> m_allocator;
+	std::unique_ptr<WYVKMemoryPolicy> m_memoryPolicy;
 
 	//Handles
 	WYVKInstance& m_instance;
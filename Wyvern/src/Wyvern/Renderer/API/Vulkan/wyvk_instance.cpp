@@ -1,6 +1,7 @@
 #include "wyvk_instance.h"
 
-Wyvern::WYVKInstance::WYVKInstance()
+Wyvern::WYVKInstance::WYVKInstance(bool headless)
+    : m_headless(headless)
 {
     VkDebugUtilsMessengerCreateInfoEXT messengerCreateInfo{};
     VKInfo::createDebugMessengerInfo(messengerCreateInfo, WYVKMessenger::debugCallback);
@@ -84,11 +85,14 @@ bool Wyvern::WYVKInstance::checkValidationLayerSupport(const std::vector<const c
 
 void Wyvern::WYVKInstance::getRequiredExtensions(std::vector<const char*>& extensions)
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
+    extensions.clear();
+    if (!m_headless) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
 
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     // Adds the debug extension for debug messagess.
     // These messages are useful when we are using validation layers
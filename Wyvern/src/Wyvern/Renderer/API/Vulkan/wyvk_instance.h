@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/Renderer/API/Vulkan/CreateInfo/info.h"
 #include "Wyvern/Renderer/API/Vulkan/wyvk_debug.h"
 
@@ -8,13 +8,15 @@ namespace Wyvern {
 class WYVKInstance
 {
 public:
-	WYVKInstance();
+	// A headless instance enables no window system extensions, so it can be created without GLFW
+	WYVKInstance(bool headless = false);
 	~WYVKInstance();
 
 	bool checkValidationLayerSupport(const std::vector<const char*>& validationLayers);
 	void getRequiredExtensions(std::vector<const char*>& extensions);
 
 	VkInstance getInstance() { return m_instance; }
+	bool isHeadless() const { return m_headless; }
 	const std::vector<const char*>& getValidationLayers() { return m_validationLayers;  }
 	std::vector<const char*>& getEnabledExtensions() { return m_enabledExtensions; }
 
@@ -24,6 +26,7 @@ private:
 
 	const std::vector<const char*> m_validationLayers = { "VK_LAYER_KHRONOS_validation" };
 	std::vector<const char*> m_enabledExtensions;
+	bool m_headless;
 
 };
 
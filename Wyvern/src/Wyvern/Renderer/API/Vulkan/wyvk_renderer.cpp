@@ -1,15 +1,19 @@
 #include "wyvk_renderer.h"
 #include "Descriptor/wyvk_descriptorlayout.h"
+#include "Geometry/Model.h"
 
 namespace Wyvern {
 
+// Headless frames render into the offscreen image of their frame context
+static_assert(WYVKSwapchain::OFFSCREEN_IMAGE_COUNT >= WYVKRenderer::MAX_FRAMES_IN_FLIGHT, "Every frame context needs its own offscreen image");
 
-WYVKRenderer::WYVKRenderer(Window& window)
-    : m_window(window),
-    m_instance(std::make_unique<WYVKInstance>()),
+WYVKRenderer::WYVKRenderer(Window& window, uint32_t recordingSlots, ThreadPool* compilePool, bool allowDynamicRendering)
+    : m_instance(std::make_unique<WYVKInstance>(window.isHeadless())),
     m_device(std::make_unique<WYVKDevice>(*m_instance)),
-    m_surface(std::make_unique<WYVKSurface>(*m_instance, *m_device, window)),
-    m_swapchain(std::make_unique<WYVKSwapchain>(*m_instance, *m_device, *m_surface, window))
+    m_surface(window.isHeadless() ? nullptr : std::make_unique<WYVKSurface>(*m_instance, *m_device, window)),
+    m_swapchain(std::make_unique<WYVKSwapchain>(*m_instance, *m_device, m_surface.get(), window)),
+    m_compilePool(compilePool),
+    m_window(window)
     //m_descriptorSetLayout(WYVKDescriptorSetLayout(*m_device, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT))
 {
 
@@ -18,16 +22,40 @@ WYVKRenderer::WYVKRenderer(Window& window)
     m_swapchain->createSwapchain();
     m_swapchain->createImageViews();
 
-    // Create the render pass & store
-    m_renderPass = std::make_unique<WYVKRenderPass>(*m_swapchain, *m_device);
+    // Create the render pass & store. With dynamic rendering it only describes the attachment formats
+    bool dynamicRendering = allowDynamicRendering && m_device->supportsDynamicRendering();
+    WYVERN_LOG_INFO("Rendering with {}", dynamicRendering ? "dynamic rendering" : "render passes");
+    m_renderPass = std::make_unique<WYVKRenderPass>(*m_swapchain, *m_device, dynamicRendering);
     m_renderPass->createRenderPass();
-    m_renderPass->createFramebuffers();
+    m_renderGraph = std::make_unique<WYVKRenderGraph>(*m_device, dynamicRendering);
 
     // Create graphics pipeline & render frame contexts (which includes the descriptorSetLayout which is needed in the pipeline)
     createDescriptorSets();
     createRenderFrameContexts();
+    m_pipelineCache = std::make_unique<WYVKPipelineCache>(*m_device);
+    m_pipelineBuildStart = std::chrono::steady_clock::now();
     m_graphicsPipeline = std::make_unique<WYVKGraphicsPipeline>(*m_device, *m_swapchain, *m_renderPass);
-    m_graphicsPipeline->createGraphicsPipeline(m_descriptorSetLayout->getLayout());
+    createPipeline(*m_graphicsPipeline);
+    m_indirectPipeline = std::make_unique<WYVKGraphicsPipeline>(*m_device, *m_swapchain, *m_renderPass,
+        INDIRECT_VERTEX_SHADER, WYVKGraphicsPipeline::DEFAULT_FRAGMENT_SHADER);
+    createPipeline(*m_indirectPipeline);
+    m_instancedPipeline = std::make_unique<WYVKGraphicsPipeline>(*m_device, *m_swapchain, *m_renderPass,
+        INSTANCED_VERTEX_SHADER, WYVKGraphicsPipeline::DEFAULT_FRAGMENT_SHADER);
+    m_instancedPipeline->setInstanceInputLocation(INSTANCE_INPUT_LOCATION);
+    createPipeline(*m_instancedPipeline);
+    if (m_bindlessSet) {
+        m_bindlessPipeline = std::make_unique<WYVKGraphicsPipeline>(*m_device, *m_swapchain, *m_renderPass,
+            BINDLESS_VERTEX_SHADER, WYVKGraphicsPipeline::DEFAULT_FRAGMENT_SHADER);
+        m_bindlessPipeline->setAdditionalSetLayouts({ m_bindlessSet->getLayout() });
+        createPipeline(*m_bindlessPipeline);
+    }
+    logPipelineTimings(); // Only logs here when the pipelines were built synchronously
+    m_pipelineRegistry = std::make_unique<WYVKPipelineRegistry>(*m_device, *m_swapchain, *m_renderPass, m_descriptorSetLayout->getLayout(),
+        m_shaderReflection.pushConstants, m_pipelineCache->getPipelineCache(), m_compilePool);
+    m_activePipeline = m_graphicsPipeline.get();
+    if (m_compilePool) {
+        m_shaderWatcher = std::make_unique<WYVKShaderWatcher>("src/Wyvern/Assets/Shaders");
+    }
 
     /*
     * RT
@@ -39,11 +67,13 @@ WYVKRenderer::WYVKRenderer(Window& window)
 
     m_commandPool = std::make_unique<WYVKCommandPool>(*m_device);   
     createCommandBuffers();
+    m_frameCommandPools = std::make_unique<WYVKFrameCommandPools>(*m_device, static_cast<uint32_t>(m_frameContexts.size()), std::max(recordingSlots, 1u));
 
-    // Create fence for transfer operations
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    VK_CALL(vkCreateFence(m_device->getLogicalDevice(), &fenceInfo, nullptr, &m_transferFence), "Unable to create transfer fence!");
+    m_geometryArena = std::make_unique<WYVKGeometryArena>(*m_device);
+    m_uploadService = std::make_unique<WYVKUploadService>(*m_device);
+    if (isHeadless()) {
+        m_readbackRing = std::make_unique<WYVKReadbackRing>(*m_device, *m_frameTimeline, MAX_FRAMES_IN_FLIGHT, m_swapchain->getExtent(), m_swapchain->getImageFormat());
+    }
 }
 
 WYVKRenderer::~WYVKRenderer()
@@ -52,9 +82,6 @@ WYVKRenderer::~WYVKRenderer()
     for (FrameContext& context : m_frameContexts) {
         destroySyncObjects(context);
     }
-    // Make sure to destroy the transfer fence too
-    vkDestroyFence(m_device->getLogicalDevice(), m_transferFence, nullptr);
-
 }
 
 void WYVKRenderer::checkGLFWSupportedExtensions(std::vector<VkExtensionProperties>& availableExtensionProperties)
@@ -91,7 +118,9 @@ void WYVKRenderer::initRenderAPI()
     for (const auto& extension : extensions) {
         WYVERN_LOG_INFO("\t{}", extension.extensionName);
     }
-    checkGLFWSupportedExtensions(extensions);
+    if (!isHeadless()) {
+        checkGLFWSupportedExtensions(extensions);
+    }
 }
 
 void WYVKRenderer::initRaytracing()
@@ -107,78 +136,299 @@ void WYVKRenderer::initRaytracing()
 
 bool WYVKRenderer::acquireNextSwapchainImage(uint32_t currentFrame, uint32_t& currentImage)
 {
-    // Waits for the In - Flight Fence bound to a specific framebuffer to be signaled. When a fence is signaled, it means the work done previously on the 
-    // framebuffer is complete and we can start to render to that frame buffer.
-    // This is called before we start our rendering sequence so that the CPU stalls before it knows it can start on a new frame.
-    VK_CALL(vkWaitForFences(m_device->getLogicalDevice(), 1, &m_frameContexts[currentFrame].inFlightFence, VK_TRUE, UINT64_MAX), "Failed to wait for fence!");
+    // Waits until the GPU is done with the frame that last used this context. This is where the CPU stalls if it gets
+    // more than getFramesInFlight() frames ahead of the GPU.
+    m_frameTimeline->wait(m_frameContexts[currentFrame].frameSerial);
+
+    // Everything up to the completed serial is done on the GPU, which can be further than this context's frame
+    uint64_t completedSerial = m_frameTimeline->getCompletedValue();
+    m_framePacer->frameCompleted(completedSerial);
+    m_geometryArena->retire(completedSerial);
+    m_uploadService->collect();
+    m_pipelineCache->saveIfStale();
+    updateShaderHotReload(completedSerial);
+    m_pipelineRegistry->evictUnused(completedSerial, PIPELINE_EVICTION_FRAMES);
+    if (m_bindlessSet) {
+        m_bindlessSet->retire(completedSerial);
+    }
+    m_renderGraph->retire(completedSerial);
+    m_swapchain->retire(completedSerial);
+    if (!m_pipelineTimingsLogged) {
+        logPipelineTimings();
+    }
+
+    // The context's offscreen image was last used by the frame waited on above
+    if (isHeadless()) {
+        m_readbackRing->collect(completedSerial);
+        currentImage = currentFrame;
+        return true;
+    }
     
     VkResult result = vkAcquireNextImageKHR(m_device->getLogicalDevice(), m_swapchain->getSwapchain(), UINT64_MAX, m_frameContexts[currentFrame].imageAvailableSemaphore, VK_NULL_HANDLE, &currentImage);
 
-    // Returns false if the swapchain is out of date or the window was resized
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || m_window.isFramebufferResized()) {
+    // Returns false if the swapchain is out of date. Nothing was acquired then, so the image semaphore is still unsignaled.
+    // A resized window is handled after presenting, since an acquired image has to be presented for its semaphore to be waited on
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         return false;
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("Failed to acquire swap chain image!");
     }
-
-    // This call simply changes the state of a fence to be un-signaled. This is done once we know we have an image we can draw to.
-    // If, for example, we un-signaled the fence right after we wait on it and the swapchain needs to be recreated, 
-    // the drawFrame function will exit early, and on the next frame the fence will be waiting for a non existent frame to finish 
-    VK_CALL(vkResetFences(m_device->getLogicalDevice(), 1, &m_frameContexts[currentFrame].inFlightFence), "Failed to reset fence!");
     return true;
 }
 
 void WYVKRenderer::immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& func) 
 {
+    // A frame being recorded already took a serial that isn't signaled yet. Taking the next one here and waiting on it would
+    // signal the timeline past the frame's serial before the frame is even submitted
+    if (m_frameRecording) {
+        WYVERN_LOG_ERROR("immediateSubmit() called while a frame is being recorded");
+        WYVERN_THROW("immediateSubmit() must not be called while a frame is being recorded!");
+    }
+
     WYVKCommandBuffer cmdBuffer = WYVKCommandBuffer(*m_device, *m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
     cmdBuffer.startRecording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
+    // Takes the next serial like a frame would, so the graphics timeline keeps increasing
+    uint64_t serial = ++m_frameSerial;
     func(*cmdBuffer.getCommandBuffer());
 
     cmdBuffer.stopRecording();
 
+    VkSemaphore timeline = m_frameTimeline->getSemaphore();
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &serial;
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
     submitInfo.waitSemaphoreCount = 0;
     submitInfo.pWaitSemaphores = nullptr;
     submitInfo.pWaitDstStageMask = nullptr;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = cmdBuffer.getCommandBuffer();
-    submitInfo.signalSemaphoreCount = 0;
-    submitInfo.pSignalSemaphores = nullptr;
-
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timeline;
 
-    VK_CALL(vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE), "Failed to submit command buffer!");
-    VK_CALL(vkQueueWaitIdle(m_device->getGraphicsQueue()), "Failed to wait for graphics queue during single time command!");
+    {
+        std::lock_guard<std::mutex> lock(m_device->getQueueMutex());
+        VK_CALL(vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE), "Failed to submit command buffer!");
+    }
+    m_frameTimeline->wait(serial);
 }
 
 void WYVKRenderer::beginFrameRecording(uint32_t currentFrame, uint32_t currentImage)
 {
+    m_frameRecording = true;
     WYVKCommandBuffer* cmdBuffer = m_frameContexts[currentFrame].commandBuffer.get();
     cmdBuffer->reset();
     cmdBuffer->startRecording(0);
+    m_framePacer->beginGpuFrame(*cmdBuffer->getCommandBuffer(), currentFrame);
+
+    // The frame that last used this context has been waited on, so every secondary recorded for it last time can be recycled at once
+    m_frameCommandPools->resetFrame(currentFrame);
+    m_frameContexts[currentFrame].objectArena->reset();
+    m_frameContexts[currentFrame].instanceArena->reset();
+    if (m_frameContexts[currentFrame].objectStorage) {
+        m_frameContexts[currentFrame].objectStorage->reset();
+    }
+
+    // Uploads have to be recorded before the render pass begins. They are batched into one copy per destination buffer
+    FrameContext& context = m_frameContexts[currentFrame];
+    context.frameSerial = ++m_frameSerial;
+
+    // Resolved once per frame, so recording threads never touch the registry
+    m_activePipeline = m_graphicsPipeline.get();
+    if (m_useBindless) {
+        if (m_bindlessPipeline->isReady()) {
+            m_activePipeline = m_bindlessPipeline.get();
+        }
+    }
+    else if (m_pipelineVariant.state != WYVKGraphicsPipeline::PipelineState() || !m_pipelineVariant.specializationConstants.empty()) {
+        WYVKGraphicsPipeline& variant = m_pipelineRegistry->getPipeline(m_pipelineVariant, m_frameSerial);
+        if (variant.isReady()) {
+            m_activePipeline = &variant;
+        }
+    }
+
+    writeFrameDescriptors(currentFrame);
+
+    // Kick off any async uploads queued since last frame and take ownership of the ones already submitted
+    m_uploadService->submit();
+    context.uploadWaitValue = m_uploadService->recordAcquireBarriers(*cmdBuffer->getCommandBuffer(), context.uploadWaitStages);
+
+    // The graph is only recorded in endFrameRecording(), but it has to be compiled now so secondaries can inherit the scene pass
+    declareRenderGraph(currentFrame, currentImage);
+    m_renderGraph->compile(m_frameSerial);
+    context.framebuffer = m_renderGraph->getFramebuffer(m_scenePass);
+    for (std::vector<VkCommandBuffer>& secondaries : context.secondaries) {
+        secondaries.clear();
+    }
+}
+
+void WYVKRenderer::declareRenderGraph(uint32_t currentFrame, uint32_t currentImage)
+{
+    m_renderGraph->reset(m_swapchain->getExtent());
+
+    // Acquired through imageAvailableSemaphore, which the submit waits on at the color attachment output stage.
+    // Headless, the image is left ready for the readback copy instead of presenting
+    WYVKRenderGraph::ImageDesc backbufferDesc;
+    backbufferDesc.format = m_swapchain->getImageFormat();
+    backbufferDesc.clearValue = clearValues[0];
+    VkImageLayout backbufferLayout = isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    WYVKRenderGraph::ResourceId backbuffer = m_renderGraph->importImage("Backbuffer", backbufferDesc, m_swapchain->getImages()[currentImage],
+        m_swapchain->getImageViews()[currentImage], VK_IMAGE_LAYOUT_UNDEFINED, backbufferLayout, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+    WYVKRenderGraph::ImageDesc depthDesc;
+    depthDesc.format = m_renderPass->getDepthFormat();
+    depthDesc.aspect = VK_IMAGE_ASPECT_DEPTH_BIT | (WYVKImage::hasStencilComponent(depthDesc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+    depthDesc.clearValue = clearValues[1];
+    WYVKRenderGraph::ResourceId depth = m_renderGraph->createImage("Depth", depthDesc);
+
+    auto executeSecondaries = [this, currentFrame](VkCommandBuffer cmd, FramePass pass) {
+        std::vector<VkCommandBuffer>& secondaries = m_frameContexts[currentFrame].secondaries[static_cast<uint32_t>(pass)];
+        if (!secondaries.empty()) {
+            vkCmdExecuteCommands(cmd, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        }
+    };
+    bool dynamicRendering = m_renderGraph->isDynamicRendering();
+
+    // Same attachments as m_renderPass, so the pipelines created against it can be used in this pass
+    m_scenePass = m_renderGraph->addPass("Scene", [&](WYVKRenderGraph::PassBuilder& pass) {
+        pass.write(backbuffer, WYVKRenderGraph::Access::COLOR_ATTACHMENT);
+        pass.write(depth, WYVKRenderGraph::Access::DEPTH_ATTACHMENT);
+        pass.useSecondaryCommandBuffers();
+    }, [executeSecondaries, dynamicRendering](VkCommandBuffer cmd) {
+        executeSecondaries(cmd, FramePass::SCENE);
+        if (!dynamicRendering) {
+            executeSecondaries(cmd, FramePass::OVERLAY);
+        }
+    });
+
+    // ImGui's dynamic rendering pipeline only knows the color format, and a pipeline has to match every attachment of the pass it draws in
+    if (dynamicRendering) {
+        m_renderGraph->addPass("Overlay", [&](WYVKRenderGraph::PassBuilder& pass) {
+            pass.write(backbuffer, WYVKRenderGraph::Access::COLOR_ATTACHMENT);
+            pass.useSecondaryCommandBuffers();
+        }, [executeSecondaries](VkCommandBuffer cmd) {
+            executeSecondaries(cmd, FramePass::OVERLAY);
+        });
+    }
+
+    // The graph puts the barrier between the last color write and the copy
+    if (isHeadless()) {
+        VkImage image = m_swapchain->getImages()[currentImage];
+        uint64_t frameSerial = m_frameSerial;
+        m_renderGraph->addPass("Readback", [&](WYVKRenderGraph::PassBuilder& pass) {
+            pass.read(backbuffer, WYVKRenderGraph::Access::TRANSFER_SRC);
+            pass.setSideEffects();
+        }, [this, image, frameSerial](VkCommandBuffer cmd) {
+            m_readbackRing->record(cmd, image, frameSerial);
+        });
+    }
+}
+
+WYVKCommandBuffer& WYVKRenderer::beginSecondaryRecording(uint32_t currentFrame, uint32_t slot, FramePass pass)
+{
+    WYVKCommandBuffer& cmdBuffer = m_frameCommandPools->acquireSecondary(currentFrame, slot);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = m_renderGraph->getRenderPass(m_scenePass);
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = m_frameContexts[currentFrame].framebuffer;
+
+    // Without a render pass the secondary inherits the attachment formats instead
+    VkFormat colorFormat = m_renderPass->getColorFormat();
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    if (m_renderPass->isDynamicRendering()) {
+        renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachmentFormats = &colorFormat;
+        if (pass == FramePass::SCENE) {
+            renderingInfo.depthAttachmentFormat = m_renderPass->getDepthFormat();
+            renderingInfo.stencilAttachmentFormat = m_renderPass->getStencilFormat();
+        }
+        renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        inheritanceInfo.pNext = &renderingInfo;
+    }
+
+    cmdBuffer.startRecording(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, inheritanceInfo);
+    return cmdBuffer;
+}
+
+void WYVKRenderer::endSecondaryRecording(WYVKCommandBuffer& cmdBuffer)
+{
+    cmdBuffer.stopRecording();
+}
+
+std::vector<VkCommandBuffer> WYVKRenderer::recordParallel(uint32_t currentFrame, ThreadPool& threadPool, uint32_t itemCount,
+    const std::function<void(VkCommandBuffer cmd, uint32_t begin, uint32_t end)>& recordChunk)
+{
+    // Below this many items the cost of waking up workers is higher than recording everything on one thread
+    static constexpr uint32_t MIN_ITEMS_PER_CHUNK = 256;
+
+    // Nothing to draw with until the async pipeline build is done
+    if (!m_graphicsPipeline->isReady()) {
+        return {};
+    }
 
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = m_renderPass->getRenderPass();
-    renderPassInfo.framebuffer = m_renderPass->getFrameBuffers()[currentImage];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = m_swapchain->getExtent();
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
-    vkCmdBeginRenderPass(*cmdBuffer->getCommandBuffer(), &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    auto recordRange = [&](uint32_t slot, uint32_t begin, uint32_t end) {
+        WYVKCommandBuffer& cmdBuffer = beginSecondaryRecording(currentFrame, slot);
+        VkCommandBuffer cmd = *cmdBuffer.getCommandBuffer();
+        setupGraphicsPipeline(cmd);
+        bindPipeline(cmd);
+        bindDescriptorSets(cmd, currentFrame);
+        if (isBindlessFrame()) {
+            m_bindlessSet->bind(cmd, m_bindlessPipeline->getPipelineLayout());
+        }
+        bindGeometryArena(cmd);
+        recordChunk(cmd, begin, end);
+        endSecondaryRecording(cmdBuffer);
+        return cmd;
+    };
+
+    uint32_t workerSlots = std::min(threadPool.getThreadCount(), getMainThreadSlot());
+    uint32_t chunkCount = std::min(workerSlots, itemCount / MIN_ITEMS_PER_CHUNK);
+    if (chunkCount <= 1) {
+        return { recordRange(getMainThreadSlot(), 0, itemCount) };
+    }
+
+    // Every chunk gets its own slot, so no two jobs ever touch the same command pool
+    uint32_t chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+    std::vector<std::future<VkCommandBuffer>> jobs;
+    jobs.reserve(chunkCount);
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+        uint32_t begin = chunk * chunkSize;
+        uint32_t end = std::min(begin + chunkSize, itemCount);
+        jobs.push_back(threadPool.submit([&recordRange, chunk, begin, end]() { return recordRange(chunk, begin, end); }));
+    }
 
+    std::vector<VkCommandBuffer> cmdBuffers;
+    cmdBuffers.reserve(chunkCount);
+    for (std::future<VkCommandBuffer>& job : jobs) {
+        cmdBuffers.push_back(job.get());
+    }
+    return cmdBuffers;
+}
+
+void WYVKRenderer::executeSecondaryCommandBuffers(uint32_t currentFrame, const std::vector<VkCommandBuffer>& cmdBuffers, FramePass pass)
+{
+    std::vector<VkCommandBuffer>& secondaries = m_frameContexts[currentFrame].secondaries[static_cast<uint32_t>(pass)];
+    secondaries.insert(secondaries.end(), cmdBuffers.begin(), cmdBuffers.end());
 }
 
 void WYVKRenderer::endFrameRecording(uint32_t currentFrame)
 {
     WYVKCommandBuffer* cmdBuffer = m_frameContexts[currentFrame].commandBuffer.get();
-    vkCmdEndRenderPass(*cmdBuffer->getCommandBuffer());
+    m_renderGraph->execute(*cmdBuffer->getCommandBuffer());
+    m_framePacer->endGpuFrame(*cmdBuffer->getCommandBuffer(), currentFrame);
     cmdBuffer->stopRecording();
 }
 
-void WYVKRenderer::setupGraphicsPipeline(uint32_t currentFrame)
+void WYVKRenderer::setupGraphicsPipeline(VkCommandBuffer cmd)
 {
     // Get swapchain extent
     VkExtent2D& extent = getSwapchain().getExtent();
@@ -201,13 +451,13 @@ void WYVKRenderer::setupGraphicsPipeline(uint32_t currentFrame)
     */
     viewport.y += abs(viewport.height);
 
-    vkCmdSetViewport(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), 0, 1, &viewport);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
 
     // Set dynamic scissor
     VkRect2D scissor{};
     scissor.offset = { 0, 0 };
     scissor.extent = extent;
-    vkCmdSetScissor(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), 0, 1, &scissor);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
 }
 
 void WYVKRenderer::createCommandBuffers()
@@ -225,103 +475,284 @@ void WYVKRenderer::recreateCommandBuffers()
     createCommandBuffers();
 }
 
-void WYVKRenderer::updateUniformBuffers(uint32_t currentImage, void* data, size_t size)
+void WYVKRenderer::updateUniformBuffers(uint32_t currentFrame, void* data, size_t size)
 {
-    memcpy(m_frameContexts[currentImage].cameraMVPBuffer->getPersistentMapping(), data, size);
+    memcpy(m_frameContexts[currentFrame].cameraBuffer->getPersistentMapping(), data, size);
 }
 
-void WYVKRenderer::bindDescriptorSets(uint32_t currentFrame)
+void WYVKRenderer::bindDescriptorSets(VkCommandBuffer cmd, uint32_t currentFrame, uint32_t objectOffset)
 {
-    VkDescriptorSet* ds = &m_frameContexts[currentFrame].descriptorSet->getDescriptorSet();
-    vkCmdBindDescriptorSets(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline->getPipelineLayout(), 0, 1, ds, 0, nullptr);
+    VkDescriptorSet* ds = &m_frameContexts[currentFrame].descriptorSet;
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline->getPipelineLayout(), 0, 1, ds, 1, &objectOffset);
 }
 
-void WYVKRenderer::bindPipeline(uint32_t currentFrame)
+void WYVKRenderer::bindObject(VkCommandBuffer cmd, uint32_t currentFrame, const glm::mat4& model)
 {
-    vkCmdBindPipeline(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline->getPipeline());
+    if (!isBindlessFrame()) {
+        bindDescriptorSets(cmd, currentFrame, pushObject(currentFrame, { model }));
+        return;
+    }
+
+    // Pushes are rounded up to the arena alignment, which is a power of two, so every offset is a multiple of sizeof(ObjectBuffer)
+    FrameContext& context = m_frameContexts[currentFrame];
+    ObjectBuffer object = { model };
+    uint32_t offset = context.objectStorage->push(&object, sizeof(ObjectBuffer));
+    DrawIndices indices = { context.objectStorageSlot, offset / static_cast<uint32_t>(sizeof(ObjectBuffer)) };
+    vkCmdPushConstants(cmd, m_bindlessPipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawIndices), &indices);
 }
 
-void WYVKRenderer::draw(uint32_t currentFrame, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+void WYVKRenderer::bindPipeline(VkCommandBuffer cmd)
 {
-    vkCmdDraw(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), vertexCount, instanceCount, firstVertex, firstInstance);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_activePipeline->getPipeline());
 }
 
-void WYVKRenderer::drawIndexed(uint32_t currentFrame, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+void WYVKRenderer::setPipelineVariant(const WYVKGraphicsPipeline::PipelineState& state, const std::vector<WYVKGraphicsPipeline::SpecializationConstant>& specializationConstants)
 {
-    vkCmdDrawIndexed(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    if (state.polygonMode != VK_POLYGON_MODE_FILL && !m_device->supportsFillModeNonSolid()) {
+        WYVERN_LOG_WARN("Device does not support non solid fill modes. Keeping the current pipeline variant");
+        return;
+    }
+    m_pipelineVariant.state = state;
+    m_pipelineVariant.specializationConstants = specializationConstants;
 }
 
-void WYVKRenderer::recreateSwapchain()
+void WYVKRenderer::draw(VkCommandBuffer cmd, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
 {
-    // Pause on window minimization
-    // When the window minimizes, the framebuffer size shrinks to 0 which is an invalid state
-    int width = 0;
-    int height = 0;
-    glfwGetFramebufferSize(m_window.getNativeWindow(), &width, &height);
-    while (width == 0 || height == 0) {
-        glfwGetFramebufferSize(m_window.getNativeWindow(), &width, &height);
-        glfwWaitEvents();
+    vkCmdDraw(cmd, vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void WYVKRenderer::drawIndexed(VkCommandBuffer cmd, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+    vkCmdDrawIndexed(cmd, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+}
+
+void WYVKRenderer::drawIndirect(VkCommandBuffer cmd, uint32_t currentFrame)
+{
+    if (!m_indirectPipeline->isReady()) {
+        return;
     }
+    setupGraphicsPipeline(cmd);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_indirectPipeline->getPipeline());
+    bindDescriptorSets(cmd, currentFrame); // Both pipelines are created from the same set layout, so their layouts are compatible
+    bindGeometryArena(cmd);
+    m_frameContexts[currentFrame].indirectBatch->record(cmd);
+}
 
-    vkDeviceWaitIdle(m_device->getLogicalDevice());
-    WYVERN_LOG_INFO("Recreating swapchain");
+void WYVKRenderer::drawInstanced(VkCommandBuffer cmd, uint32_t currentFrame, const Model& model, const InstanceData* instances, uint32_t instanceCount)
+{
+    if (instanceCount == 0 || !m_instancedPipeline->isReady()) {
+        return;
+    }
+    VkDeviceSize instanceOffset = m_frameContexts[currentFrame].instanceArena->push(instances, sizeof(InstanceData) * instanceCount);
 
+    setupGraphicsPipeline(cmd);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_instancedPipeline->getPipeline());
+    bindDescriptorSets(cmd, currentFrame);
+    bindGeometryArena(cmd);
+    vkCmdBindVertexBuffers(cmd, InstanceData::BINDING, 1, &m_frameContexts[currentFrame].instanceArena->getBuffer().getBuffer(), &instanceOffset);
 
+    vkCmdDrawIndexed(cmd, static_cast<uint32_t>(model.getIndexCount()), instanceCount, model.getFirstIndex(), model.getVertexOffset(), 0);
+}
 
-    // ==========================================
-    // DESTROY
-    // ==========================================
-    m_swapchain->destroy();                 // Destroy swapchain and image views
-    m_renderPass->destroyImageResources();  // destroy all image resources related to the renderpass such as depth and stencil images
-    m_renderPass->destroyFramebuffers();
+void WYVKRenderer::createPipeline(WYVKGraphicsPipeline& pipeline)
+{
+    pipeline.setPushConstantRanges(m_shaderReflection.pushConstants);
+    if (m_compilePool) {
+        pipeline.createGraphicsPipelineAsync(*m_compilePool, m_descriptorSetLayout->getLayout(), m_pipelineCache->getPipelineCache());
+    }
+    else {
+        pipeline.createGraphicsPipeline(m_descriptorSetLayout->getLayout(), m_pipelineCache->getPipelineCache());
+    }
+}
 
-    for (FrameContext& context : m_frameContexts) {    // Destroy all sync objects from frame contexts
-        destroySyncObjects(context);
+void WYVKRenderer::logPipelineTimings()
+{
+    std::vector<WYVKGraphicsPipeline*> pipelines = { m_graphicsPipeline.get(), m_indirectPipeline.get(), m_instancedPipeline.get() };
+    if (m_bindlessPipeline) {
+        pipelines.push_back(m_bindlessPipeline.get());
+    }
+    double compileMs = 0.0;
+    double creationMs = 0.0;
+    std::chrono::steady_clock::time_point lastReady = m_pipelineBuildStart;
+    for (WYVKGraphicsPipeline* pipeline : pipelines) {
+        if (!pipeline->isReady()) {
+            return;
+        }
+        compileMs += pipeline->getShaderCompileTimeMs();
+        creationMs += pipeline->getCreationTimeMs();
+        lastReady = std::max(lastReady, pipeline->getReadyTime());
     }
-    vkDestroyFence(m_device->getLogicalDevice(), m_transferFence, nullptr);    // Make sure to destroy the transfer fence too
-    // ==========================================
+    m_pipelineTimingsLogged = true;
 
+    // The serial total is what the same work costs on one thread. The difference to the wall time is what building in parallel saves
+    double wallMs = std::chrono::duration<double, std::milli>(lastReady - m_pipelineBuildStart).count();
+    WYVERN_LOG_INFO("{} graphics pipelines ready after {:.3f} ms ({}, {} pipeline cache)", pipelines.size(), wallMs,
+        m_compilePool ? "parallel" : "serial", m_pipelineCache->isWarm() ? "warm" : "cold");
+    WYVERN_LOG_INFO("    shaders: {:.3f} ms | pipeline creation: {:.3f} ms | serial total: {:.3f} ms", compileMs, creationMs, compileMs + creationMs);
+}
 
+void WYVKRenderer::updateShaderHotReload(uint64_t completedSerial)
+{
+    while (!m_retiredPipelines.empty() && m_retiredPipelines.front().frameSerial <= completedSerial) {
+        m_retiredPipelines.pop_front();
+    }
+    if (!m_shaderWatcher) {
+        return;
+    }
 
-    // ==========================================
-    // CREATE
-    // ==========================================
-    m_swapchain->createSwapchain(); // Create swapchain and images
-    m_swapchain->createImageViews(); // Create swapchain image views
-    m_renderPass->createImageResources(); // Create needed renderpass images and image views
-    m_renderPass->createFramebuffers(); // Recreate framebuffers based on the new image views
+    std::vector<std::unique_ptr<WYVKGraphicsPipeline>*> targets = { &m_graphicsPipeline, &m_indirectPipeline, &m_instancedPipeline };
+    if (m_bindlessPipeline) {
+        targets.push_back(&m_bindlessPipeline);
+    }
+    std::vector<std::filesystem::path> changedFiles = m_shaderWatcher->takeChangedFiles();
 
-    for (FrameContext& context : m_frameContexts) {    // Create all sync objects from frame contexts
-        createSyncObjects(context); 
+    // Registry variants are rebuilt the next time they are asked for
+    for (auto& pipeline : m_pipelineRegistry->invalidate(changedFiles)) {
+        m_retiredPipelines.push_back({ m_frameSerial, std::move(pipeline) });
     }
 
-    VkFenceCreateInfo fenceInfo{};    // Make sure to recreate the transfer fence. There's probably a better way to do this
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    VK_CALL(vkCreateFence(m_device->getLogicalDevice(), &fenceInfo, nullptr, &m_transferFence), "Unable to create transfer fence!");
-    // ==========================================
+    for (std::unique_ptr<WYVKGraphicsPipeline>* target : targets) {
+        WYVKGraphicsPipeline& current = **target;
+        bool affected = std::any_of(changedFiles.begin(), changedFiles.end(), [&](const std::filesystem::path& file) { return current.dependsOn(file); });
+        if (!affected) {
+            continue;
+        }
 
+        WYVERN_LOG_INFO("Shader change detected, rebuilding pipeline for {}", current.getVertexShaderPath().filename().string());
+        auto pipeline = std::make_unique<WYVKGraphicsPipeline>(*m_device, *m_swapchain, *m_renderPass,
+            current.getVertexShaderPath(), current.getFragmentShaderPath());
+        if (current.isVertexInputOverridden()) {
+            pipeline->setVertexInput(current.getVertexBindings(), current.getVertexAttributes());
+        }
+        pipeline->setInstanceInputLocation(current.getInstanceInputLocation());
+        pipeline->setState(current.getState());
+        pipeline->setSpecializationConstants(current.getSpecializationConstants());
+        pipeline->setPushConstantRanges(current.getPushConstantRanges());
+        pipeline->setAdditionalSetLayouts(current.getAdditionalSetLayouts());
+        std::shared_future<void> build = pipeline->createGraphicsPipelineAsync(*m_compilePool, m_descriptorSetLayout->getLayout(), m_pipelineCache->getPipelineCache());
+        m_pipelineRebuilds.push_back({ target, std::move(pipeline), std::move(build) });
+    }
+
+    for (auto it = m_pipelineRebuilds.begin(); it != m_pipelineRebuilds.end();) {
+        if (it->build.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        // A file saved twice in a row starts a second rebuild. Only the newest one of a pipeline may be swapped in
+        bool superseded = std::any_of(std::next(it), m_pipelineRebuilds.end(), [&](const PipelineRebuild& rebuild) { return rebuild.target == it->target; });
+        std::string name = it->pipeline->getVertexShaderPath().filename().string();
+        try {
+            it->build.get();
+            if (!superseded) {
+                // Frames up to m_frameSerial may still be executing with the old pipeline
+                m_retiredPipelines.push_back({ m_frameSerial, std::move(*it->target) });
+                *it->target = std::move(it->pipeline);
+                m_shaderErrors.erase(name);
+                WYVERN_LOG_INFO("Reloaded pipeline for {}", name);
+            }
+        }
+        catch (const std::exception& e) {
+            if (!superseded) {
+                m_shaderErrors[name] = e.what();
+                WYVERN_LOG_ERROR("Failed to reload pipeline for {}. Keeping the old one", name);
+            }
+        }
+        it = m_pipelineRebuilds.erase(it); // Failed or superseded builds are done, so destroying them does not wait
+    }
+}
+
+void WYVKRenderer::recreateSwapchain()
+{
+    // Offscreen images keep the size they were created with
+    if (isHeadless()) {
+        return;
+    }
+
+    // When the window minimizes, the framebuffer size shrinks to 0 which is an invalid swapchain extent.
+    // The application stops drawing while minimized, so this is retried by the first present after the window is restored
+    if (m_window.isMinimized()) {
+        m_window.setFramebufferResized(true);
+        return;
+    }
+
+    WYVERN_LOG_INFO("Recreating swapchain");
+
+    // Nothing waits here. The old swapchain is handed to the new one and destroyed with its image views once the frames
+    // submitted so far are done (see acquireNextSwapchainImage())
+    m_swapchain->recreate(m_frameSerial);
+
+    // Framebuffers reference the old image views. Everything else in the graph, like the depth image, is only rebuilt
+    // when the extent changed, which the graph sees in its declarations next frame
+    m_renderGraph->releaseFramebuffers(m_frameSerial);
+}
+
+void WYVKRenderer::setFramesInFlight(uint32_t framesInFlight)
+{
+    m_framesInFlight = std::clamp(framesInFlight, 1u, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT));
+}
+
+void WYVKRenderer::setPresentMode(VkPresentModeKHR presentMode)
+{
+    if (isHeadless() || presentMode == m_swapchain->getPreferredPresentMode()) {
+        return;
+    }
+    m_swapchain->setPreferredPresentMode(presentMode);
+    m_swapchainOutOfDate = true;
 }
 
 void WYVKRenderer::submitCommandBuffer(uint32_t currentFrame)
 {
+    FrameContext& context = m_frameContexts[currentFrame];
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &m_frameContexts[currentFrame].imageAvailableSemaphore;
-    submitInfo.pWaitDstStageMask = waitStages;
+    // The binary image semaphore ignores its value. The upload timeline semaphore is only waited on if this frame acquired async uploads
+    // Headless frames acquire nothing, so the image semaphore is skipped
+    VkSemaphore waitSemaphores[] = { context.imageAvailableSemaphore, m_uploadService->getTimelineSemaphore() };
+    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, context.uploadWaitStages };
+    uint64_t waitValues[] = { 0, context.uploadWaitValue };
+    uint32_t firstWait = isHeadless() ? 1 : 0;
+    uint32_t waitCount = (context.uploadWaitValue != 0 ? 2 : 1) - firstWait;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues + firstWait;
+
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = waitCount;
+    submitInfo.pWaitSemaphores = waitSemaphores + firstWait;
+    submitInfo.pWaitDstStageMask = waitStages + firstWait;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = m_frameContexts[currentFrame].commandBuffer->getCommandBuffer();
 
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &m_frameContexts[currentFrame].renderFinishedSemaphore;
+    // The binary semaphore is for presenting, the frame timeline gets this frame's serial for everything else
+    VkSemaphore signalSemaphores[] = { context.renderFinishedSemaphore, m_frameTimeline->getSemaphore() };
+    uint64_t signalValues[] = { 0, context.frameSerial };
+    uint32_t firstSignal = isHeadless() ? 1 : 0;
+    timelineInfo.signalSemaphoreValueCount = 2 - firstSignal;
+    timelineInfo.pSignalSemaphoreValues = signalValues + firstSignal;
 
-    VK_CALL(vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, m_frameContexts[currentFrame].inFlightFence), "Failed to submit command buffer!");
+    submitInfo.signalSemaphoreCount = 2 - firstSignal;
+    submitInfo.pSignalSemaphores = signalSemaphores + firstSignal;
+
+    {
+        std::lock_guard<std::mutex> lock(m_device->getQueueMutex());
+        VK_CALL(vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE), "Failed to submit command buffer!");
+    }
+    m_framePacer->frameSubmitted(context.frameSerial);
+    m_frameRecording = false;
 }
 
 void WYVKRenderer::present(uint32_t currentFrame, uint32_t imageIndex)
 {
+    // Nothing to present to. The readback recorded with the frame picks it up
+    if (isHeadless()) {
+        return;
+    }
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -334,10 +765,15 @@ void WYVKRenderer::present(uint32_t currentFrame, uint32_t imageIndex)
     presentInfo.pImageIndices = &imageIndex;
     presentInfo.pResults = nullptr; // Optional
 
-    VkResult result = vkQueuePresentKHR(m_device->getPresentQueue(), &presentInfo);
+    VkResult result;
+    {
+        std::lock_guard<std::mutex> lock(m_device->getQueueMutex());
+        result = vkQueuePresentKHR(m_device->getPresentQueue(), &presentInfo);
+    }
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.isFramebufferResized()) {
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.isFramebufferResized() || m_swapchainOutOfDate) {
         m_window.setFramebufferResized(false);
+        m_swapchainOutOfDate = false;
         recreateSwapchain();
     }
     else if (result != VK_SUCCESS) {
@@ -345,60 +781,207 @@ void WYVKRenderer::present(uint32_t currentFrame, uint32_t imageIndex)
     }
 }
 
-WYVKBuffer* WYVKRenderer::createVertexBuffer(void* data, const VkDeviceSize size)
+WYVKBuffer* WYVKRenderer::createVertexBuffer(void* data, const VkDeviceSize size, WYVKStagingRing::UploadTicket* ticket)
 {
     WYVERN_LOG_INFO("Creating vertex buffer of size {}", size);
 
-    WYVKBuffer* vertexBuffer = new WYVKBuffer(*m_device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    WYVKBuffer* vertexBuffer = new WYVKBuffer(*m_device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, WYVKMemoryPolicy::ResourceUsage::STATIC_GEOMETRY);
 
-    m_stagingBuffer->assignMemory(data);
-    m_stagingBuffer->copyTo(*vertexBuffer, size, *m_commandPool, m_transferFence);
+    // UMA/resizable BAR: the CPU can write straight into the final memory and the data is usable right away
+    WYVKStagingRing::UploadTicket upload;
+    if (vertexBuffer->needsStaging()) {
+        upload = m_uploadService->upload(data, size, vertexBuffer->getBuffer(), 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    }
+    else {
+        vertexBuffer->assignMemory(data);
+    }
+    if (ticket != nullptr) {
+        *ticket = upload;
+    }
 
     return vertexBuffer;
 }
 
-void WYVKRenderer::bindVertexBuffers(uint32_t currentFrame, uint32_t vertexBuffersCount, VkBuffer* buffers)
+void WYVKRenderer::bindVertexBuffers(VkCommandBuffer cmd, uint32_t vertexBuffersCount, VkBuffer* buffers)
 {
     VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), 0, vertexBuffersCount, buffers, offsets);
+    vkCmdBindVertexBuffers(cmd, 0, vertexBuffersCount, buffers, offsets);
 }
 
-WYVKBuffer* WYVKRenderer::createIndexBuffer(void* data, const VkDeviceSize size)
+WYVKBuffer* WYVKRenderer::createIndexBuffer(void* data, const VkDeviceSize size, WYVKStagingRing::UploadTicket* ticket)
 {
     WYVERN_LOG_INFO("Creating index buffer of size {}", size);
 
-    WYVKBuffer* indexBuffer = new WYVKBuffer(*m_device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    WYVKBuffer* indexBuffer = new WYVKBuffer(*m_device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, WYVKMemoryPolicy::ResourceUsage::STATIC_GEOMETRY);
 
-    m_stagingBuffer->assignMemory(data);
-    m_stagingBuffer->copyTo(*indexBuffer, size, *m_commandPool, m_transferFence);
+    WYVKStagingRing::UploadTicket upload;
+    if (indexBuffer->needsStaging()) {
+        upload = m_uploadService->upload(data, size, indexBuffer->getBuffer(), 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+    }
+    else {
+        indexBuffer->assignMemory(data);
+    }
+    if (ticket != nullptr) {
+        *ticket = upload;
+    }
 
     return indexBuffer;
 }
 
-void WYVKRenderer::bindIndexBuffer(uint32_t currentFrame, VkBuffer buffer, VkIndexType indexType)
+WYVKGeometryArena::MeshHandle WYVKRenderer::createMesh(const std::vector<Vertex>& vertices, const std::vector<WYVKGeometryArena::Index>& indices,
+    WYVKStagingRing::UploadTicket* ticket)
 {
-    vkCmdBindIndexBuffer(*m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(), buffer, 0, indexType);
+    if (m_frameRecording) {
+        WYVERN_LOG_ERROR("createMesh() called while a frame is being recorded");
+        WYVERN_THROW("createMesh() must not be called while a frame is being recorded!");
+    }
+
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    uint32_t indexCount = static_cast<uint32_t>(indices.size());
+
+    // Indices are relative to the mesh's vertexOffset, so the limit is per mesh
+    if (vertices.size() > MAX_MESH_VERTICES) {
+        WYVERN_LOG_ERROR("Mesh has {} vertices, {} bit indices can only address {}", vertices.size(), sizeof(WYVKGeometryArena::Index) * 8, MAX_MESH_VERTICES);
+        WYVERN_THROW("Mesh has too many vertices for the geometry arena's index type!");
+    }
+
+    WYVKGeometryArena::MeshHandle mesh = WYVKGeometryArena::INVALID_MESH;
+    if (!m_geometryArena->allocate(vertexCount, indexCount, mesh)) {
+        if (!m_geometryArena->canFit(vertexCount, indexCount)) {
+            WYVERN_LOG_ERROR("Geometry arena is out of space for a mesh of {} vertices and {} indices!", vertexCount, indexCount);
+            WYVERN_THROW("Geometry arena is out of space!");
+        }
+        defragmentGeometry();
+        if (!m_geometryArena->allocate(vertexCount, indexCount, mesh)) {
+            WYVERN_THROW("Unable to allocate mesh in the geometry arena after defragmenting!");
+        }
+    }
+
+    const WYVKGeometryArena::Mesh& range = m_geometryArena->getMesh(mesh);
+    VkDeviceSize vertexOffset = static_cast<VkDeviceSize>(range.vertexOffset) * sizeof(Vertex);
+    VkDeviceSize indexOffset = static_cast<VkDeviceSize>(range.firstIndex) * sizeof(WYVKGeometryArena::Index);
+    VkDeviceSize vertexSize = sizeof(Vertex) * vertices.size();
+    VkDeviceSize indexSize = sizeof(WYVKGeometryArena::Index) * indices.size();
+
+    // Both arena buffers come from the same placement, so they either both need staging or neither does
+    WYVKStagingRing::UploadTicket upload;
+    WYVKBuffer& vertexBuffer = m_geometryArena->getVertexBuffer();
+    WYVKBuffer& indexBuffer = m_geometryArena->getIndexBuffer();
+    if (vertexBuffer.needsStaging()) {
+        if (vertexSize > 0) {
+            upload = m_uploadService->upload(vertices.data(), vertexSize, vertexBuffer.getBuffer(), vertexOffset, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        }
+        if (indexSize > 0) {
+            upload = m_uploadService->upload(indices.data(), indexSize, indexBuffer.getBuffer(), indexOffset, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+        }
+    }
+    else {
+        memcpy(static_cast<char*>(vertexBuffer.getAllocation().mappedData) + vertexOffset, vertices.data(), (size_t) vertexSize);
+        memcpy(static_cast<char*>(indexBuffer.getAllocation().mappedData) + indexOffset, indices.data(), (size_t) indexSize);
+    }
+    if (ticket != nullptr) {
+        *ticket = upload;
+    }
+
+    return mesh;
+}
+
+void WYVKRenderer::destroyMesh(WYVKGeometryArena::MeshHandle mesh)
+{
+    // The last recorded frame may still read the mesh
+    m_geometryArena->release(mesh, m_frameSerial);
+}
+
+void WYVKRenderer::defragmentGeometry()
+{
+    // Waiting on m_frameSerial mid frame would wait on a serial that is only signaled once the frame is submitted
+    if (m_frameRecording) {
+        WYVERN_LOG_ERROR("defragmentGeometry() called while a frame is being recorded");
+        WYVERN_THROW("defragmentGeometry() must not be called while a frame is being recorded!");
+    }
+
+    // Both queues that touch the arena have to be done with it
+    m_frameTimeline->wait(m_frameSerial);
+    m_uploadService->waitIdle();
+
+    // Uploads that were released on the transfer queue have to be acquired before the arena can copy from them
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        VkPipelineStageFlags acquireStages = 0;
+        m_uploadService->recordAcquireBarriers(cmd, acquireStages);
+        m_geometryArena->defragment(cmd, m_frameSerial);
+    });
+    m_geometryArena->retire(m_frameSerial);
 }
 
-void WYVKRenderer::allocateStagingBuffer(VkDeviceSize size)
+void WYVKRenderer::bindIndexBuffer(VkCommandBuffer cmd, VkBuffer buffer, VkIndexType indexType)
 {
-    m_stagingBuffer = std::make_unique<WYVKBuffer>(*m_device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vkCmdBindIndexBuffer(cmd, buffer, 0, indexType);
+}
+
+WYVKShaderReflection::Reflection WYVKRenderer::reflectShaders()
+{
+    std::vector<std::pair<std::filesystem::path, VkShaderStageFlagBits>> shaders = {
+        { WYVKGraphicsPipeline::DEFAULT_VERTEX_SHADER, VK_SHADER_STAGE_VERTEX_BIT },
+        { INDIRECT_VERTEX_SHADER, VK_SHADER_STAGE_VERTEX_BIT },
+        { INSTANCED_VERTEX_SHADER, VK_SHADER_STAGE_VERTEX_BIT },
+        { WYVKGraphicsPipeline::DEFAULT_FRAGMENT_SHADER, VK_SHADER_STAGE_FRAGMENT_BIT },
+    };
+    // Its push constants end up in every pipeline layout, which keeps set 0 compatible between the bindless and the other pipelines
+    if (m_device->getBindlessSupport().supported) {
+        shaders.push_back({ BINDLESS_VERTEX_SHADER, VK_SHADER_STAGE_VERTEX_BIT });
+    }
+
+    // The compiled binaries land in the shader cache, so the pipelines created right after load them instead of compiling again
+    auto reflectShader = [this](std::filesystem::path path, VkShaderStageFlagBits stage) {
+        path = std::filesystem::absolute(path);
+        WYVKShader shader(*m_device, path, stage);
+        shader.compile();
+        return WYVKShaderReflection::reflect(shader.getCacheKey(), shader.getBinary());
+    };
+
+    std::vector<std::future<std::shared_ptr<const WYVKShaderReflection::Reflection>>> reflections;
+    for (const auto& shader : shaders) {
+        if (m_compilePool) {
+            reflections.push_back(m_compilePool->submit([reflectShader, shader]() { return reflectShader(shader.first, shader.second); }));
+        }
+        else {
+            std::promise<std::shared_ptr<const WYVKShaderReflection::Reflection>> result;
+            result.set_value(reflectShader(shader.first, shader.second));
+            reflections.push_back(result.get_future());
+        }
+    }
+
+    WYVKShaderReflection::Reflection merged;
+    for (auto& reflection : reflections) {
+        merged.merge(*reflection.get());
+    }
+    return merged;
 }
 
 void WYVKRenderer::createDescriptorSets()
 {
-    // Create descriptor pool of 10 descriptors and a max of 10 sets
-    m_descriptorPool = std::make_unique<WYVKDescriptorPool>(*m_device, 10, 10);
+    // Every renderer pipeline shares one set layout, so it is built from the bindings of all their shaders
+    m_shaderReflection = reflectShaders();
+    m_shaderReflection.makeDynamic(0, OBJECT_BUFFER_BINDING); // Object data is addressed with dynamic offsets
+
+    // Pools are sized from what one set of the reflected layout needs, and chained & reset per frame context
+    m_descriptorAllocator = std::make_unique<WYVKDescriptorAllocator>(*m_device, MAX_FRAMES_IN_FLIGHT, m_shaderReflection.getPoolSizes(1));
 
     // Create descriptor layout bindings and actual layout object
     m_descriptorSetLayout = std::make_unique<WYVKDescriptorLayout>(*m_device);
-    m_descriptorSetLayout->addBinding(0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    m_descriptorSetLayout->addBindings(m_shaderReflection);
     m_descriptorSetLayout->createLayout();
+
+    if (m_device->getBindlessSupport().supported) {
+        m_bindlessSet = std::make_unique<WYVKBindlessSet>(*m_device);
+    }
 }
 
 void WYVKRenderer::createRenderFrameContexts()
 {
-    m_frameContexts.resize(MAX_FRAMES_IN_FLIGHT + 1);
+    m_frameTimeline = std::make_unique<WYVKTimeline>(*m_device, "frame");
+    m_framePacer = std::make_unique<WYVKFramePacer>(*m_device, MAX_FRAMES_IN_FLIGHT);
+    m_frameContexts.resize(MAX_FRAMES_IN_FLIGHT);
 
     for (FrameContext& context : m_frameContexts) {
         createSyncObjects(context);
@@ -411,11 +994,53 @@ void WYVKRenderer::createRenderFrameContexts()
 */
 void WYVKRenderer::initDescriptors(FrameContext& context)
 {
-    context.cameraMVPBuffer = std::make_unique<WYVKBuffer>(*m_device, sizeof(CameraMVPBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    context.cameraMVPBuffer->createPersistentMapping();
+    context.cameraBuffer = std::make_unique<WYVKBuffer>(*m_device, sizeof(CameraBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, WYVKMemoryPolicy::ResourceUsage::DYNAMIC_UNIFORM);
+    context.cameraBuffer->createPersistentMapping();
+
+    // The descriptor set itself is allocated & written every frame in beginFrameRecording (see writeFrameDescriptors())
+    context.indirectBatch = std::make_unique<WYVKIndirectBatch>(*m_device);
+    context.objectArena = std::make_unique<WYVKFrameArena>(*m_device, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+    context.instanceArena = std::make_unique<WYVKFrameArena>(*m_device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, INSTANCE_ARENA_CAPACITY);
+
+    // The slot is registered once. Shaders index the buffer with DrawIndices::objectIndex instead of a dynamic offset
+    if (m_bindlessSet) {
+        context.objectStorage = std::make_unique<WYVKFrameArena>(*m_device, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        context.objectStorageSlot = m_bindlessSet->addStorageBuffer(context.objectStorage->getBuffer().getBuffer());
+    }
+}
+
+void WYVKRenderer::writeFrameDescriptors(uint32_t currentFrame)
+{
+    // The frame that last used this context was waited on, so none of its sets are in use anymore
+    m_descriptorAllocator->beginFrame(currentFrame);
+    m_frameContexts[currentFrame].descriptorSet = m_descriptorAllocator->getSet(currentFrame, m_descriptorSetLayout->getLayout(), getFrameBindings(currentFrame));
+}
 
-    context.descriptorSet = std::make_unique<WYVKDescriptorSet>(*m_device, *m_descriptorPool, *m_descriptorSetLayout);
-    context.descriptorSet->updateBinding(context.cameraMVPBuffer->getBuffer(), 0, sizeof(CameraMVPBuffer), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);  
+std::vector<WYVKDescriptorAllocator::Binding> WYVKRenderer::getFrameBindings(uint32_t currentFrame)
+{
+    FrameContext& context = m_frameContexts[currentFrame];
+
+    std::vector<WYVKDescriptorAllocator::Binding> bindings(3);
+    bindings[0].binding = 0;
+    bindings[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[0].bufferInfo = { context.cameraBuffer->getBuffer(), 0, sizeof(CameraBuffer) };
+
+    WYVKBuffer& drawDataBuffer = context.indirectBatch->getDrawDataBuffer();
+    bindings[1].binding = 1;
+    bindings[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].bufferInfo = { drawDataBuffer.getBuffer(), 0, drawDataBuffer.getSize() };
+
+    // The descriptor only covers one ObjectBuffer, which object is read is picked by the dynamic offset at bind time
+    bindings[2].binding = OBJECT_BUFFER_BINDING;
+    bindings[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[2].bufferInfo = { context.objectArena->getBuffer().getBuffer(), 0, sizeof(ObjectBuffer) };
+    return bindings;
+}
+
+std::vector<WYVKDescriptorBenchmark::Result> WYVKRenderer::benchmarkDescriptorUpdates(uint32_t setCount)
+{
+    return WYVKDescriptorBenchmark::run(*m_device, m_descriptorSetLayout->getLayout(), getFrameBindings(0), setCount);
 }
 
 void WYVKRenderer::createSyncObjects(FrameContext& context)
@@ -423,13 +1048,8 @@ void WYVKRenderer::createSyncObjects(FrameContext& context)
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Create fence in signaled state so the fence does not block indefinitely before the first frame
-
     if (vkCreateSemaphore(m_device->getLogicalDevice(), &semaphoreInfo, nullptr, &context.imageAvailableSemaphore) != VK_SUCCESS ||
-        vkCreateSemaphore(m_device->getLogicalDevice(), &semaphoreInfo, nullptr, &context.renderFinishedSemaphore) != VK_SUCCESS ||
-        vkCreateFence(m_device->getLogicalDevice(), &fenceInfo, nullptr, &context.inFlightFence) != VK_SUCCESS)
+        vkCreateSemaphore(m_device->getLogicalDevice(), &semaphoreInfo, nullptr, &context.renderFinishedSemaphore) != VK_SUCCESS)
     {
         WYVERN_LOG_ERROR("Failed to create synchronization objects for a frame!");
         throw std::runtime_error("Failed to create synchronization objects for a frame!");
@@ -440,7 +1060,6 @@ void WYVKRenderer::destroySyncObjects(FrameContext& context)
 {
     vkDestroySemaphore(m_device->getLogicalDevice(), context.imageAvailableSemaphore, nullptr);
     vkDestroySemaphore(m_device->getLogicalDevice(), context.renderFinishedSemaphore, nullptr);
-    vkDestroyFence(m_device->getLogicalDevice(), context.inFlightFence, nullptr);
 }
 
 }
\ No newline at end of file
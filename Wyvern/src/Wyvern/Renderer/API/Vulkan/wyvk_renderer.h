@@ -1,5 +1,9 @@
 #pragma once
-#include "Wyvern/core.h"
+#include <deque>
+#include <limits>
+#include <map>
+
+#include "Wyvern/Core.h"
 #include "CreateInfo/info.h"
 #include "Wyvern/window.h"
 
@@ -9,42 +13,115 @@
 #include "wyvk_instance.h"
 
 #include "Pipelines/wyvk_graphics_pipeline.h"
+#include "Pipelines/wyvk_pipeline_cache.h"
+#include "Pipelines/wyvk_pipeline_registry.h"
+#include "Pipelines/wyvk_shader_watcher.h"
 
 #include "Command/wyvk_commandpool.h"
 #include "Command/wyvk_commandbuffer.h"
+#include "Command/wyvk_frame_commandpools.h"
+#include "Command/wyvk_indirect_batch.h"
+
+#include "Descriptor/wyvk_descriptor_allocator.h"
+#include "Descriptor/wyvk_descriptor_benchmark.h"
+#include "Descriptor/wyvk_bindless_set.h"
 
-#include "Descriptor/wyvk_descriptorpool.h"
-#include "Descriptor/wyvk_descriptorset.h"
+#include "Geometry/wyvk_geometry_arena.h"
 
 #include "Memory/buffer.h"
+#include "Memory/wyvk_staging_ring.h"
+#include "Memory/wyvk_upload_service.h"
+#include "Memory/wyvk_frame_arena.h"
+#include "Memory/wyvk_readback_ring.h"
+
+#include "RenderGraph/wyvk_render_graph.h"
+
+#include "Sync/wyvk_timeline.h"
+#include "Sync/wyvk_frame_pacer.h"
+
+#include "Wyvern/Threading/thread_pool.h"
 
 namespace Wyvern {
 
+class Model;
+
 class WYVKRenderer
 {
 public:
 
-    struct CameraMVPBuffer {
-        glm::mat4 model;
+    // Per frame camera data (descriptor binding 0). viewProj is precomputed so shaders do one matrix multiply less per vertex
+    struct CameraBuffer {
         glm::mat4 view;
         glm::mat4 proj;
+        glm::mat4 viewProj;
     };
 
+    // Per object data pushed into the frame's object arena and read through a dynamic uniform offset (descriptor binding 2)
+    struct ObjectBuffer {
+        glm::mat4 model;
+    };
+
+    // Push constants of the bindless pipeline. Selects the object buffer in the bindless storage buffer array and the object inside it
+    struct DrawIndices {
+        uint32_t objectBuffer;
+        uint32_t objectIndex;
+    };
+
+    // Render graph pass a secondary command buffer is recorded for
+    enum class FramePass : uint32_t {
+        SCENE = 0,  // Color & depth
+        OVERLAY,    // Color only, drawn on top of the scene (ImGui). Part of the scene pass when dynamic rendering is off
+    };
+    static constexpr uint32_t FRAME_PASS_COUNT = 2;
+
     struct FrameContext {
-        VkFence inFlightFence;                  // Flags once the commandBuffer has finished rendering the current frame
+        // Binary semaphores, since presentation can't use timelines. Everything else waits on the frame timeline with frameSerial
         VkSemaphore imageAvailableSemaphore;   // Flags when a valid image is gathered from the swapchain
         VkSemaphore renderFinishedSemaphore;   // Flags once the GPU finishes rendering the current frame
 
         std::unique_ptr<WYVKCommandBuffer> commandBuffer;
-        std::unique_ptr<WYVKDescriptorSet> descriptorSet = nullptr;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;    // Framebuffer of the render graph's scene pass. Inherited by secondary command buffers
+        // Executed inside their pass when the render graph runs in endFrameRecording(). Indexed by FramePass
+        std::array<std::vector<VkCommandBuffer>, FRAME_PASS_COUNT> secondaries;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;  // Allocated from m_descriptorAllocator in beginFrameRecording. Only valid for that frame
 
         // Uniforms/descriptor buffers
-        std::unique_ptr<WYVKBuffer> cameraMVPBuffer;
+        std::unique_ptr<WYVKBuffer> cameraBuffer;
+        std::unique_ptr<WYVKFrameArena> objectArena;
+        // Object data of the bindless path, registered in the bindless set at objectStorageSlot. Only there if bindless is supported
+        std::unique_ptr<WYVKFrameArena> objectStorage;
+        uint32_t objectStorageSlot = WYVKSlotAllocator::INVALID_SLOT;
+
+        // Per instance data streamed by drawInstanced() (vertex binding 1)
+        std::unique_ptr<WYVKFrameArena> instanceArena;
+
+        // Indirect draw commands & per draw data (descriptor binding 1) built for this frame
+        std::unique_ptr<WYVKIndirectBatch> indirectBatch;
+
+        uint64_t frameSerial = 0;               // Serial of the last frame submitted with this context. The context is free once the frame timeline reaches it
+
+        // Async upload timeline value (and stages) this frame has to wait on before using data uploaded on the transfer queue
+        uint64_t uploadWaitValue = 0;
+        VkPipelineStageFlags uploadWaitStages = 0;
     };
 
     // "In-Flight" meaning currently being rendered/prepared.
-    // Since we are using the mailbox/triple buffering method for rendering we will have at most 2 frames in flight
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
+    // MAX_FRAMES_IN_FLIGHT frame contexts are created, setFramesInFlight() decides how many of them the frame loop cycles through
+    static const int MAX_FRAMES_IN_FLIGHT = 3;
+    static const int DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+    // Room for 100k InstanceData per frame
+    static constexpr VkDeviceSize INSTANCE_ARENA_CAPACITY = 8ull * 1024 * 1024;
+
+    static constexpr const char* INDIRECT_VERTEX_SHADER = "src/Wyvern/Assets/Shaders/vertex_indirect.vert";
+    static constexpr const char* INSTANCED_VERTEX_SHADER = "src/Wyvern/Assets/Shaders/vertex_instanced.vert";
+    static constexpr const char* BINDLESS_VERTEX_SHADER = "src/Wyvern/Assets/Shaders/vertex_bindless.vert";
+    // First vertex shader input of the instanced pipeline that is read per instance (see InstanceData)
+    static constexpr uint32_t INSTANCE_INPUT_LOCATION = 2;
+    // ObjectBuffer binding. Reflection cannot tell it is a dynamic uniform buffer, so it is marked by hand
+    static constexpr uint32_t OBJECT_BUFFER_BINDING = 2;
+    // Pipeline variants not used for this many frames are evicted from the registry (~10 seconds at 60 FPS)
+    static constexpr uint64_t PIPELINE_EVICTION_FRAMES = 600;
 
     const std::array<VkClearValue, 2> clearValues = { {
         {0.729f, 0.988f, 1.0f, 1.0f}, // Clear value for color attachment (red, green, blue, alpha)
@@ -55,7 +132,14 @@ public:
 
 
 
-    WYVKRenderer(Window& window);
+    /*
+    * `recordingSlots` is the number of threads that can record secondary command buffers in parallel during a frame.
+    * The last slot is reserved for the thread that owns the frame (see getMainThreadSlot())
+    * With a `compilePool`, shaders & pipelines are built on its workers and the constructor returns before they are ready.
+    * Until then the draws using a pipeline record nothing. The pool must outlive the renderer.
+    * With `allowDynamicRendering` frames are drawn with vkCmdBeginRendering on devices that support it, otherwise render passes are used
+    */
+    WYVKRenderer(Window& window, uint32_t recordingSlots = 1, ThreadPool* compilePool = nullptr, bool allowDynamicRendering = true);
     ~WYVKRenderer();
 
     /*
@@ -75,22 +159,45 @@ public:
     void initRaytracing();
 
     /*
-    * Waits for previous frame to finish via fences & prepares the next swapchain image for rendering.
+    * Waits on the frame timeline for the previous frame of this context to finish, retires everything the GPU is done with
+    * & prepares the next swapchain image for rendering.
     * This function returns a boolean value indicating whether the swapchain needs to be recreated. If the swapchain needs to
-    * be recreated, this function will return false.
+    * be recreated, this function will return false. A resized window is only picked up by present()
     */
     [[nodiscard]] bool acquireNextSwapchainImage(uint32_t currentFrame, uint32_t& currentImage);
 
-    // Submits a command to the command buffer immediately
+    // Submits a command to the command buffer immediately and waits for it on the frame timeline. It takes the next frame serial (m_frameSerial while `func` runs)
     void immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& func); // rvalue ref to accept lambdas
 
     /*
-    * Resets the command buffer at index `currentFrame`, starts recording, and begins the render pass
+    * Resets the command buffer at index `currentFrame`, starts recording, and declares & compiles the frame's render graph.
+    * The scene pass contents are recorded into secondary command buffers (see beginSecondaryRecording() and recordParallel())
     */
     void beginFrameRecording(uint32_t currentFrame, uint32_t currentImage);
 
     /*
-    * Stops the command buffer at index `currentFrame`, and stops the render pass
+    * Returns a secondary command buffer from the pool of `slot` that continues the render graph's `pass`.
+    * Nothing is inherited besides the render pass, so viewport/scissor, pipeline and descriptor sets must be set again.
+    * A slot must only be used by one thread at a time.
+    */
+    WYVKCommandBuffer& beginSecondaryRecording(uint32_t currentFrame, uint32_t slot, FramePass pass = FramePass::SCENE);
+    void endSecondaryRecording(WYVKCommandBuffer& cmdBuffer);
+
+    /*
+    * Splits the range [0, itemCount) into chunks and records each chunk into its own secondary command buffer on the thread pool.
+    * Every secondary already has the viewport/scissor set and the pipeline & descriptor sets bound when `recordChunk(cmd, begin, end)` is called.
+    * Blocks until all chunks are recorded and returns the secondaries in chunk order. Small ranges are recorded on the calling thread.
+    */
+    std::vector<VkCommandBuffer> recordParallel(uint32_t currentFrame, ThreadPool& threadPool, uint32_t itemCount,
+        const std::function<void(VkCommandBuffer cmd, uint32_t begin, uint32_t end)>& recordChunk);
+
+    /*
+    * Queues the given secondary command buffers to be executed inside `pass`, in order. Must match the pass they were begun for
+    */
+    void executeSecondaryCommandBuffers(uint32_t currentFrame, const std::vector<VkCommandBuffer>& cmdBuffers, FramePass pass = FramePass::SCENE);
+
+    /*
+    * Records the render graph (barriers, scene & overlay passes with the queued secondaries) and stops the command buffer at index `currentFrame`
     */
     void endFrameRecording(uint32_t currentFrame);
 
@@ -98,12 +205,27 @@ public:
     * Creates and updates all required pipeline states and infos.
     * Currently just gets the current swapchain extent and sets up/updates the dynamic viewport and scissor states
     */
-    void setupGraphicsPipeline(uint32_t currentImage);
+    void setupGraphicsPipeline(VkCommandBuffer cmd);
+    inline void setupGraphicsPipeline(uint32_t currentFrame) { setupGraphicsPipeline(getPrimaryCommandBuffer(currentFrame)); }
     
     /*
     * Binds the graphics pipeline to the command buffer specified by currentFrame for use in subsequent drawing commands.
     */
-    void bindPipeline(uint32_t currentFrame);
+    void bindPipeline(VkCommandBuffer cmd);
+    inline void bindPipeline(uint32_t currentFrame) { bindPipeline(getPrimaryCommandBuffer(currentFrame)); }
+
+    /*
+    * Picks the variant of the graphics pipeline bindPipeline() binds, starting with the next frame. Variants come from the pipeline registry
+    * and are built on first use, until then the default pipeline is bound. The default state without constants selects the default pipeline
+    */
+    void setPipelineVariant(const WYVKGraphicsPipeline::PipelineState& state, const std::vector<WYVKGraphicsPipeline::SpecializationConstant>& specializationConstants = {});
+    inline WYVKPipelineRegistry& getPipelineRegistry() { return *m_pipelineRegistry; }
+    inline WYVKDescriptorAllocator& getDescriptorAllocator() { return *m_descriptorAllocator; }
+
+    /*
+    * Writes the frame's set 0 bindings into `setCount` throwaway sets per binding, batched & templated (see WYVKDescriptorBenchmark)
+    */
+    std::vector<WYVKDescriptorBenchmark::Result> benchmarkDescriptorUpdates(uint32_t setCount = 1000);
 
     /*
     * Issues a command to draw primitives directly from the currently bound vertex buffer.
@@ -111,7 +233,10 @@ public:
     * indices. The primitives are drawn `instanceCount` times starting with `firstInstance` and increasing sequentially for each instance. 
     * The assembled primitives execute the bound graphics pipeline.
     */
-    void draw(uint32_t currentFrame, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+    void draw(VkCommandBuffer cmd, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+    inline void draw(uint32_t currentFrame, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+        draw(getPrimaryCommandBuffer(currentFrame), vertexCount, instanceCount, firstVertex, firstInstance);
+    }
     
     /*
     * Issues a command to draw primitives from the currently bound vertex buffer using the currently bound index buffer.
@@ -119,19 +244,41 @@ public:
     * whose indices are retrieved from the index buffer. The index buffer is treated as an array of tightly packed unsigned integers of size defined 
     * by the `indexType` parameter with which the buffer was bound. See `BindvertexBuffers()` for more info.
     */
-    void drawIndexed(uint32_t currentFrame, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+    void drawIndexed(VkCommandBuffer cmd, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+    inline void drawIndexed(uint32_t currentFrame, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+        drawIndexed(getPrimaryCommandBuffer(currentFrame), indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    }
+
+    /*
+    * Records every draw added to the frame's indirect batch (see getIndirectBatch()) with the indirect pipeline.
+    * Sets the viewport/scissor and binds the indirect pipeline & descriptor sets, so `cmd` can be a fresh secondary command buffer.
+    */
+    void drawIndirect(VkCommandBuffer cmd, uint32_t currentFrame);
+
+    /*
+    * Draws `instanceCount` copies of `model` in a single draw call. The instances are copied into the frame's instance arena
+    * and read through the instanced pipeline's second vertex binding, which advances once per instance.
+    * Sets the viewport/scissor and binds the instanced pipeline, descriptor sets & geometry arena, so `cmd` can be a fresh secondary command buffer.
+    * Thread safe as long as every thread records into its own command buffer.
+    */
+    void drawInstanced(VkCommandBuffer cmd, uint32_t currentFrame, const Model& model, const InstanceData* instances, uint32_t instanceCount);
+    inline void drawInstanced(VkCommandBuffer cmd, uint32_t currentFrame, const Model& model, const std::vector<InstanceData>& instances) {
+        drawInstanced(cmd, currentFrame, model, instances.data(), static_cast<uint32_t>(instances.size()));
+    }
 
     /*
     * While rendering, if the window we are drawing to gets resized or minimized, or the swapchain is underperforming, we will need
-    * to recreate the swapchain. This function destroys all swapchain image views and framebuffers and also destroys all synchronization objects related to it
-    * such as the in flight fences and image semaphores. Once all objects are cleaned up, the swapchain and all synchronization objects are recreated
+    * to recreate the swapchain. The new swapchain takes over from the old one (oldSwapchain) without waiting on the GPU. The old swapchain,
+    * its image views and the framebuffers built for them are destroyed once the frames using them retire. The depth image is only recreated
+    * if the extent changed. Sync objects are kept as they are. Does nothing while the window is minimized
     */
     void recreateSwapchain();
 
     /*
     * Submits the given frame's command buffer to the graphics queue for execution.
     * For synchronization purposes, the command buffer waits on the m_imageAvailableSemaphores flagged by the swapchain when
-    * an image is requested. Once the command buffer completes, it flags the m_renderFinishedSemaphores.
+    * an image is requested. Once the command buffer completes, it flags the m_renderFinishedSemaphores and signals the frame timeline
+    * with the frame's serial.
     */
     void submitCommandBuffer(uint32_t currentFrame);
 
@@ -143,16 +290,24 @@ public:
     void present(uint32_t currentFrame, uint32_t imageIndex);
 
     /*
-    * Allocates a staging buffer with the given size.
-    * The staging buffer is generally used to transfer data from the CPU to the GPU.
+    * Headless rendering (see Window). Created for a headless window: no surface, the swapchain's offscreen images are rendered to in
+    * frame context order and every frame is read back through the readback ring. Acquiring, submitting & presenting work the same
+    * from the outside, there are just no semaphores or presentation behind them
+    */
+    inline bool isHeadless() const { return m_swapchain->isOffscreen(); }
+    // nullptr unless headless
+    inline WYVKReadbackRing* getReadbackRing() { return m_readbackRing.get(); }
+
+    /*
+    * Returns true once the async upload identified by `ticket` (see createVertexBuffer/createIndexBuffer) has been executed by the GPU
     */
-    void allocateStagingBuffer(VkDeviceSize size);
+    inline bool isUploadComplete(WYVKStagingRing::UploadTicket ticket) { return m_uploadService->isComplete(ticket); }
 
     /*
-    * Creates a new vertex buffer with the given data and size.
-    * The data is copied into the buffer using a staging buffer.
+    * Creates a new vertex buffer with the given data and size. Memory placement comes from the device's memory policy: the data is either
+    * written directly (UMA/resizable BAR) or uploaded asynchronously on the transfer queue. If `ticket` is not null it receives the ticket for the upload.
     */
-    WYVKBuffer* createVertexBuffer(void* data, VkDeviceSize size);
+    WYVKBuffer* createVertexBuffer(void* data, VkDeviceSize size, WYVKStagingRing::UploadTicket* ticket = nullptr);
 
     /*
     * Binds the set of vertices you want to draw. vkCmdBindVertexBuffers can be confusing as it is plural, but this is
@@ -162,36 +317,126 @@ public:
     * you wanted to draw the world and the player model, you would have to bind the world vertices and draw, and then bind the player
     * model vertices then draw again.
     */
-    void bindVertexBuffers(uint32_t currentFrame, uint32_t vertexBuffersCount, VkBuffer* buffers);
+    void bindVertexBuffers(VkCommandBuffer cmd, uint32_t vertexBuffersCount, VkBuffer* buffers);
+    inline void bindVertexBuffers(uint32_t currentFrame, uint32_t vertexBuffersCount, VkBuffer* buffers) {
+        bindVertexBuffers(getPrimaryCommandBuffer(currentFrame), vertexBuffersCount, buffers);
+    }
+
+    /*
+    * Creates a new index buffer with the given data and size. Memory placement comes from the device's memory policy: the data is either
+    * written directly (UMA/resizable BAR) or uploaded asynchronously on the transfer queue. If `ticket` is not null it receives the ticket for the upload.
+    */
+    WYVKBuffer* createIndexBuffer(void* data, VkDeviceSize size, WYVKStagingRing::UploadTicket* ticket = nullptr);
+
+    // Meshes are indexed with WYVKGeometryArena::Index, so one mesh can't have more vertices than it can address
+    static constexpr size_t MAX_MESH_VERTICES = static_cast<size_t>(std::numeric_limits<WYVKGeometryArena::Index>::max()) + 1;
+
+    /*
+    * Allocates a mesh in the shared geometry arena and uploads its data, the same way createVertexBuffer() does.
+    * If the arena has enough free space that is too scattered, it is defragmented first. Must not be called while a frame is being recorded.
+    * Throws if the mesh has more than MAX_MESH_VERTICES vertices. If `ticket` is not null it receives the ticket of the last upload.
+    */
+    WYVKGeometryArena::MeshHandle createMesh(const std::vector<Vertex>& vertices, const std::vector<WYVKGeometryArena::Index>& indices,
+        WYVKStagingRing::UploadTicket* ticket = nullptr);
+
+    /*
+    * Frees the mesh once the frames that are currently in flight are done with it
+    */
+    void destroyMesh(WYVKGeometryArena::MeshHandle mesh);
+
+    /*
+    * Waits for the graphics & transfer queues to finish their submissions and compacts the geometry arena. Meshes keep their handles but get new offsets.
+    * Must not be called while a frame is being recorded.
+    */
+    void defragmentGeometry();
 
     /*
-    * Creates a new index buffer with the given data and size.
-    * The data is copied into the buffer using a staging buffer.
+    * Binds the geometry arena's vertex & index buffers. Every mesh can be drawn afterwards with its firstIndex/vertexOffset
     */
-    WYVKBuffer* createIndexBuffer(void* data, VkDeviceSize size);
+    inline void bindGeometryArena(VkCommandBuffer cmd) { m_geometryArena->bind(cmd); }
 
     /*
     * Binds the indices to draw. These indices should be mapped to the currently bound vertices.
     * The indexType represents the data type for each of the indices.
     */
-    void bindIndexBuffer(uint32_t currentFrame, VkBuffer buffer, VkIndexType indexType);
+    void bindIndexBuffer(VkCommandBuffer cmd, VkBuffer buffer, VkIndexType indexType);
+    inline void bindIndexBuffer(uint32_t currentFrame, VkBuffer buffer, VkIndexType indexType) {
+        bindIndexBuffer(getPrimaryCommandBuffer(currentFrame), buffer, indexType);
+    }
 
     /*
-    * Updates the data in the uniform buffers used in the rendering pipeline.
+    * Updates the data in the camera uniform buffer (CameraBuffer) used in the rendering pipeline.
     * This function should be called whenever the data used by the shaders changes, such as when the camera moves.
     * size is in bytes.
     */
-    void updateUniformBuffers(uint32_t currentImage, void* data, size_t size);
+    void updateUniformBuffers(uint32_t currentFrame, void* data, size_t size);
 
-    void bindDescriptorSets(uint32_t currentFrame);
+    /*
+    * Binds the frame's descriptor set. `objectOffset` is the dynamic offset of the ObjectBuffer to use (see pushObject())
+    */
+    void bindDescriptorSets(VkCommandBuffer cmd, uint32_t currentFrame, uint32_t objectOffset = 0);
+    inline void bindDescriptorSets(uint32_t currentFrame) { bindDescriptorSets(getPrimaryCommandBuffer(currentFrame), currentFrame); }
+
+    /*
+    * Copies `object` into the frame's object arena and returns its dynamic offset. Thread safe
+    */
+    inline uint32_t pushObject(uint32_t currentFrame, const ObjectBuffer& object) {
+        return m_frameContexts[currentFrame].objectArena->push(&object, sizeof(ObjectBuffer));
+    }
+
+    /*
+    * Makes the following draws use `model`. On the bindless path the transform goes into the frame's object storage and only its index
+    * is pushed as a push constant. Otherwise it is pushed into the object arena and the descriptor set is rebound at its dynamic offset
+    */
+    void bindObject(VkCommandBuffer cmd, uint32_t currentFrame, const glm::mat4& model);
+
+    /*
+    * Draws per model objects through the bindless set instead of rebinding descriptor sets per object, starting with the next frame.
+    * Ignored on devices without descriptor indexing. While bindless is on, pipeline variants (see setPipelineVariant()) are not used
+    */
+    inline void setBindless(bool enabled) { m_useBindless = enabled && m_bindlessSet; }
+    inline bool isBindlessSupported() const { return m_bindlessSet != nullptr; }
+    // True if the frame being recorded uses the bindless pipeline
+    inline bool isBindlessFrame() const { return m_bindlessPipeline && m_activePipeline == m_bindlessPipeline.get(); }
+    inline WYVKBindlessSet* getBindlessSet() { return m_bindlessSet.get(); }
 
     // Getters & Setters
     inline WYVKInstance& getInstance() { return *m_instance; }
     inline WYVKDevice& getDevice() { return *m_device; }
     inline WYVKSwapchain& getSwapchain() { return *m_swapchain; }
     inline WYVKRenderPass& getRenderPass() { return *m_renderPass; }
+    inline WYVKRenderGraph& getRenderGraph() { return *m_renderGraph; }
+    inline bool isDynamicRendering() const { return m_renderPass->isDynamicRendering(); }
     inline FrameContext& getFrameContext(uint32_t currentFrame) { return m_frameContexts[currentFrame]; }
+    inline WYVKTimeline& getFrameTimeline() { return *m_frameTimeline; }
+    // Serial of the last frame (or immediate submission) handed to the graphics queue. The frame timeline reaches it once that is done
+    inline uint64_t getFrameSerial() const { return m_frameSerial; }
+    inline WYVKGeometryArena& getGeometryArena() { return *m_geometryArena; }
+    inline WYVKIndirectBatch& getIndirectBatch(uint32_t currentFrame) { return *m_frameContexts[currentFrame].indirectBatch; }
     inline WYVKCommandPool& getCommandPool() { return *m_commandPool; }
+    inline VkCommandBuffer getPrimaryCommandBuffer(uint32_t currentFrame) { return *m_frameContexts[currentFrame].commandBuffer->getCommandBuffer(); }
+    inline uint32_t getMainThreadSlot() const { return m_frameCommandPools->getSlotCount() - 1; }
+
+    /*
+    * Blocks until the next frame should start, see WYVKFramePacer. Call it right before polling input
+    */
+    inline void paceFrame() { m_framePacer->waitForInput(*m_frameTimeline, m_frameSerial); }
+    inline WYVKFramePacer& getFramePacer() { return *m_framePacer; }
+
+    /*
+    * Number of frame contexts the frame loop cycles through (1 - MAX_FRAMES_IN_FLIGHT). Fewer frames in flight let the CPU
+    * get less far ahead of the GPU, which trades throughput for latency
+    */
+    void setFramesInFlight(uint32_t framesInFlight);
+    inline uint32_t getFramesInFlight() const { return m_framesInFlight; }
+
+    /*
+    * Present mode of the swapchain. The swapchain is recreated after the next present
+    */
+    void setPresentMode(VkPresentModeKHR presentMode);
+
+    // Compile errors of the last shader hot reload, keyed by the pipeline's vertex shader. Empty when everything compiles
+    inline const std::map<std::string, std::string>& getShaderErrors() const { return m_shaderErrors; }
 
 private:
 
@@ -225,7 +470,7 @@ private:
     //void createUniformBuffers();
 
     /*
-    * Creates synchronization objects for frame rendering. We create 2 semaphores and one fence for each frame context:
+    * Creates synchronization objects for frame rendering. We create 2 binary semaphores for each frame context:
     *
     * Image Available Semaphore: This semaphore signifies when an image is primed for the rendering process. During command buffer
     * submission to the device's graphics queue, it's crucial to ensure that the image is fully prepared for rendering. This semaphore
@@ -234,25 +479,35 @@ private:
     * Render Finished Semaphore: Following the completion of the rendering process, this semaphore signals that the image is ready to
     * be presented. It acts as an indicator confirming the safe transition of the image from the rendering stage to the presentation stage.
     *
-    * In-Flight Fence: After the rendering and presentation of a frame in a framebuffer, the CPU needs to be notified before it can start on the next frame in that same framebuffer.
-    * Since we are dispatching commands to the GPU, the CPU doesn't know when the frame will be completed since all of the GPU work is done asynchronously.
-    * A fence is used to block the CPU before we can begin rendering the next frame.
+    * There is no per frame fence. The CPU waits on the frame timeline (m_frameTimeline) for the context's frameSerial instead, and
+    * every other resource that is retired by frame serial keys off the same value.
     *
     */
     void createSyncObjects(FrameContext& context);
 
     /*
-    * Properly destroys all semaphores and fences in the render context
-    * Destroys all other fences and synchronization objects as well.
-    * 
-    * Use when recreating the sync objects, which is necessary for swapchain recreation
+    * Properly destroys the semaphores of the frame context. The GPU must be done with it
     */
     void destroySyncObjects(FrameContext& context);
 
     void initDescriptors(FrameContext& context);
 
+    /*
+    * Resets the frame's descriptor pools and allocates & writes its set 0 (camera, draw data & object arena)
+    */
+    void writeFrameDescriptors(uint32_t currentFrame);
+
+    // Camera, draw data & object arena bindings of the frame's set 0
+    std::vector<WYVKDescriptorAllocator::Binding> getFrameBindings(uint32_t currentFrame);
+
     void createRenderFrameContexts();
 
+    /*
+    * Declares the frame's render graph: the swapchain image & a transient depth image written by the scene pass,
+    * and with dynamic rendering an overlay pass on top of it
+    */
+    void declareRenderGraph(uint32_t currentFrame, uint32_t currentImage);
+
     /*
     * MUST be performed before running createRenderFrameContexts()
     * createRenderFrameContexts creates descriptors adn their bindings inside of the renderFrameContexts\
@@ -260,26 +515,88 @@ private:
     */
     void createDescriptorSets();
 
+    /*
+    * Compiles every shader the renderer's pipelines use (in parallel on the compile pool if there is one) and merges their reflections
+    */
+    WYVKShaderReflection::Reflection reflectShaders();
+
+    /*
+    * Builds `pipeline` on the compile pool if there is one, right away otherwise
+    */
+    void createPipeline(WYVKGraphicsPipeline& pipeline);
+
+    /*
+    * Logs the startup timing breakdown once every pipeline is ready. Does nothing before that
+    */
+    void logPipelineTimings();
+
+    /*
+    * Shader hot reload, called at the start of every frame once the frame timeline has been waited on.
+    * Destroys the pipelines replaced before `completedSerial`, starts rebuilding the pipelines whose shaders changed on disk
+    * and swaps in the rebuilds that are done. Never waits on a build
+    */
+    void updateShaderHotReload(uint64_t completedSerial);
+
     std::unique_ptr<WYVKInstance> m_instance;
     std::unique_ptr<WYVKDevice> m_device;
-    std::unique_ptr<WYVKSurface> m_surface;
+    std::unique_ptr<WYVKSurface> m_surface; // nullptr when headless
     std::unique_ptr<WYVKSwapchain> m_swapchain;
-    std::unique_ptr<WYVKRenderPass> m_renderPass; // might need multiple render passes and pipelines later on
+    std::unique_ptr<WYVKRenderPass> m_renderPass; // Render pass the pipelines are created against, compatible with the render graph's scene pass
+    std::unique_ptr<WYVKRenderGraph> m_renderGraph; // Declared every frame, only rebuilt when the declarations change
+    WYVKRenderGraph::PassId m_scenePass = WYVKRenderGraph::INVALID_ID;
+    std::unique_ptr<WYVKPipelineCache> m_pipelineCache; // Loaded from disk at startup, saved periodically and on shutdown
+    WYVKShaderReflection::Reflection m_shaderReflection; // Merged reflection of every renderer shader. The descriptor set layout & push constants come from it
     std::unique_ptr<WYVKGraphicsPipeline> m_graphicsPipeline;
+    std::unique_ptr<WYVKGraphicsPipeline> m_indirectPipeline; // Same layout as m_graphicsPipeline, reads per draw transforms from a storage buffer
+    std::unique_ptr<WYVKGraphicsPipeline> m_instancedPipeline; // Same layout as m_graphicsPipeline, reads per instance data from vertex binding 1
+    std::unique_ptr<WYVKGraphicsPipeline> m_bindlessPipeline; // Same set 0 as m_graphicsPipeline plus the bindless set. Null without descriptor indexing
+    bool m_useBindless = false;
+    std::unique_ptr<WYVKPipelineRegistry> m_pipelineRegistry; // Variants of the graphics pipeline (wireframe, specialized shaders...)
+    WYVKPipelineRegistry::PipelineKey m_pipelineVariant; // Selected with setPipelineVariant()
+    WYVKGraphicsPipeline* m_activePipeline = nullptr; // Pipeline bindPipeline() binds in the current frame. Resolved in beginFrameRecording()
+    ThreadPool* m_compilePool = nullptr; // Builds the pipelines in parallel at startup. Not owned
+    std::chrono::steady_clock::time_point m_pipelineBuildStart;
+    bool m_pipelineTimingsLogged = false;
+
+    // Shader hot reload. Only enabled with a compile pool, since rebuilding on the render thread would stall the frame loop
+    struct PipelineRebuild {
+        std::unique_ptr<WYVKGraphicsPipeline>* target;  // Pipeline member the rebuild replaces
+        std::unique_ptr<WYVKGraphicsPipeline> pipeline;
+        std::shared_future<void> build;
+    };
+    struct RetiredPipeline {
+        uint64_t frameSerial;                           // Last frame that could have used the pipeline
+        std::unique_ptr<WYVKGraphicsPipeline> pipeline;
+    };
+    std::unique_ptr<WYVKShaderWatcher> m_shaderWatcher;
+    std::vector<PipelineRebuild> m_pipelineRebuilds;
+    std::deque<RetiredPipeline> m_retiredPipelines;
+    std::map<std::string, std::string> m_shaderErrors;
     std::unique_ptr<WYVKCommandPool> m_commandPool;
+    std::unique_ptr<WYVKFrameCommandPools> m_frameCommandPools; // Per frame, per recording thread pools for secondary command buffers
 
     // RT
     VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_rtProps;
 
     
-    // Staging buffer used for vertex & index data transfer to appropriate buffers on GPU
-    // Transfer fence to signal once transfer operations are complete
-    std::unique_ptr<WYVKBuffer> m_stagingBuffer;
-    VkFence m_transferFence;
-
-    // Descriptor pool/layout
-    std::unique_ptr<WYVKDescriptorPool> m_descriptorPool;
+    // Increases by one for every frame recorded. Used to know when resources released by a frame can be reused
+    uint64_t m_frameSerial = 0;
+    bool m_frameRecording = false;          // Between beginFrameRecording() & submitCommandBuffer(). The frame's serial isn't submitted yet
+    // Graphics queue timeline. Every graphics submission signals it with its frame serial
+    std::unique_ptr<WYVKTimeline> m_frameTimeline;
+    std::unique_ptr<WYVKFramePacer> m_framePacer;
+    std::unique_ptr<WYVKReadbackRing> m_readbackRing; // Headless only. One slot per frame context
+    uint32_t m_framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    bool m_swapchainOutOfDate = false;      // Recreated after the next present, e.g. when the present mode changed
+    // Shared vertex & index buffers every mesh is sub-allocated from. Declared before the upload service so it outlives its uploads
+    std::unique_ptr<WYVKGeometryArena> m_geometryArena;
+    // Async uploads on the transfer queue (falls back to the graphics queue). Used for geometry so loading can overlap rendering
+    std::unique_ptr<WYVKUploadService> m_uploadService;
+
+    // Descriptor allocator/layout
+    std::unique_ptr<WYVKDescriptorAllocator> m_descriptorAllocator;
     std::unique_ptr<WYVKDescriptorLayout> m_descriptorSetLayout;
+    std::unique_ptr<WYVKBindlessSet> m_bindlessSet; // Null if the device has no descriptor indexing
 
     // Frame context. Holds all sync data, command buffers, descriptors etc... 
     // Essentially anything that has a per frame instance.
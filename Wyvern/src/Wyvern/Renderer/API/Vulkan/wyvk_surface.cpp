@@ -15,7 +15,7 @@ WYVKSurface::WYVKSurface(WYVKInstance& instance, WYVKDevice& device, Window& win
 	: m_instance(instance), m_device(device), m_window(window)
 {
 
-#ifdef USING_GLFW_SURFACE
+#if defined(USING_GLFW_SURFACE) || !defined(VK_USE_PLATFORM_WIN32_KHR)
 	// Support for multiple platforms
 	createGLFWSurface();
 #else
@@ -49,12 +49,14 @@ void WYVKSurface::createGLFWSurface()
 	VK_CALL(glfwCreateWindowSurface(m_instance.getInstance(), m_window.getNativeWindow(), nullptr, &m_surface), "Unable to create GLFW window surface!")
 }
 
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 void WYVKSurface::createWin32Surface()
 {
 	VkWin32SurfaceCreateInfoKHR createInfo{};
 	VKInfo::createWin32SurfaceInfo(createInfo, m_window.getNativeWindow());
 	VK_CALL(vkCreateWin32SurfaceKHR(m_instance.getInstance(), &createInfo, nullptr, &m_surface), "Unable to create Vulkan Win32 surface!");
 }
+#endif
 
 void WYVKSurface::querySupportDetails()
 {
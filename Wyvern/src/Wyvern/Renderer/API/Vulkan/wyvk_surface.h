@@ -1,5 +1,5 @@
 #pragma once
-#include "Wyvern/core.h"
+#include "Wyvern/Core.h"
 #include "Wyvern/Renderer/API/Vulkan/CreateInfo/info.h"
 #include "Wyvern/window.h"
 #include "wyvk_instance.h"
@@ -27,7 +27,9 @@ public:
 	~WYVKSurface();
 
 	void createGLFWSurface();
+#ifdef VK_USE_PLATFORM_WIN32_KHR
 	void createWin32Surface();
+#endif
 	void querySupportDetails(); // Queries and stores surface formats and present modes
 
 	inline VkSurfaceKHR getSurface() const { return m_surface; }
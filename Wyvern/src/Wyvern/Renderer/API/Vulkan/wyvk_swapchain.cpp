@@ -3,7 +3,7 @@
 
 namespace Wyvern {
 
-WYVKSwapchain::WYVKSwapchain(WYVKInstance& instance, WYVKDevice& device, WYVKSurface& surface, Window& window)
+WYVKSwapchain::WYVKSwapchain(WYVKInstance& instance, WYVKDevice& device, WYVKSurface* surface, Window& window)
 	: m_instance(instance),
 	m_surface(surface),
 	m_device(device),
@@ -19,21 +19,60 @@ WYVKSwapchain::~WYVKSwapchain()
 
 void WYVKSwapchain::destroy()
 {
+	retire(UINT64_MAX);
 	for (auto imageView : m_imageViews) {
 		vkDestroyImageView(m_device.getLogicalDevice(), imageView, nullptr);
 	}
+	m_imageViews.clear();
+	if (isOffscreen()) {
+		for (size_t i = 0; i < m_offscreenMemory.size(); i++) {
+			vkDestroyImage(m_device.getLogicalDevice(), m_images[i], nullptr);
+			m_device.getAllocator().free(m_offscreenMemory[i]);
+		}
+		m_offscreenMemory.clear();
+		m_images.clear();
+		return;
+	}
 	vkDestroySwapchainKHR(m_device.getLogicalDevice(), m_swapChain, nullptr);
+	m_swapChain = VK_NULL_HANDLE;
+}
+
+void WYVKSwapchain::recreate(uint64_t frameSerial)
+{
+	// m_swapChain is still the old handle while the new one is created, which makes it the oldSwapchain
+	m_retired.push_back({ frameSerial, m_swapChain, std::move(m_imageViews) });
+	m_imageViews.clear();
+	createSwapchain();
+	createImageViews();
+}
+
+void WYVKSwapchain::retire(uint64_t completedSerial)
+{
+	while (!m_retired.empty() && m_retired.front().frameSerial <= completedSerial) {
+		for (VkImageView imageView : m_retired.front().imageViews) {
+			vkDestroyImageView(m_device.getLogicalDevice(), imageView, nullptr);
+		}
+		vkDestroySwapchainKHR(m_device.getLogicalDevice(), m_retired.front().swapchain, nullptr);
+		m_retired.pop_front();
+	}
 }
 
 void WYVKSwapchain::validateSwapchainSupport()
 {
+	if (isOffscreen()) {
+		return;
+	}
 	WYVERN_ASSERT(!m_supportDetails.formats.empty() && !m_supportDetails.presentModes.empty(), "Swapchain is not suitable! There are no available formats or present modes!");
 }
 
 void WYVKSwapchain::createSwapchain()
 {
-	m_surface.querySupportDetails();
-	m_supportDetails = m_surface.getSupportDetails();
+	if (isOffscreen()) {
+		createOffscreenImages();
+		return;
+	}
+	m_surface->querySupportDetails();
+	m_supportDetails = m_surface->getSupportDetails();
 	// Choose support details from available support details queried in the constructor
 	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(m_supportDetails.formats);
 	VkPresentModeKHR presentMode = chooseSwapPresentMode(m_supportDetails.presentModes);
@@ -54,7 +93,7 @@ void WYVKSwapchain::createSwapchain()
 	// Im going to be creating the create info struct here because there's too many variables to pass into a function and we need control
 	VkSwapchainCreateInfoKHR createInfo {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	createInfo.surface = m_surface.getSurface();
+	createInfo.surface = m_surface->getSurface();
 	createInfo.minImageCount = imageCount;
 	createInfo.imageFormat = surfaceFormat.format;
 	createInfo.imageColorSpace = surfaceFormat.colorSpace;
@@ -83,9 +122,13 @@ void WYVKSwapchain::createSwapchain()
 	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; // Used for blending with other windows in the window system
 	createInfo.presentMode = presentMode;
 	createInfo.clipped = VK_TRUE; // Ignore the color of pixels that are obscured
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	// Lets the driver reuse the old swapchain's resources. Images of the old swapchain that are still queued for presentation are
+	// presented, but no new ones can be acquired from it
+	createInfo.oldSwapchain = m_swapChain;
 
-	VK_CALL(vkCreateSwapchainKHR(m_device.getLogicalDevice(), &createInfo, nullptr, &m_swapChain), "Unable to create Swapchain!");
+	VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+	VK_CALL(vkCreateSwapchainKHR(m_device.getLogicalDevice(), &createInfo, nullptr, &swapchain), "Unable to create Swapchain!");
+	m_swapChain = swapchain;
 
 	// Retrieve handles to swapchain images
 	vkGetSwapchainImagesKHR(m_device.getLogicalDevice(), m_swapChain, &imageCount, nullptr);
@@ -93,6 +136,37 @@ void WYVKSwapchain::createSwapchain()
 	vkGetSwapchainImagesKHR(m_device.getLogicalDevice(), m_swapChain, &imageCount, m_images.data());
 }
 
+void WYVKSwapchain::createOffscreenImages()
+{
+	m_format = OFFSCREEN_FORMAT;
+	m_extent = { static_cast<uint32_t>(m_window.getWidth()), static_cast<uint32_t>(m_window.getHeight()) };
+	WYVERN_LOG_INFO("Using offscreen images: {:d}, {:d}", m_extent.width, m_extent.height);
+
+	// Transfer source so frames can be read back
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = m_format;
+	imageInfo.extent = { m_extent.width, m_extent.height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	m_images.resize(OFFSCREEN_IMAGE_COUNT);
+	m_offscreenMemory.resize(OFFSCREEN_IMAGE_COUNT);
+	for (uint32_t i = 0; i < OFFSCREEN_IMAGE_COUNT; i++) {
+		VK_CALL(vkCreateImage(m_device.getLogicalDevice(), &imageInfo, nullptr, &m_images[i]), "Unable to create offscreen image!");
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(m_device.getLogicalDevice(), m_images[i], &requirements);
+		m_offscreenMemory[i] = m_device.getAllocator().allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, WYVKAllocator::ResourceKind::OPTIMAL);
+		VK_CALL(vkBindImageMemory(m_device.getLogicalDevice(), m_images[i], m_offscreenMemory[i].memory, m_offscreenMemory[i].offset), "Unable to bind offscreen image memory!");
+	}
+}
+
 void WYVKSwapchain::createImageViews()
 {
 	m_imageViews.resize(m_images.size());
@@ -180,12 +254,36 @@ VkSurfaceFormatKHR WYVKSwapchain::chooseSwapSurfaceFormat(const std::vector<VkSu
 */
 VkPresentModeKHR WYVKSwapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-	for (const auto& availablePresentMode : availablePresentModes) {
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) { // We want to use mailbox if its available
-			return availablePresentMode;
-		}
+	// FIFO is the only mode every device has to support
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	if (std::find(availablePresentModes.begin(), availablePresentModes.end(), m_preferredPresentMode) != availablePresentModes.end()) {
+		presentMode = m_preferredPresentMode;
+	}
+	else {
+		WYVERN_LOG_WARN("Present mode {} is not supported, falling back to {}", getPresentModeName(m_preferredPresentMode), getPresentModeName(presentMode));
+	}
+	if (presentMode != m_presentMode) {
+		WYVERN_LOG_INFO("Using present mode: {}", getPresentModeName(presentMode));
+	}
+	m_presentMode = presentMode;
+	return presentMode;
+}
+
+bool WYVKSwapchain::isPresentModeSupported(VkPresentModeKHR presentMode) const
+{
+	const std::vector<VkPresentModeKHR>& presentModes = m_supportDetails.presentModes;
+	return std::find(presentModes.begin(), presentModes.end(), presentMode) != presentModes.end();
+}
+
+const char* WYVKSwapchain::getPresentModeName(VkPresentModeKHR presentMode)
+{
+	switch (presentMode) {
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:		return "Immediate";
+	case VK_PRESENT_MODE_MAILBOX_KHR:		return "Mailbox";
+	case VK_PRESENT_MODE_FIFO_KHR:			return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:	return "FIFO relaxed";
+	default:								return "Unknown";
 	}
-	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
 /*
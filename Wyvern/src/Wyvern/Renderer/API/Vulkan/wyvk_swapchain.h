@@ -1,9 +1,12 @@
 #pragma once
-#include "Wyvern/core.h"
+#include <deque>
+
+#include "Wyvern/Core.h"
 #include "wyvk_instance.h"
 #include "wyvk_surface.h"
 #include "wyvk_device.h"
 #include "Memory/image.h"
+#include "Memory/wyvk_allocator.h"
 
 namespace Wyvern {
 
@@ -16,42 +19,83 @@ namespace Wyvern {
 * which can occur when a new frame is swapped in while the screen is in the middle of a refresh. 
 * By syncing the swapping with the screen's refresh rate, only whole frames are drawn.
 * 
+* Without a surface (headless) there is nothing to present to. OFFSCREEN_IMAGE_COUNT images with the window's size are created
+* instead, and the renderer picks them itself rather than acquiring & presenting them.
 */
 class WYVKSwapchain
 {
 public:
-    WYVKSwapchain(WYVKInstance& instance, WYVKDevice& device, WYVKSurface& surface, Window& window);
+    // Same format the surface path prefers, so offscreen frames look like presented ones
+    static constexpr VkFormat OFFSCREEN_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
+    static constexpr uint32_t OFFSCREEN_IMAGE_COUNT = 3;
+
+    // `surface` is nullptr for an offscreen swapchain
+    WYVKSwapchain(WYVKInstance& instance, WYVKDevice& device, WYVKSurface* surface, Window& window);
     ~WYVKSwapchain();
     void destroy();
 
     void validateSwapchainSupport();
     void createSwapchain();
     void createImageViews();
+
+    /*
+    * Creates a new swapchain for the current surface size and hands the current one over to it as oldSwapchain, so presentation
+    * continues without a gap. The old swapchain & image views stay alive until retire() is called with `frameSerial` or later
+    */
+    void recreate(uint64_t frameSerial);
+
+    /*
+    * Destroys the swapchains replaced up to `completedSerial`
+    */
+    void retire(uint64_t completedSerial);
     //void createFrameBuffers(VkRenderPass renderPass);
 
     inline VkSwapchainKHR getSwapchain() { return m_swapChain; }
+    inline bool isOffscreen() const { return m_surface == nullptr; }
     inline VkExtent2D& getExtent() { return m_extent; }
     inline VkFormat& getImageFormat() { return m_format; }
+    inline std::vector<VkImage>& getImages() { return m_images; }
     inline std::vector<VkImageView>& getImageViews() { return m_imageViews; }
     //inline auto& getFrameBuffers() { return m_swapChainFramebuffers; }
 
+    /*
+    * Present mode used from the next swapchain (re)creation on. Falls back to FIFO if the surface doesn't support it
+    */
+    inline void setPreferredPresentMode(VkPresentModeKHR presentMode) { m_preferredPresentMode = presentMode; }
+    inline VkPresentModeKHR getPreferredPresentMode() const { return m_preferredPresentMode; }
+    // Present mode of the current swapchain
+    inline VkPresentModeKHR getPresentMode() const { return m_presentMode; }
+    bool isPresentModeSupported(VkPresentModeKHR presentMode) const;
+    static const char* getPresentModeName(VkPresentModeKHR presentMode);
+
 private:
     // Basically chooses the best format, present mode, and extent from the available options retrieved from the GLFW window
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
+    void createOffscreenImages();
 
     VkSwapchainKHR m_swapChain = VK_NULL_HANDLE;
     WYVKSurface::SurfaceSupportDetails m_supportDetails;
     VkExtent2D m_extent;
     VkFormat m_format;
+    VkPresentModeKHR m_preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
 
     std::vector<VkImage> m_images; // Swapchain images will automatically be cleaned up when the swapchain is destroyed
     std::vector<VkImageView> m_imageViews;
+    std::vector<WYVKAllocator::Allocation> m_offscreenMemory; // Offscreen only, swapchain images are owned by the swapchain
+
+    struct RetiredSwapchain {
+        uint64_t frameSerial;                   // Last frame that could have used its images
+        VkSwapchainKHR swapchain;
+        std::vector<VkImageView> imageViews;
+    };
+    std::deque<RetiredSwapchain> m_retired;
 
     // Handles
     WYVKInstance& m_instance;
-    WYVKSurface& m_surface;
+    WYVKSurface* m_surface;
     WYVKDevice& m_device;  
     Window& m_window;
 };
@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "Wyvern/Core.h"
+
+namespace Wyvern {
+
+/*
+* Fixed size pool of worker threads that execute submitted jobs in FIFO order.
+* Used to spread CPU heavy work such as command buffer recording across cores.
+*/
+class ThreadPool
+{
+public:
+	/*
+	* Creates `threadCount` workers. 0 uses one worker per hardware thread, minus one for the main thread.
+	*/
+	ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	/*
+	* Queues `job` for execution on a worker and returns a future for its result
+	*/
+	template<typename Func>
+	auto submit(Func&& job) -> std::future<decltype(job())>
+	{
+		using Result = decltype(job());
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(job));
+		std::future<Result> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.emplace([task]() { (*task)(); });
+		}
+		m_condition.notify_one();
+		return result;
+	}
+
+	inline uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> m_workers;
+	std::queue<std::function<void()>> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stopping = false;
+};
+
+}
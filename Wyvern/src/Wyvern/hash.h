@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Wyvern {
+
+/*
+* 64 bit FNV-1a, used for cache keys (shader cache, pipeline registry, descriptor set cache, render graph). Keys only have to tell
+* entries apart, not resist tampering. Structs with padding (most Vulkan structs) have to be hashed field by field, hashing them
+* whole would hash garbage
+*
+*     uint64_t hash = FNV_OFFSET_BASIS;
+*     hashValue(hash, info.binding);
+*     hashBytes(hash, name.data(), name.size());
+*/
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+}
+
+template<typename T>
+inline void hashValue(uint64_t& hash, const T& value)
+{
+	hashBytes(hash, &value, sizeof(T));
+}
+
+}
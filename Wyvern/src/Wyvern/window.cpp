@@ -2,11 +2,16 @@
 
 namespace Wyvern {
 
-Window::Window(const char* title)
+Window::Window(const char* title, bool headless)
 {
     m_windowData.windowTitle = title;
     m_windowData.windowWidth = WINDOW_WIDTH;
     m_windowData.windowHeight = WINDOW_HEIGHT;
+    m_startTime = std::chrono::steady_clock::now();
+    if (headless) {
+        WYVERN_LOG_INFO("Running headless ({}x{})", WINDOW_WIDTH, WINDOW_HEIGHT);
+        return;
+    }
 
 	//WYVERN_LOG_INFO("Initializing Native window");
 	glfwInit();										// Initialize GLFW library
@@ -22,32 +27,75 @@ Window::Window(const char* title)
 
 Window::~Window()
 {
+    if (isHeadless()) {
+        return;
+    }
 	glfwDestroyWindow(m_nativeWindow);
 	glfwTerminate();
 }
 
 void Window::pollEvents()
 {
+    if (isHeadless()) {
+        return;
+    }
     glfwPollEvents();			// Poll for events e.g. Button presses, mouse movements, window close
 }
 
 void Window::updateDeltaTime()
 {
-    float currentFrame = static_cast<float>(glfwGetTime());
+    float currentFrame = isHeadless() ? std::chrono::duration<float>(std::chrono::steady_clock::now() - m_startTime).count()
+        : static_cast<float>(glfwGetTime());
     m_deltaTime = currentFrame - m_lastFrameTime;
     m_lastFrameTime = currentFrame;
 }
 
+bool Window::isMinimized() const
+{
+    if (isHeadless()) {
+        return false;
+    }
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(m_nativeWindow, &width, &height);
+    return width == 0 || height == 0 || glfwGetWindowAttrib(m_nativeWindow, GLFW_ICONIFIED);
+}
+
+void Window::waitEvents(double timeout)
+{
+    if (isHeadless()) {
+        return;
+    }
+    glfwWaitEventsTimeout(timeout);
+}
+
+void Window::requestClose()
+{
+    m_windowData.closeRequested = true;
+    if (!isHeadless()) {
+        glfwSetWindowShouldClose(m_nativeWindow, GLFW_TRUE);
+    }
+    // glfwSetWindowShouldClose() doesn't call the close callback, so the event is sent here for both
+    if (m_windowData.eventCallbackFn) {
+        WindowCloseEvent event;
+        m_windowData.eventCallbackFn(event);
+    }
+}
+
 void Window::framebufferResizeCallback(GLFWwindow* window, int width, int height)
 {
-	auto app = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-	app->m_framebufferResized = true;
+	// The user pointer is the window data (see the constructor), not the window
+	WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+	data.framebufferResized = true;
 }
 
 void Window::initCallbacks(const EventCallbackFn& callback)
 {
     // Add callback function to window data user pointer
     m_windowData.eventCallbackFn = callback;
+    if (isHeadless()) {
+        return;
+    }
 
     // Setup GLFW callbacks
     glfwSetWindowCloseCallback(m_nativeWindow, [](GLFWwindow* window)
@@ -113,6 +161,9 @@ void Window::initCallbacks(const EventCallbackFn& callback)
 
 int Window::shouldClose()
 {
+    if (isHeadless()) {
+        return m_windowData.closeRequested;
+    }
     return glfwWindowShouldClose(m_nativeWindow);
 }
 
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "core.h"
+#include "Core.h"
 #include "Wyvern/Events/application_event.h"
 #include "Wyvern/Events/key_event.h"
 #include "Wyvern/Events/mouse_event.h"
@@ -16,7 +16,11 @@ static const uint32_t WINDOW_HEIGHT = 1080;
 using EventCallbackFn = std::function<void(Event&)>;
 
 public:
-	Window(const char* title);
+	/*
+	* A headless window has no GLFW window behind it (GLFW isn't even initialized), so it works without a display server.
+	* It only keeps the size and time, events are never polled and it closes once requestClose() is called
+	*/
+	Window(const char* title, bool headless = false);
 	~Window();
 
 	void pollEvents();
@@ -24,10 +28,18 @@ public:
 	void initCallbacks(const EventCallbackFn& callback);
 	int shouldClose();
 
+	// nullptr for a headless window
 	inline GLFWwindow* getNativeWindow() const { return m_nativeWindow; }
+	inline bool isHeadless() const { return m_nativeWindow == nullptr; }
+	// Closes the window as if the user did. Headless windows send their WindowCloseEvent right away
+	void requestClose();
 	inline float deltaTime() const { return m_deltaTime; }
-	inline bool isFramebufferResized() const { return m_framebufferResized; }
-	void setFramebufferResized(bool flag) { m_framebufferResized = flag; }
+	inline bool isFramebufferResized() const { return m_windowData.framebufferResized; }
+	void setFramebufferResized(bool flag) { m_windowData.framebufferResized = flag; }
+	// True while the window is iconified or its framebuffer has no area. Nothing can be presented then
+	bool isMinimized() const;
+	// Sleeps until an event arrives or `timeout` seconds have passed
+	void waitEvents(double timeout);
 	static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 	int getWidth() { return m_windowData.windowWidth; }
 	int getHeight() { return m_windowData.windowHeight; }
@@ -39,11 +51,13 @@ private:
 		int windowWidth;
 		int windowHeight;
 		bool verticalSyncEnabled;
+		bool framebufferResized = false;
+		bool closeRequested = false;
 		EventCallbackFn eventCallbackFn;
 	};
 
-	bool m_framebufferResized = false;
-	GLFWwindow* m_nativeWindow;
+	GLFWwindow* m_nativeWindow = nullptr;
+	std::chrono::steady_clock::time_point m_startTime;	// Headless windows keep their own time
 	WindowData m_windowData;
 	float m_deltaTime = 0;
 	float m_lastFrameTime = 0;
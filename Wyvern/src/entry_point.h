@@ -1,9 +1,9 @@
 #pragma once
 
-extern Wyvern::Application* Wyvern::createApplication();
+extern Wyvern::Application* Wyvern::createApplication(int argc, char** argv);
 
-int main() {
-    auto app = Wyvern::createApplication();
+int main(int argc, char** argv) {
+    auto app = Wyvern::createApplication(argc, argv);
 
     try {
         app->run();